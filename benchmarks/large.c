@@ -40,6 +40,21 @@ void benchmarkLookupByName()
 	}
 }
 
+void benchmarkLookupByCascadingName()
+{
+	int i,j;
+	char name [KEY_NAME_LENGTH + 1];
+
+	for (i=0; i< NUM_DIR; i++)
+	{
+		for (j=0; j<NUM_KEY; j++)
+		{
+			snprintf (name, KEY_NAME_LENGTH, "%s/%s%d/%s%d", KEY_CASCADING_ROOT, "dir", i, "key", j);
+			ksLookupByName(large, name, 0);
+		}
+	}
+}
+
 void benchmarkReread()
 {
 	kdbGet(kdb, large, key);
@@ -77,6 +92,12 @@ int main()
 	benchmarkFillup();
 	timePrint ("New large keyset");
 
+	benchmarkLookupByName();
+	timePrint ("Lookup large keyset");
+
+	benchmarkLookupByCascadingName();
+	timePrint ("Lookup cascading");
+
 	benchmarkOpen();
 	keySetName(key, KEY_ROOT);
 	timePrint ("Opened key database");
@@ -0,0 +1,172 @@
+#include <benchmarks.h>
+
+#include <sys/time.h>
+
+#define NUM_LOOKUPS 1000000
+#define BATCH_SIZE 100
+
+static struct timeval begin;
+
+static void lookupTimeInit(void)
+{
+	gettimeofday (&begin, 0);
+}
+
+static void lookupTimePrint(const char *msg, size_t size)
+{
+	struct timeval measure;
+	double diff;
+
+	gettimeofday (&measure, 0);
+	diff = (measure.tv_sec - begin.tv_sec) * 1000000.0 + (measure.tv_usec - begin.tv_usec);
+
+	fprintf (stdout, "%30s %8zu keys: %12.0f Microseconds %12.0f Lookups/s\n",
+		msg, size, diff, NUM_LOOKUPS / diff * 1000000.0);
+}
+
+static KeySet *lookupCreate(size_t size, Key **lookups)
+{
+	char name [KEY_NAME_LENGTH + 1];
+	KeySet *ks = ksNew (size, KS_END);
+
+	for (size_t i=0; i<size; ++i)
+	{
+		snprintf (name, KEY_NAME_LENGTH, "%s/%s%zu/%s%zu", KEY_ROOT, "dir", i/100, "key", i%100);
+		elektraKsAppendUnsorted (ks, keyNew (name, KEY_VALUE, "data", KEY_END));
+	}
+	elektraKsSort (ks);
+
+	/* look up existing keys in a random order */
+	size_t r = 42;
+	for (size_t i=0; i<NUM_LOOKUPS; ++i)
+	{
+		r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+		size_t k = (r >> 17) % size;
+		snprintf (name, KEY_NAME_LENGTH, "%s/%s%zu/%s%zu", KEY_ROOT, "dir", k/100, "key", k%100);
+		lookups[i] = keyNew (name, KEY_END);
+	}
+
+	return ks;
+}
+
+/* look up the keys of one application per batch, in no particular order */
+static void lookupCreateBatches(size_t size, Key **lookups)
+{
+	char name [KEY_NAME_LENGTH + 1];
+
+	size_t r = 42;
+	for (size_t i=0; i<NUM_LOOKUPS; i+=BATCH_SIZE)
+	{
+		r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+		size_t base = (r >> 17) % (size - BATCH_SIZE);
+		for (size_t j=0; j<BATCH_SIZE; ++j)
+		{
+			size_t k = base + (j * 37) % BATCH_SIZE;
+			snprintf (name, KEY_NAME_LENGTH, "%s/%s%zu/%s%zu", KEY_ROOT, "dir", k/100, "key", k%100);
+			lookups[i+j] = keyNew (name, KEY_END);
+		}
+	}
+}
+
+static void benchmarkSearch(KeySet *ks, Key **lookups)
+{
+	for (size_t i=0; i<NUM_LOOKUPS; ++i)
+	{
+		if (ksSearchInternal (ks, lookups[i]) < 0) fprintf (stderr, "key not found\n");
+	}
+}
+
+static void benchmarkLookup(KeySet *ks, Key **lookups)
+{
+	for (size_t i=0; i<NUM_LOOKUPS; ++i)
+	{
+		if (!ksLookup (ks, lookups[i], 0)) fprintf (stderr, "key not found\n");
+	}
+}
+
+static void benchmarkLookupNoCase(KeySet *ks, Key **lookups)
+{
+	for (size_t i=0; i<NUM_LOOKUPS; ++i)
+	{
+		if (!ksLookup (ks, lookups[i], KDB_O_NOCASE)) fprintf (stderr, "key not found\n");
+	}
+}
+
+/* look up the names in batches, like applications do at startup,
+ * each batch in a keyset without a hash index */
+static void benchmarkLookupByName(KeySet *ks, const char **names)
+{
+	for (size_t i=0; i<NUM_LOOKUPS; ++i)
+	{
+		if (i % BATCH_SIZE == 0) ksClearHashIndex (ks);
+		if (!ksLookupByName (ks, names[i], 0)) fprintf (stderr, "key not found\n");
+	}
+}
+
+static void benchmarkLookupNames(KeySet *ks, const char **names, Key **found)
+{
+	for (size_t i=0; i<NUM_LOOKUPS; i+=BATCH_SIZE)
+	{
+		ksClearHashIndex (ks);
+		if (elektraKsLookupNames (ks, names+i, BATCH_SIZE, found) != BATCH_SIZE)
+		{
+			fprintf (stderr, "key not found\n");
+		}
+	}
+}
+
+int main()
+{
+	const size_t sizes[] = {10000, 100000, 1000000};
+	Key **lookups = elektraMalloc (sizeof (Key *) * NUM_LOOKUPS);
+	Key **found = elektraMalloc (sizeof (Key *) * BATCH_SIZE);
+	const char **names = elektraMalloc (sizeof (const char *) * NUM_LOOKUPS);
+
+	for (size_t s=0; s<sizeof(sizes)/sizeof(sizes[0]); ++s)
+	{
+		KeySet *ks = lookupCreate (sizes[s], lookups);
+
+		/* binary search comparing the keys */
+		clear_bit (ks->flags, KS_FLAG_SORTKEYS);
+		lookupTimeInit ();
+		benchmarkSearch (ks, lookups);
+		lookupTimePrint ("Binary search", sizes[s]);
+
+		/* binary search comparing the sort keys, the first
+		 * ksLookup() builds them */
+		ksLookup (ks, lookups[0], 0);
+		lookupTimeInit ();
+		benchmarkSearch (ks, lookups);
+		lookupTimePrint ("Binary search with sort keys", sizes[s]);
+
+		/* ksLookup() switches to the hash index on the way */
+		lookupTimeInit ();
+		benchmarkLookup (ks, lookups);
+		lookupTimePrint ("ksLookup", sizes[s]);
+
+		/* the second lookup builds the case-folded index */
+		lookupTimeInit ();
+		benchmarkLookupNoCase (ks, lookups);
+		lookupTimePrint ("ksLookup ignoring case", sizes[s]);
+
+		for (size_t i=0; i<NUM_LOOKUPS; ++i) keyDel (lookups[i]);
+		lookupCreateBatches (sizes[s], lookups);
+		for (size_t i=0; i<NUM_LOOKUPS; ++i) names[i] = keyName (lookups[i]);
+		lookupTimeInit ();
+		benchmarkLookupByName (ks, names);
+		lookupTimePrint ("ksLookupByName batches", sizes[s]);
+
+		lookupTimeInit ();
+		benchmarkLookupNames (ks, names, found);
+		lookupTimePrint ("elektraKsLookupNames batches", sizes[s]);
+
+		for (size_t i=0; i<NUM_LOOKUPS; ++i) keyDel (lookups[i]);
+		ksDel (ks);
+	}
+
+	elektraFree (names);
+	elektraFree (found);
+	elektraFree (lookups);
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+#include <benchmarks.h>
+
+#include <sys/time.h>
+
+#define NUM_KEYS 100000
+#define NUM_RUNS 10
+
+static struct timeval begin;
+
+static void splitTimeInit(void)
+{
+	gettimeofday (&begin, 0);
+}
+
+static void splitTimePrint(const char *msg, size_t size)
+{
+	struct timeval measure;
+	double diff;
+
+	gettimeofday (&measure, 0);
+	diff = (measure.tv_sec - begin.tv_sec) * 1000000.0 + (measure.tv_usec - begin.tv_usec);
+
+	fprintf (stdout, "%30s %8zu mountpoints: %12.0f Microseconds %12.0f Keys/s\n",
+		msg, size, diff, NUM_RUNS * NUM_KEYS / diff * 1000000.0);
+}
+
+static Backend *splitBackend(const char *name)
+{
+	Backend *backend = elektraCalloc (sizeof (Backend));
+	backend->mountpoint = keyNew (name, KEY_VALUE, name, KEY_END);
+	keyIncRef (backend->mountpoint);
+	return backend;
+}
+
+/* mount one application per mountpoint, the backends have no plugins */
+static KDB *splitCreate(size_t size)
+{
+	char name [KEY_NAME_LENGTH + 1];
+	KDB *handle = elektraCalloc (sizeof (struct _KDB));
+	handle->split = elektraSplitNew ();
+	handle->defaultBackend = splitBackend ("");
+	elektraMountBackend (handle, handle->defaultBackend, 0);
+
+	for (size_t i=0; i<size; ++i)
+	{
+		snprintf (name, KEY_NAME_LENGTH, "%s/%s%zu", KEY_ROOT, "app", i);
+		elektraMountBackend (handle, splitBackend (name), 0);
+	}
+
+	return handle;
+}
+
+static void splitClose(KDB *handle)
+{
+	elektraSplitDel (handle->split);
+	elektraTrieClose (handle->trie, 0);
+	elektraFree (handle);
+}
+
+/* every application has the same number of keys */
+static KeySet *splitCreateKeys(size_t size)
+{
+	char name [KEY_NAME_LENGTH + 1];
+	KeySet *ks = ksNew (NUM_KEYS, KS_END);
+
+	for (size_t i=0; i<NUM_KEYS; ++i)
+	{
+		snprintf (name, KEY_NAME_LENGTH, "%s/%s%zu/%s%zu", KEY_ROOT,
+				"app", i%size, "key", i/size);
+		elektraKsAppendUnsorted (ks, keyNew (name, KEY_VALUE, "data", KEY_END));
+	}
+	elektraKsSort (ks);
+
+	return ks;
+}
+
+static void benchmarkAppoint(KDB *handle, KeySet *ks)
+{
+	for (size_t i=0; i<NUM_RUNS; ++i)
+	{
+		Split *split = elektraSplitNew ();
+		elektraSplitBuildup (split, handle, 0);
+		if (elektraSplitAppoint (split, handle, ks) == -1) fprintf (stderr, "could not appoint\n");
+		elektraSplitDel (split);
+	}
+}
+
+static void benchmarkDivide(KDB *handle, KeySet *ks)
+{
+	for (size_t i=0; i<NUM_RUNS; ++i)
+	{
+		Split *split = elektraSplitNew ();
+		elektraSplitBuildup (split, handle, 0);
+		if (elektraSplitDivide (split, handle, ks) == -1) fprintf (stderr, "could not divide\n");
+		elektraSplitDel (split);
+	}
+}
+
+int main()
+{
+	const size_t sizes[] = {10, 1000, 10000};
+
+	for (size_t s=0; s<sizeof(sizes)/sizeof(sizes[0]); ++s)
+	{
+		KDB *handle = splitCreate (sizes[s]);
+		KeySet *ks = splitCreateKeys (sizes[s]);
+
+		splitTimeInit ();
+		benchmarkAppoint (handle, ks);
+		splitTimePrint ("elektraSplitAppoint", sizes[s]);
+
+		splitTimeInit ();
+		benchmarkDivide (handle, ks);
+		splitTimePrint ("elektraSplitDivide", sizes[s]);
+
+		ksDel (ks);
+		splitClose (handle);
+	}
+
+	return 0;
+}
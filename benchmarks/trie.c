@@ -0,0 +1,100 @@
+#include <benchmarks.h>
+
+#include <sys/time.h>
+
+#define NUM_LOOKUPS 1000000
+
+static struct timeval begin;
+
+static void trieTimeInit(void)
+{
+	gettimeofday (&begin, 0);
+}
+
+static void trieTimePrint(const char *msg, size_t size, size_t count)
+{
+	struct timeval measure;
+	double diff;
+
+	gettimeofday (&measure, 0);
+	diff = (measure.tv_sec - begin.tv_sec) * 1000000.0 + (measure.tv_usec - begin.tv_usec);
+
+	fprintf (stdout, "%30s %8zu mountpoints: %12.0f Microseconds %12.0f per second\n",
+		msg, size, diff, count / diff * 1000000.0);
+}
+
+static Trie *trieInsert(Trie *trie, const char *name)
+{
+	Backend *backend = elektraCalloc (sizeof (Backend));
+	backend->mountpoint = keyNew (name, KEY_VALUE, name, KEY_END);
+	backend->refcounter = 1;
+	keyIncRef (backend->mountpoint);
+	return elektraTrieInsert (trie, name, backend);
+}
+
+/* mount one application per mountpoint, like the splits of kdbGet() */
+static Trie *trieCreate(size_t size)
+{
+	char name [KEY_NAME_LENGTH + 1];
+	Trie *trie = trieInsert (0, "system/elektra/");
+
+	for (size_t i=0; i<size; ++i)
+	{
+		snprintf (name, KEY_NAME_LENGTH, "%s/%s%zu/", KEY_ROOT, "app", i);
+		trie = trieInsert (trie, name);
+	}
+
+	return trie;
+}
+
+/* look up keys below the mountpoints in a random order */
+static void trieCreateLookups(size_t size, Key **lookups)
+{
+	char name [KEY_NAME_LENGTH + 1];
+
+	size_t r = 42;
+	for (size_t i=0; i<NUM_LOOKUPS; ++i)
+	{
+		r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+		size_t k = (r >> 17) % size;
+		snprintf (name, KEY_NAME_LENGTH, "%s/%s%zu/%s%zu/%s%zu", KEY_ROOT,
+				"app", k, "dir", k%10, "key", i%100);
+		lookups[i] = keyNew (name, KEY_END);
+	}
+}
+
+static void benchmarkTrieLookup(Trie *trie, Key **lookups)
+{
+	for (size_t i=0; i<NUM_LOOKUPS; ++i)
+	{
+		if (!elektraTrieLookup (trie, lookups[i])) fprintf (stderr, "backend not found\n");
+	}
+}
+
+int main()
+{
+	const size_t sizes[] = {10, 1000, 10000};
+	Key **lookups = elektraMalloc (sizeof (Key *) * NUM_LOOKUPS);
+
+	for (size_t s=0; s<sizeof(sizes)/sizeof(sizes[0]); ++s)
+	{
+		trieTimeInit ();
+		Trie *trie = trieCreate (sizes[s]);
+		trieTimePrint ("Insert", sizes[s], sizes[s]);
+
+		trieCreateLookups (sizes[s], lookups);
+		trieTimeInit ();
+		benchmarkTrieLookup (trie, lookups);
+		trieTimePrint ("Lookup", sizes[s], NUM_LOOKUPS);
+
+		trieTimeInit ();
+		elektraTrieClose (trie, 0);
+		trieTimePrint ("Close", sizes[s], sizes[s]);
+
+		for (size_t i=0; i<NUM_LOOKUPS; ++i) keyDel (lookups[i]);
+	}
+
+	elektraFree (lookups);
+
+	return 0;
+}
@@ -32,6 +32,47 @@
     it says how much can actually be stored.*/
 #define KEYSET_SIZE 16
 
+/** The minimal size of a keyset before ksLookup() considers
+    to build a hash index for exact name lookups. */
+#define KEYSET_HASH_MIN_SIZE 64
+
+/** The hash index will be built when the binary searches done since
+    the index was dropped exceed 1/KEYSET_HASH_RATIO of the size, so that
+    rebuilding it never costs more than the searches it replaces. */
+#define KEYSET_HASH_RATIO 16
+
+/** The minimal size of a keyset before searches are bounded to the
+    range of a namespace. */
+#define KEYSET_RANGES_MIN_SIZE 64
+
+/** The minimal size of a keyset before binary searches compare the
+    sort keys kept next to the array instead of the keys. */
+#define KEYSET_SORTKEYS_MIN_SIZE 64
+
+/** The minimal size of a keyset before lookups with KDB_O_NOCASE
+    consider to build a case-folded index. */
+#define KEYSET_CASE_MIN_SIZE 64
+
+/** Number of namespaces with a range in a keyset:
+    cascading, dir, proc, spec, system and user */
+#define KEYSET_NAMESPACES 6
+
+/** The minimal size of a chunk of a key arena.
+    Allocations which do not fit get a chunk of their own size. */
+#define KEY_ARENA_CHUNK_SIZE 16384
+
+/** Size of the buffer on the stack for names of temporary keys,
+    see elektraArenaInitStack(). Longer names go to the heap. */
+#define KEY_STACK_ARENA_SIZE 512
+
+/** Values up to this size (including the null) are stored inside the key,
+    in place of the pointer for shared values. */
+#define KEY_INLINE_VALUE_SIZE 8
+
+/** Names and values of keys can have at most this size in bytes,
+    because their sizes are stored in kdb_unsigned_long_t. */
+#define KEY_MAX_BUFFER_SIZE 4294967295U
+
 /** How many plugins can exist in an backend. */
 #define NR_OF_PLUGINS 10
 
@@ -87,6 +128,7 @@ extern "C" {
 typedef struct _Trie	Trie;
 typedef struct _Split	Split;
 typedef struct _Backend	Backend;
+typedef struct _KeyArena	KeyArena;
 
 /* These define the type for pointers to all the kdb functions */
 typedef int (*kdbOpenPtr)(Plugin *, Key *errorKey);
@@ -139,12 +181,21 @@ typedef enum
 		to be changed. All attempts to change the value
 		will lead to an error.
 		Needed for meta keys*/
-	KEY_FLAG_RO_META=1<<3	/*!<
+	KEY_FLAG_RO_META=1<<3,	/*!<
 		Read only flag for meta.
 		Key meta is read only and not allowed
 		to be changed. All attempts to change the value
 		will lead to an error.
 		Needed for meta keys.*/
+	KEY_FLAG_ARENA_NAME=1<<4,	/*!<
+		The name buffer was allocated from
+		the arena of the key and must not be freed.*/
+	KEY_FLAG_ARENA_VALUE=1<<5,	/*!<
+		The value buffer was allocated from
+		the arena of the key and must not be freed.*/
+	KEY_FLAG_INLINE_VALUE=1<<6	/*!<
+		The value is stored in value.inlined
+		of the key itself and must not be freed.*/
 } keyflag_t;
 
 
@@ -158,14 +209,51 @@ typedef enum
  */
 typedef enum
 {
-	KS_FLAG_SYNC=1	/*!<
+	KS_FLAG_SYNC=1,	/*!<
 		KeySet need sync.
 		If keys were popped from the Keyset
 		this flag will be set, so that the backend will sync
 		the keys to database.*/
+	KS_FLAG_UNSORTED=1<<1,	/*!<
+		KeySet is not sorted.
+		Keys were appended out of order with
+		elektraKsAppendUnsorted(), starting at
+		unsortedBegin. elektraKsSort() will sort them.*/
+	KS_FLAG_ARENA=1<<2,	/*!<
+		KeySet allocates keys created with
+		elektraKsNewKey() from its arena.
+		The arena itself is only created on the first
+		such key.*/
+	KS_FLAG_RANGES=1<<3,	/*!<
+		The namespace ranges of the KeySet
+		are up to date.*/
+	KS_FLAG_FROZEN=1<<4,	/*!<
+		KeySet was frozen with elektraKsFreeze().
+		Its keys are read only and no keys can be
+		added or removed anymore.*/
+	KS_FLAG_SORTKEYS=1<<5	/*!<
+		The sort keys of the KeySet
+		are up to date.*/
 } ksflag_t;
 
 
+/**
+ * @internal
+ *
+ * Reference counter of a name or value buffer shared by keys.
+ *
+ * keyDup() and keyCopy() let the new key use the buffers of the
+ * source. A key which wants to change a shared buffer gets its own
+ * copy first, the last key using the buffer frees it.
+ */
+typedef struct _KeyShared
+{
+	size_t    references;	/**< Keys using the buffer */
+	size_t    size;	/**< Bytes of the buffer in use when it was shared */
+	KeyArena *arena;	/**< Arena of the buffer (referenced), or 0 for the heap */
+} KeyShared;
+
+
 /**
  * The private Key struct.
  *
@@ -189,29 +277,44 @@ struct _Key
 	 */
 	union {char* c; void * v;} data;
 
-	/**
-	 * Size of the value, in bytes, including ending NULL.
-	 * @see keyGetCommentSize(), keySetComment(), keyGetComment()
-	 */
-	size_t         dataSize;
-
 	/**
 	 * The name of the key.
 	 * @see keySetName(), keySetName()
 	 */
 	char *         key;
 
+	/**
+	 * Hash of the unescaped key name.
+	 * @see elektraKeyNameCache()
+	 */
+	kdb_unsigned_long_long_t nameHash;
+
+	/**
+	 * The first bytes of the unescaped key name, the first byte
+	 * being the most significant one, padded with zeros.
+	 * Names with different prefixes are ordered like their prefixes.
+	 * @see elektraKeyNameCache()
+	 */
+	kdb_unsigned_long_long_t namePrefix;
+
+	/**
+	 * Size of the value, in bytes, including ending NULL.
+	 * @see keyGetCommentSize(), keySetComment(), keyGetComment()
+	 * @see #KEY_MAX_BUFFER_SIZE
+	 */
+	kdb_unsigned_long_t dataSize;
+
 	/**
 	 * Size of the name, in bytes, including ending NULL.
 	 * @see keyGetName(), keyGetNameSize(), keySetName()
 	 */
-	size_t         keySize;
+	kdb_unsigned_long_t keySize;
 
 	/**
 	 * Size of the unescaped key name in bytes, including all NULL.
 	 * @see keyBaseName(), keyUnescapedName()
 	 */
-	size_t         keyUSize;
+	kdb_unsigned_long_t keyUSize;
 
 	/**
 	 * Some control and internal flags.
@@ -229,11 +332,143 @@ struct _Key
 	 * All the key's meta information.
 	 */
 	KeySet *      meta;
+
+	/* The fields above are needed by lookups and sorting,
+	   they fill the first cache line on 64 bit systems. */
+
+	/**
+	 * The arena the key was allocated from, or 0 if it
+	 * was allocated on the heap.
+	 * @see elektraKsNewKey()
+	 */
+	KeyArena *    arena;
+
+	/**
+	 * Set if the name buffer is shared with other keys.
+	 * @see keyDup(), keyCopy()
+	 */
+	KeyShared *   sharedName;
+
+	/**
+	 * Values stored inside the key are never shared, so they
+	 * use the same memory as the pointer for shared values.
+	 * @see #KEY_FLAG_INLINE_VALUE
+	 */
+	union
+	{
+		/** Set if the value buffer is shared with other keys,
+		    only valid without #KEY_FLAG_INLINE_VALUE.
+		    @see keyDup(), keyCopy() */
+		KeyShared *shared;
+		/** Storage for short values, so that they need no
+		    allocation of their own. */
+		char       inlined[KEY_INLINE_VALUE_SIZE];
+	} value;
+};
+
+
+/**
+ * @internal
+ *
+ * A chunk of memory of a KeyArena.
+ */
+typedef struct _KeyArenaChunk
+{
+	struct _KeyArenaChunk *next;	/**< Previously filled chunk */
+	size_t                 size;	/**< Usable bytes in this chunk */
+	size_t                 used;	/**< Bytes already handed out */
+} KeyArenaChunk;
+
+/**
+ * @internal
+ *
+ * Bump allocator for keys, their names and values.
+ *
+ * The arena is owned by a KeySet with #KS_FLAG_ARENA and by every
+ * key allocated from it. Memory is only given back in bulk, when
+ * the last of them is gone. Once the KeySet is deleted the arena is
+ * closed: keys which are still referenced elsewhere stay valid, but
+ * buffers they need from then on are allocated on the heap.
+ */
+struct _KeyArena
+{
+	KeyArenaChunk *chunks;	/**< Current chunk, older ones are linked */
+	size_t         references;	/**< Owning KeySet plus allocated keys */
+	int            closed;	/**< Owning KeySet is gone */
 };
 
 
 
 
+/**
+ * @internal
+ *
+ * A slot in the hash index of a KeySet.
+ *
+ * Open addressing with linear probing is used, a slot with
+ * pos 0 is empty.
+ */
+typedef struct _KeySetHashEntry
+{
+	kdb_unsigned_long_long_t hash;	/**< Hash of the unescaped name */
+	size_t                   pos;	/**< Position in the array plus one */
+} KeySetHashEntry;
+
+
+/**
+ * @internal
+ *
+ * Positions of the keys of one namespace in the array of a KeySet.
+ */
+typedef struct _KeySetRange
+{
+	size_t begin;	/**< First position of the namespace */
+	size_t end;	/**< Position after the last key of the namespace */
+} KeySetRange;
+
+
+/**
+ * @internal
+ *
+ * A key together with the eight bytes of its unescaped name after
+ * a prefix shared by all keys to sort, packed like Key::namePrefix.
+ *
+ * @see elektraKsLookupNames()
+ */
+typedef struct _KeySetSortEntry
+{
+	kdb_unsigned_long_long_t sortKey;	/**< Bytes of the name after the shared prefix */
+	struct _Key             *key;	/**< The key to sort */
+} KeySetSortEntry;
+
+
+/**
+ * @internal
+ *
+ * An entry of the case-folded index of a KeySet.
+ *
+ * The entries are sorted by the unescaped names of their keys,
+ * compared ignoring case, and then by position.
+ */
+typedef struct _KeySetCaseEntry
+{
+	kdb_unsigned_long_long_t prefix;	/**< Eight bytes of the unescaped name after KeySet::caseOffset in upper case, packed like Key::namePrefix */
+	size_t                   pos;	/**< Position in the array */
+} KeySetCaseEntry;
+
+
+/**
+ * @internal
+ *
+ * An entry of the tree index of a KeySet, for every position.
+ */
+typedef struct _KeySetTreeEntry
+{
+	size_t end;	/**< Position after the last key below this one */
+	size_t level;	/**< Number of parts of the unescaped name */
+} KeySetTreeEntry;
+
+
 /**
  * The private KeySet structure.
  *
@@ -261,6 +496,61 @@ struct _KeySet
 	 * Some control and internal flags.
 	 */
 	ksflag_t      flags;
+
+	/**
+	 * Lazily built index from unescaped names to positions in array.
+	 * Appending at the end and popping keep it up to date, every other
+	 * change of positions drops it.
+	 * @see ksLookup(), ksClearIndex()
+	 */
+	KeySetHashEntry *hashTable;
+	size_t        hashAlloc;	/**< Number of slots in hashTable, power of two or 0 */
+	size_t        hashMisses;	/**< Binary searches since hashTable was dropped */
+
+	size_t        unsortedBegin;	/**< First position not sorted, only valid with #KS_FLAG_UNSORTED */
+
+	KeyArena     *arena;	/**< Arena for elektraKsNewKey(), only with #KS_FLAG_ARENA */
+
+	/**
+	 * Lazily computed ranges of the namespaces in array, in the order
+	 * the namespaces are sorted in. Inserting and popping single keys
+	 * keep them up to date, every other change of positions drops them.
+	 * Only valid with #KS_FLAG_RANGES.
+	 * @see ksLookup(), ksCut()
+	 */
+	KeySetRange   nsRanges[KEYSET_NAMESPACES];
+
+	/**
+	 * Lazily computed sort keys, one for every position in array:
+	 * the eight bytes of the unescaped name which follow the first
+	 * sortOffset bytes all names share, packed like Key::namePrefix.
+	 * Binary searches only look at a key if its sort key is equal to
+	 * the one searched for. Inserting and popping single keys keep
+	 * them up to date, every other change of positions drops them.
+	 * Only valid with #KS_FLAG_SORTKEYS.
+	 * @see ksSearchInternal(), ksLookup()
+	 */
+	kdb_unsigned_long_long_t *sortKeys;
+	size_t        sortAlloc;	/**< Number of allocated sortKeys */
+	size_t        sortOffset;	/**< Length of the name prefix all keys share */
+
+	/**
+	 * Lazily built index of all positions in array, sorted by name
+	 * ignoring case, for lookups with KDB_O_NOCASE.
+	 * Every change of positions drops it.
+	 * @see ksLookup()
+	 */
+	KeySetCaseEntry *caseIndex;
+	size_t        caseScans;	/**< Linear scans ignoring case since caseIndex was dropped */
+	size_t        caseOffset;	/**< Length of the name prefix all keys share ignoring case */
+
+	/**
+	 * Lazily built skip structure of the hierarchy in array: for
+	 * every position where the keys below it end and the level of
+	 * its name. Every change of positions drops it.
+	 * @see elektraKsFirstChild(), elektraKsNextInTree()
+	 */
+	KeySetTreeEntry *treeIndex;
 };
 
 
@@ -291,6 +581,13 @@ struct _KDB {
 	KeySet *modules;	/*!< A list of all modules loaded at the moment.*/
 
 	Backend *defaultBackend;/*!< The default backend as fallback when nothing else is found.*/
+
+	size_t workers;		/*!< The number of threads running backends
+				 concurrently, 0 or 1 for no threads at all.
+				 @see elektraKdbSetWorkers() */
+
+	int arena;		/*!< Whether storage plugins create keys in an arena.
+				 @see elektraKdbSetArena() */
 };
 
 
@@ -389,14 +686,26 @@ struct _Plugin
  * fast. This is exactly what needs to be done when using kdbGet() and kdbSet()
  * in a hierarchy where backends are mounted - you need the backend mounted
  * closest to the parentKey.
+ *
+ * It is a radix trie: every node only has as many children as needed and
+ * chains of nodes with a single child are compressed into the text of one
+ * node.
  */
 struct _Trie
 {
-	struct _Trie *children[KDB_MAX_UCHAR];/*!< The children building up the trie recursively */
-	char *text[KDB_MAX_UCHAR];	/*!< Text identifying this node */
-	size_t textlen[KDB_MAX_UCHAR];	/*!< Length of the text */
-	Backend *value[KDB_MAX_UCHAR];	/*!< Pointer to a backend */
-	Backend *empty_value;		/*!< Pointer to a backend for the empty string "" */
+	struct _Trie **children;	/*!< The children building up the trie recursively,
+		sorted by the first character of their text */
+	unsigned char *firsts;		/*!< The first characters of the texts of the
+		children, allocated together with children */
+	size_t size;			/*!< Number of children */
+	char *text;			/*!< Text on the edge from the parent to this node,
+		allocated together with the node */
+	size_t textlen;			/*!< Length of the text */
+	Backend *value;			/*!< Pointer to the backend mounted at the texts
+		of all nodes up to this one */
+	Backend **shadowed;		/*!< Backends mounted here before value, only
+		kept to be closed */
+	size_t nrShadowed;		/*!< Number of shadowed backends */
 };
 
 typedef enum
@@ -458,6 +767,7 @@ void elektraSplitOpen(Split *split);
 int elektraSplitAppoint (Split *split, KDB *handle, KeySet *ks);
 int elektraSplitGet (Split *split, Key *warningKey, KDB *handle);
 int elektraSplitMerge (Split *split, KeySet *dest);
+int elektraSplitMergeUpdated (Split *split, KDB *handle, KeySet *dest);
 
 /* for kdbSet() algorithm */
 int elektraSplitCheckSize (Split *split);
@@ -502,6 +812,10 @@ int elektraMountVersion (KDB *kdb, Key *errorKey);
 
 int elektraMountBackend (KDB *kdb, Backend *backend, Key *errorKey);
 
+/*Running backends in worker threads*/
+void elektraParallelRun(size_t workers, size_t jobs,
+	void (*run)(void *data, size_t job), void *data);
+
 Key* elektraMountGetMountpoint(KDB *handle, const Key *where);
 Backend* elektraMountGetBackend(KDB *handle, const Key *key);
 
@@ -513,15 +827,45 @@ void keyVInit(Key *key, const char *keyname, va_list ap);
 
 int keyClearSync (Key *key);
 
+/*Private helper for key arenas*/
+KeyArena *elektraArenaNew(void);
+size_t elektraArenaBlockSize(size_t size);
+int elektraArenaReserve(KeyArena *arena, size_t size);
+void *elektraArenaMalloc(KeyArena *arena, size_t size);
+int elektraArenaRealloc(KeyArena *arena, void **buffer, size_t size);
+void elektraArenaIncRef(KeyArena *arena);
+void elektraArenaDecRef(KeyArena *arena);
+void elektraArenaClose(KeyArena *arena);
+void elektraArenaInitStack(KeyArena *arena, void *buffer, size_t size);
+void elektraArenaFreeStack(KeyArena *arena, void *buffer);
+
+void *elektraKeyMallocBuffer(Key *key, size_t size, keyflag_t arenaFlag);
+int elektraKeyReallocBuffer(Key *key, void **buffer, size_t size, keyflag_t arenaFlag);
+void elektraKeyFreeBuffer(Key *key, void *buffer, keyflag_t arenaFlag);
+int elektraKeyIsReadOnly(const Key *key);
+int elektraKeyPrepareShare(Key *source);
+void elektraKeyShareBuffers(Key *dest, const Key *source);
+int elektraKeyCopyBuffers(const Key *source, char **name, void **value);
+void elektraKeyUseBuffers(Key *dest, const Key *source, char *name, void *value);
+int elektraKeyUnshareName(Key *key);
+
 /*Private helper for keyset*/
 int ksInit(KeySet *ks);
 int ksClose(KeySet *ks);
 
 int ksResize(KeySet *ks, size_t size);
+void ksClearIndex(KeySet *ks);
+void ksClearHashIndex(KeySet *ks);
 size_t ksGetAlloc(const KeySet *ks);
 KeySet* ksDeepDup(const KeySet *source);
 
 ssize_t ksSearchInternal(const KeySet *ks, const Key *toAppend);
+ssize_t elektraKsAppendRange(KeySet *ks, const KeySet *source,
+	size_t begin, size_t end);
+ssize_t elektraKsRemoveMarked(KeySet *ks, const char *marks);
+kdb_unsigned_long_long_t elektraKsHashValue(const char *value, size_t size);
+int elektraKsUnshareMeta(KeySet *ks);
+const Key *elektraKeyGetMetaConst(const Key *key, const char *metaName);
 
 /*Used for internal memcpy/memmove*/
 ssize_t elektraMemcpy (Key** array1, Key** array2, size_t size);
@@ -529,6 +873,7 @@ ssize_t elektraMemmove (Key** array1, Key** array2, size_t size);
 
 char *elektraStrNDup (const char *s, size_t l);
 ssize_t elektraFinalizeName(Key *key);
+void elektraKeyNameCache(Key *key);
 ssize_t elektraFinalizeEmptyName(Key *key);
 
 char *elektraEscapeKeyNamePart(const char *source, char *dest);
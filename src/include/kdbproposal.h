@@ -102,11 +102,45 @@ ssize_t elektraKeySetName(Key *key, const char *newName,
 
 KeySet *elektraArrayGet(const Key *arrayParent, KeySet *keys);
 Key *elektraArrayGetNextKey(KeySet *arrayKeys);
+ssize_t elektraArrayGetRange(KeySet *keys, const Key *arrayParent,
+	cursor_t *begin, cursor_t *end);
+Key *elektraArrayAppend(KeySet *keys, const Key *arrayParent,
+	ssize_t *nextIndex);
 
 KeySet *elektraKeyGetMetaKeySet(const Key *key);
+ssize_t elektraKsShareMeta(KeySet *ks);
 
 Key *ksPrev(KeySet *ks);
 Key *ksPopAtCursor(KeySet *ks, cursor_t c);
+ssize_t elektraKsBelow(KeySet *ks, const Key *parent,
+	cursor_t *begin, cursor_t *end);
+cursor_t elektraKsFirstChild(KeySet *ks, const Key *parent, cursor_t *end);
+cursor_t elektraKsNextChild(KeySet *ks, cursor_t child, cursor_t end);
+cursor_t elektraKsSubtreeEnd(KeySet *ks, cursor_t pos);
+Key *elektraKsNextInTree(KeySet *ks, cursor_t *it, cursor_t end, size_t *level);
+
+ssize_t elektraKsAppendUnsorted(KeySet *ks, Key *toAppend);
+ssize_t elektraKsSort(KeySet *ks);
+
+int elektraKsEnableArena(KeySet *ks);
+int elektraKsFreeze(KeySet *ks);
+Key *elektraKsNewKey(KeySet *ks, const char *name, ...);
+
+const Key *elektraKsLookupConst(const KeySet *ks, const Key *key, option_t options);
+const Key *elektraKsLookupByNameConst(const KeySet *ks, const char *name,
+	option_t options);
+
+ssize_t elektraKsLookupKeys(KeySet *ks, KeySet *wanted, Key **found);
+ssize_t elektraKsLookupNames(KeySet *ks, const char **names, size_t count,
+	Key **found);
+
+int elektraKdbSetWorkers(KDB *handle, size_t workers);
+int elektraKdbSetArena(KDB *handle, int arena);
+
+// reverse lookups, which key has this value?
+Key *ksLookupByString(KeySet *ks, const char *value, option_t options);
+Key *ksLookupByBinary(KeySet *ks, const void *value, size_t size,
+	option_t options);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,638 @@
+/**
+ * \file
+ *
+ * \brief Arena allocation, sharing and inline storage of keys, their names and values.
+ *
+ * \copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ *
+ */
+
+#include <string.h>
+
+#include <kdbprivate.h>
+
+/**
+ * @internal
+ *
+ * Alignment of every block handed out by an arena, also the size of
+ * the header which stores the capacity of the block.
+ */
+#define ELEKTRA_ARENA_ALIGN (2*sizeof(size_t))
+
+static size_t elektraArenaAlign(size_t size)
+{
+	return (size + ELEKTRA_ARENA_ALIGN - 1) & ~(ELEKTRA_ARENA_ALIGN - 1);
+}
+
+static char *elektraArenaChunkData(KeyArenaChunk *chunk)
+{
+	return (char*)chunk + elektraArenaAlign(sizeof(KeyArenaChunk));
+}
+
+static size_t *elektraArenaCapacity(void *buffer)
+{
+	return (size_t*)((char*)buffer - ELEKTRA_ARENA_ALIGN);
+}
+
+/**
+ * @internal
+ *
+ * Creates a new, empty arena.
+ *
+ * The caller holds the only reference, see elektraArenaClose().
+ *
+ * @return the new arena or 0 on memory error
+ */
+KeyArena *elektraArenaNew(void)
+{
+	KeyArena *arena = elektraCalloc(sizeof(KeyArena));
+	if (!arena) return 0;
+
+	arena->references = 1;
+
+	return arena;
+}
+
+/**
+ * @internal
+ *
+ * Adds a chunk with at least @p needed bytes.
+ *
+ * Oversized chunks are linked behind the current one, so that
+ * the space left in the current chunk is not wasted.
+ */
+static KeyArenaChunk *elektraArenaAddChunk(KeyArena *arena, size_t needed)
+{
+	const size_t size = needed > KEY_ARENA_CHUNK_SIZE ? needed : KEY_ARENA_CHUNK_SIZE;
+	KeyArenaChunk *chunk = elektraMalloc(elektraArenaAlign(sizeof(KeyArenaChunk)) + size);
+	if (!chunk) return 0;
+
+	chunk->size = size;
+	chunk->used = 0;
+
+	if (arena->chunks && size > KEY_ARENA_CHUNK_SIZE)
+	{
+		chunk->next = arena->chunks->next;
+		arena->chunks->next = chunk;
+	}
+	else
+	{
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+	}
+
+	return chunk;
+}
+
+/**
+ * @internal
+ *
+ * @return the space a block of @p size bytes takes in an arena
+ */
+size_t elektraArenaBlockSize(size_t size)
+{
+	return ELEKTRA_ARENA_ALIGN + elektraArenaAlign(size);
+}
+
+/**
+ * @internal
+ *
+ * Makes sure that the next blocks, which take together @p size bytes
+ * (see elektraArenaBlockSize()), are allocated one after the other
+ * in the same chunk.
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+int elektraArenaReserve(KeyArena *arena, size_t size)
+{
+	KeyArenaChunk *chunk = arena->chunks;
+	if (chunk && chunk->size - chunk->used >= size) return 0;
+
+	chunk = elektraArenaAddChunk(arena, size);
+	if (!chunk) return -1;
+
+	if (arena->chunks != chunk)
+	{
+		// oversized chunks are linked behind, but this one is needed now
+		arena->chunks->next = chunk->next;
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Allocates @p size bytes from the arena.
+ *
+ * The memory is aligned like memory from malloc() and is only given
+ * back when the arena is freed.
+ *
+ * @return the memory or 0 on memory error
+ */
+void *elektraArenaMalloc(KeyArena *arena, size_t size)
+{
+	const size_t needed = elektraArenaBlockSize(size);
+	KeyArenaChunk *chunk = arena->chunks;
+
+	if (!chunk || chunk->size - chunk->used < needed)
+	{
+		chunk = elektraArenaAddChunk(arena, needed);
+		if (!chunk) return 0;
+	}
+
+	char *block = elektraArenaChunkData(chunk) + chunk->used;
+	chunk->used += needed;
+
+	void *buffer = block + ELEKTRA_ARENA_ALIGN;
+	*elektraArenaCapacity(buffer) = needed - ELEKTRA_ARENA_ALIGN;
+
+	return buffer;
+}
+
+/**
+ * @internal
+ *
+ * Resizes a block allocated by elektraArenaMalloc().
+ *
+ * The last block of the current chunk grows in place, otherwise
+ * the content is copied to a new block.
+ *
+ * @param buffer pointer to the block, will be updated if it moved
+ * @retval 0 on success
+ * @retval -1 on memory error, the block is unchanged then
+ */
+int elektraArenaRealloc(KeyArena *arena, void **buffer, size_t size)
+{
+	size_t *capacity = elektraArenaCapacity(*buffer);
+	if (size <= *capacity) return 0;
+
+	const size_t grow = elektraArenaAlign(size) - *capacity;
+	KeyArenaChunk *chunk = arena->chunks;
+	if ((char*)*buffer + *capacity == elektraArenaChunkData(chunk) + chunk->used
+		&& chunk->size - chunk->used >= grow)
+	{
+		chunk->used += grow;
+		*capacity += grow;
+		return 0;
+	}
+
+	void *moved = elektraArenaMalloc(arena, size);
+	if (!moved) return -1;
+
+	memcpy(moved, *buffer, *capacity);
+	*buffer = moved;
+
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * A key allocated from the arena holds a reference to it.
+ *
+ * The counters of arenas and shared buffers are atomic: keys of
+ * different backends may share them while kdbSet() serializes the
+ * backends in worker threads.
+ */
+void elektraArenaIncRef(KeyArena *arena)
+{
+	__sync_add_and_fetch(&arena->references, 1);
+}
+
+/**
+ * @internal
+ *
+ * Drops a reference, frees all chunks at once with the last one.
+ */
+void elektraArenaDecRef(KeyArena *arena)
+{
+	if (__sync_sub_and_fetch(&arena->references, 1) > 0) return;
+
+	KeyArenaChunk *chunk = arena->chunks;
+	while (chunk)
+	{
+		KeyArenaChunk *next = chunk->next;
+		elektraFree(chunk);
+		chunk = next;
+	}
+	elektraFree(arena);
+}
+
+/**
+ * @internal
+ *
+ * Drops the reference of the owner.
+ *
+ * Keys still alive keep the arena, but do not allocate from it anymore.
+ */
+void elektraArenaClose(KeyArena *arena)
+{
+	arena->closed = 1;
+	elektraArenaDecRef(arena);
+}
+
+/**
+ * @internal
+ *
+ * Initializes an arena whose first chunk is @p buffer, usually on
+ * the stack, so that a temporary key gets its name without any
+ * allocation. What does not fit goes to chunks on the heap.
+ *
+ * Buffers of keys in such an arena must never be shared, and the
+ * arena must be freed with elektraArenaFreeStack().
+ *
+ * @param buffer memory aligned for a size_t
+ * @param size the bytes of @p buffer
+ */
+void elektraArenaInitStack(KeyArena *arena, void *buffer, size_t size)
+{
+	KeyArenaChunk *chunk = buffer;
+	chunk->next = 0;
+	chunk->size = size - elektraArenaAlign(sizeof(KeyArenaChunk));
+	chunk->used = 0;
+
+	arena->chunks = chunk;
+	arena->references = 1;
+	arena->closed = 0;
+}
+
+/**
+ * @internal
+ *
+ * Frees the chunks of an arena from elektraArenaInitStack(), all
+ * but @p buffer.
+ */
+void elektraArenaFreeStack(KeyArena *arena, void *buffer)
+{
+	KeyArenaChunk *chunk = arena->chunks;
+	while (chunk)
+	{
+		KeyArenaChunk *next = chunk->next;
+		if (chunk != buffer) elektraFree(chunk);
+		chunk = next;
+	}
+}
+
+static KeyShared **elektraKeySharedSlot(Key *key, keyflag_t arenaFlag)
+{
+	return arenaFlag == KEY_FLAG_ARENA_NAME ? &key->sharedName : &key->value.shared;
+}
+
+/**
+ * @internal
+ *
+ * Drops a reference to a shared buffer, frees it with the last one.
+ */
+static void elektraKeySharedDecRef(KeyShared *shared, void *buffer)
+{
+	if (__sync_sub_and_fetch(&shared->references, 1) > 0) return;
+
+	if (shared->arena) elektraArenaDecRef(shared->arena);
+	else elektraFree(buffer);
+	elektraFree(shared);
+}
+
+/**
+ * @internal
+ *
+ * Makes the buffer of @p key shareable, the key holds the first
+ * reference then. A buffer in an arena keeps the arena alive.
+ */
+static KeyShared *elektraKeySharedNew(Key *key, keyflag_t arenaFlag, size_t size)
+{
+	KeyShared *shared = elektraMalloc(sizeof(KeyShared));
+	if (!shared) return 0;
+
+	shared->references = 1;
+	shared->size = size;
+	shared->arena = 0;
+	if (test_bit(key->flags, arenaFlag))
+	{
+		shared->arena = key->arena;
+		elektraArenaIncRef(shared->arena);
+		clear_bit(key->flags, arenaFlag);
+	}
+
+	return shared;
+}
+
+/**
+ * @internal
+ *
+ * Allocates a name or value buffer for a key.
+ *
+ * Short values are stored inside the key. Otherwise the buffer is
+ * taken from the arena of the key, if it has an open one, and from
+ * the heap. The previous buffer must have been released with
+ * elektraKeyFreeBuffer() before.
+ *
+ * @param arenaFlag #KEY_FLAG_ARENA_NAME or #KEY_FLAG_ARENA_VALUE
+ * @return the buffer or 0 on memory error
+ * @retval 0 if @p size is larger than #KEY_MAX_BUFFER_SIZE
+ */
+void *elektraKeyMallocBuffer(Key *key, size_t size, keyflag_t arenaFlag)
+{
+	if (size > KEY_MAX_BUFFER_SIZE) return 0;
+
+	if (arenaFlag == KEY_FLAG_ARENA_VALUE && size <= KEY_INLINE_VALUE_SIZE)
+	{
+		clear_bit(key->flags, arenaFlag);
+		set_bit(key->flags, KEY_FLAG_INLINE_VALUE);
+		return key->value.inlined;
+	}
+
+	if (key->arena && !key->arena->closed)
+	{
+		void *buffer = elektraArenaMalloc(key->arena, size);
+		if (buffer) set_bit(key->flags, arenaFlag);
+		return buffer;
+	}
+
+	clear_bit(key->flags, arenaFlag);
+	return elektraMalloc(size);
+}
+
+/**
+ * @internal
+ *
+ * Resizes a name or value buffer of a key, like elektraRealloc().
+ *
+ * A shared buffer is copied, the copy is not shared anymore.
+ * A buffer in a closed arena is copied out to the heap.
+ * Values move out of the key when they grow too large for it,
+ * and back in when they shrink.
+ *
+ * @param buffer pointer to the buffer, will be updated if it moved
+ * @param arenaFlag #KEY_FLAG_ARENA_NAME or #KEY_FLAG_ARENA_VALUE
+ * @retval 0 on success
+ * @retval -1 on memory error or if @p size is larger than
+ *         #KEY_MAX_BUFFER_SIZE, the buffer is unchanged then
+ */
+int elektraKeyReallocBuffer(Key *key, void **buffer, size_t size, keyflag_t arenaFlag)
+{
+	if (size > KEY_MAX_BUFFER_SIZE) return -1;
+
+	if (!*buffer)
+	{
+		*buffer = elektraKeyMallocBuffer(key, size, arenaFlag);
+		return *buffer ? 0 : -1;
+	}
+
+	if (arenaFlag == KEY_FLAG_ARENA_VALUE && test_bit(key->flags, KEY_FLAG_INLINE_VALUE))
+	{
+		if (size <= KEY_INLINE_VALUE_SIZE) return 0;
+
+		clear_bit(key->flags, KEY_FLAG_INLINE_VALUE);
+		void *moved = elektraKeyMallocBuffer(key, size, arenaFlag);
+		if (!moved)
+		{
+			set_bit(key->flags, KEY_FLAG_INLINE_VALUE);
+			return -1;
+		}
+
+		memcpy(moved, *buffer, KEY_INLINE_VALUE_SIZE);
+		key->value.shared = 0;
+		*buffer = moved;
+		return 0;
+	}
+
+	KeyShared **shared = elektraKeySharedSlot(key, arenaFlag);
+	if (*shared)
+	{
+		// a short copy is stored in value.inlined, over value.shared
+		KeyShared *old = *shared;
+		*shared = 0;
+		void *copy = elektraKeyMallocBuffer(key, size, arenaFlag);
+		if (!copy)
+		{
+			*shared = old;
+			return -1;
+		}
+
+		memcpy(copy, *buffer, old->size < size ? old->size : size);
+		elektraKeySharedDecRef(old, *buffer);
+		*buffer = copy;
+		return 0;
+	}
+
+	// value buffers outside the key are larger than value.inlined
+	if (arenaFlag == KEY_FLAG_ARENA_VALUE && size <= KEY_INLINE_VALUE_SIZE)
+	{
+		char inlined[KEY_INLINE_VALUE_SIZE];
+		memcpy(inlined, *buffer, size);
+		elektraKeyFreeBuffer(key, *buffer, arenaFlag);
+		memcpy(key->value.inlined, inlined, size);
+		set_bit(key->flags, KEY_FLAG_INLINE_VALUE);
+		*buffer = key->value.inlined;
+		return 0;
+	}
+
+	if (!test_bit(key->flags, arenaFlag)) return elektraRealloc(buffer, size);
+
+	if (!key->arena->closed) return elektraArenaRealloc(key->arena, buffer, size);
+
+	void *moved = elektraMalloc(size);
+	if (!moved) return -1;
+
+	const size_t capacity = *elektraArenaCapacity(*buffer);
+	memcpy(moved, *buffer, capacity < size ? capacity : size);
+	*buffer = moved;
+	clear_bit(key->flags, arenaFlag);
+
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Releases a name or value buffer of a key.
+ *
+ * Buffers in the arena are left there, they are freed in bulk.
+ * Shared buffers are only freed by the last key using them.
+ *
+ * @param arenaFlag #KEY_FLAG_ARENA_NAME or #KEY_FLAG_ARENA_VALUE
+ */
+void elektraKeyFreeBuffer(Key *key, void *buffer, keyflag_t arenaFlag)
+{
+	if (arenaFlag == KEY_FLAG_ARENA_VALUE && test_bit(key->flags, KEY_FLAG_INLINE_VALUE))
+	{
+		clear_bit(key->flags, KEY_FLAG_INLINE_VALUE);
+		key->value.shared = 0;
+		return;
+	}
+
+	KeyShared **shared = elektraKeySharedSlot(key, arenaFlag);
+	if (*shared)
+	{
+		elektraKeySharedDecRef(*shared, buffer);
+		*shared = 0;
+		return;
+	}
+
+	if (test_bit(key->flags, arenaFlag))
+	{
+		clear_bit(key->flags, arenaFlag);
+		return;
+	}
+
+	elektraFree(buffer);
+}
+
+/**
+ * @internal
+ *
+ * Name, value and meta data of read only keys, e.g. the keys of a
+ * frozen KeySet, cannot change. Such keys may be read by several
+ * threads at once, so copying them must not change them either,
+ * not even to prepare their buffers for sharing.
+ *
+ * @retval 1 if name, value and meta data of @p key are locked
+ * @retval 0 otherwise
+ * @see keyLock()
+ */
+int elektraKeyIsReadOnly(const Key *key)
+{
+	const keyflag_t readOnly = KEY_FLAG_RO_NAME | KEY_FLAG_RO_VALUE | KEY_FLAG_RO_META;
+	return (key->flags & readOnly) == readOnly;
+}
+
+/**
+ * @internal
+ *
+ * Prepares the name and value buffer of @p source to be shared
+ * with elektraKeyShareBuffers().
+ *
+ * Values stored inside the key are copied instead.
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error, nothing will be shared then
+ */
+int elektraKeyPrepareShare(Key *source)
+{
+	if (source->key && !source->sharedName)
+	{
+		source->sharedName = elektraKeySharedNew(source,
+			KEY_FLAG_ARENA_NAME, source->keySize + source->keyUSize);
+		if (!source->sharedName) return -1;
+	}
+
+	if (source->data.v && !test_bit(source->flags, KEY_FLAG_INLINE_VALUE)
+		&& !source->value.shared)
+	{
+		source->value.shared = elektraKeySharedNew(source,
+			KEY_FLAG_ARENA_VALUE, source->dataSize);
+		if (!source->value.shared) return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Lets @p dest use the name and value buffer of @p source.
+ *
+ * @pre elektraKeyPrepareShare() succeeded for @p source
+ * @pre @p dest has no name and value buffers
+ */
+void elektraKeyShareBuffers(Key *dest, const Key *source)
+{
+	dest->key = source->key;
+	dest->sharedName = source->sharedName;
+	if (dest->sharedName) __sync_add_and_fetch(&dest->sharedName->references, 1);
+
+	if (test_bit(source->flags, KEY_FLAG_INLINE_VALUE))
+	{
+		memcpy(dest->value.inlined, source->value.inlined, KEY_INLINE_VALUE_SIZE);
+		set_bit(dest->flags, KEY_FLAG_INLINE_VALUE);
+		dest->data.v = dest->value.inlined;
+		return;
+	}
+
+	dest->data.v = source->data.v;
+	dest->value.shared = source->value.shared;
+	if (dest->value.shared) __sync_add_and_fetch(&dest->value.shared->references, 1);
+}
+
+/**
+ * @internal
+ *
+ * Copies the name and value buffer of @p source to the heap, to be
+ * used with elektraKeyUseBuffers(). Unlike elektraKeyPrepareShare()
+ * this does not write to @p source.
+ *
+ * @param name set to the copy of the name, or 0
+ * @param value set to the copy of the value, or 0 if there is no
+ *        value or it is stored inside the key
+ * @retval 0 on success
+ * @retval -1 on memory error, nothing is allocated then
+ */
+int elektraKeyCopyBuffers(const Key *source, char **name, void **value)
+{
+	*name = 0;
+	*value = 0;
+
+	if (source->key)
+	{
+		*name = elektraMalloc(source->keySize + source->keyUSize);
+		if (!*name) return -1;
+		memcpy(*name, source->key, source->keySize + source->keyUSize);
+	}
+
+	if (source->data.v && !test_bit(source->flags, KEY_FLAG_INLINE_VALUE))
+	{
+		*value = elektraMalloc(source->dataSize);
+		if (!*value)
+		{
+			elektraFree(*name);
+			*name = 0;
+			return -1;
+		}
+		memcpy(*value, source->data.v, source->dataSize);
+	}
+
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Lets @p dest use the buffers of elektraKeyCopyBuffers().
+ *
+ * @pre @p dest has no name and value buffers
+ */
+void elektraKeyUseBuffers(Key *dest, const Key *source, char *name, void *value)
+{
+	dest->key = name;
+
+	if (test_bit(source->flags, KEY_FLAG_INLINE_VALUE))
+	{
+		memcpy(dest->value.inlined, source->value.inlined, KEY_INLINE_VALUE_SIZE);
+		set_bit(dest->flags, KEY_FLAG_INLINE_VALUE);
+		dest->data.v = dest->value.inlined;
+		return;
+	}
+
+	dest->data.v = value;
+}
+
+/**
+ * @internal
+ *
+ * Gives @p key its own name buffer, needed before the name is
+ * changed in place.
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+int elektraKeyUnshareName(Key *key)
+{
+	if (!key->sharedName) return 0;
+
+	return elektraKeyReallocBuffer(key, (void**)&key->key,
+		key->keySize + key->keyUSize, KEY_FLAG_ARENA_NAME);
+}
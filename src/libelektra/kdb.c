@@ -333,6 +333,72 @@ int kdbClose(KDB *handle, Key *errorKey)
 	return 0;
 }
 
+/**
+ * @brief Lets kdbGet() and kdbSet() run backends concurrently.
+ *
+ * With more than one worker, kdbGet() runs the plugins of the
+ * backends that need an update, except the resolvers, in up to
+ * @p workers threads. kdbSet() serializes the backends concurrently
+ * the same way, but commits or rolls them back one after the other
+ * as before. Errors and warnings are reported the same way as
+ * without workers.
+ *
+ * Only use it if all mounted plugins are reentrant: plugins of
+ * different backends run at the same time, and they must not share
+ * keys or meta keys with keys of other backends.
+ *
+ * Without threads on the system, backends are still run one after
+ * the other.
+ *
+ * @param handle contains internal information of
+ *               @link kdbOpen() opened @endlink key database
+ * @param workers the maximum number of threads, including the calling
+ *        thread, 0 or 1 to run the backends one after the other
+ * @retval 0 on success
+ * @retval -1 on NULL pointer
+ * @ingroup proposal
+ */
+int elektraKdbSetWorkers(KDB *handle, size_t workers)
+{
+	if (!handle) return -1;
+
+	handle->workers = workers;
+
+	return 0;
+}
+
+/**
+ * @brief Lets kdbGet() allocate the keys of storage plugins from arenas.
+ *
+ * With @p arena set, kdbGet() enables an arena for the KeySet of
+ * every backend it updates, see elektraKsEnableArena(). Keys the
+ * plugins create with elektraKsNewKey() then need no allocations of
+ * their own.
+ *
+ * Memory of an arena is only given back when all its keys are
+ * deleted. So a single key kept from a kdbGet(), e.g. because the
+ * backend was not updated again or because the application holds
+ * a reference to it, keeps all keys read by that backend in that
+ * kdbGet() in memory.
+ *
+ * @param handle contains internal information of
+ *               @link kdbOpen() opened @endlink key database
+ * @param arena 1 to use arenas, 0 to allocate every key on its own
+ *        (the default)
+ * @retval 0 on success
+ * @retval -1 on NULL pointer
+ * @see elektraKsEnableArena()
+ * @ingroup proposal
+ */
+int elektraKdbSetArena(KDB *handle, int arena)
+{
+	if (!handle) return -1;
+
+	handle->arena = arena;
+
+	return 0;
+}
+
 /**
  * @internal
  *
@@ -387,15 +453,219 @@ static int elektraGetCheckUpdateNeeded(Split *split, Key *parentKey)
 	return updateNeededOccurred;
 }
 
+/**
+ * @internal
+ * @brief Runs the plugins of a backend after the resolver.
+ *
+ * @retval -1 on error
+ * @retval 0 on success
+ */
+static int elektraGetRunPlugins(Backend *backend, KeySet *keys, Key *parentKey)
+{
+	for (size_t p=1; p<NR_OF_PLUGINS; ++p)
+	{
+		int ret = 0;
+		if (backend->getplugins[p])
+		{
+			ret = backend->getplugins[p]->kdbGet(
+					backend->getplugins[p],
+					keys,
+					parentKey);
+		}
+		if (ret == -1)
+		{
+			// Ohh, an error occurred,
+			// lets stop the process.
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @internal
+ *
+ * Moves the messages plugins added to @p from to @p to, as if they
+ * had been added to @p to directly. Warnings are renumbered to
+ * follow the warnings @p to already has.
+ */
+static void elektraMergeMessages(Key *to, Key *from)
+{
+	int next = 0;
+	const Key *count = keyGetMeta(to, "warnings");
+	if (count) next = (atoi(keyString(count))+1) % 100;
+
+	const Key *meta;
+	keyRewindMeta(from);
+	while ((meta = keyNextMeta(from)) != 0)
+	{
+		const char *name = keyName(meta);
+		if (!strcmp(name, "warnings")) continue;
+		if (strncmp(name, "warnings/#", 10) || strlen(name) < 12)
+		{
+			keyCopyMeta(to, from, name);
+			continue;
+		}
+
+		char *renamed = elektraStrDup(name);
+		int number = (next + atoi(name+10)) % 100;
+		renamed[10] = '0' + number / 10;
+		renamed[11] = '0' + number % 10;
+		keySetMeta(to, renamed, keyString(meta));
+		elektraFree(renamed);
+	}
+
+	count = keyGetMeta(from, "warnings");
+	if (count)
+	{
+		char last[3];
+		int number = (next + atoi(keyString(count))) % 100;
+		last[0] = '0' + number / 10;
+		last[1] = '0' + number % 10;
+		last[2] = '\0';
+		keySetMeta(to, "warnings", last);
+	}
+}
+
+/**
+ * @internal
+ *
+ * The plugins of one backend, run in a worker thread.
+ */
+typedef struct
+{
+	Backend *backend;
+	KeySet *keys;
+	Key *parent;		/**< The parent of the split */
+	Key *parentKey;		/**< Own parentKey to collect messages */
+	Key *errorKey;		/**< Current key when a plugin failed */
+	int ret;
+} ElektraBackendJob;
+
+/**
+ * @internal
+ *
+ * Prepares @p job for the backend @p i of @p split.
+ *
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+static int elektraJobInit(ElektraBackendJob *job, Split *split, size_t i)
+{
+	job->backend = split->handles[i];
+	job->keys = split->keysets[i];
+	job->parent = split->parents[i];
+	job->parentKey = keyNew(keyName(split->parents[i]),
+			KEY_VALUE, keyString(split->parents[i]),
+			KEY_END);
+	return job->parentKey ? 0 : -1;
+}
+
+static void elektraJobsDel(ElektraBackendJob *job, size_t jobs)
+{
+	for (size_t j=0; j<jobs; ++j) keyDel (job[j].parentKey);
+	elektraFree (job);
+}
+
+/**
+ * @internal
+ *
+ * Lets @p parentKey look like the backend of @p job used it last.
+ */
+static void elektraJobMerge(Key *parentKey, ElektraBackendJob *job)
+{
+	keySetName (parentKey, keyName(job->parentKey));
+	keySetString (parentKey, keyString(job->parentKey));
+	elektraMergeMessages (parentKey, job->parentKey);
+}
+
+static void elektraGetRunJob(void *data, size_t job)
+{
+	ElektraBackendJob *current = (ElektraBackendJob *)data + job;
+	current->ret = elektraGetRunPlugins(current->backend,
+			current->keys, current->parentKey);
+}
+
+/**
+ * @internal
+ * @brief Do the real update in worker threads.
+ *
+ * Every backend gets its own copy of the parentKey, and its keys get
+ * meta keys of their own. Afterwards the messages are merged to @p parentKey in the order of the split,
+ * stopping at the first backend that failed, so that the result is
+ * the same as with elektraGetDoUpdate() without workers.
+ *
+ * @retval -1 on error
+ * @retval 0 on success
+ * @retval 1 if nothing was done, because there are not enough backends
+ *         to update or there was no memory left
+ */
+static int elektraGetDoUpdateParallel(Split *split, Key *parentKey,
+		size_t workers, int arena)
+{
+	const int bypassedSplits = 1;
+	size_t jobs = 0;
+	for (size_t i=0; i<split->size-bypassedSplits;i++)
+	{
+		if (test_bit(split->syncbits[i], SPLIT_FLAG_SYNC)) ++jobs;
+	}
+	if (jobs < 2) return 1;
+
+	ElektraBackendJob *job = elektraCalloc(jobs * sizeof(ElektraBackendJob));
+	if (!job) return 1;
+
+	size_t j = 0;
+	for (size_t i=0; i<split->size-bypassedSplits;i++)
+	{
+		if (!test_bit(split->syncbits[i], SPLIT_FLAG_SYNC)) continue;
+
+		if (elektraJobInit(&job[j], split, i) == -1)
+		{
+			elektraJobsDel (job, j);
+			return 1;
+		}
+		if (elektraKsUnshareMeta (job[j].keys) == -1)
+		{
+			elektraJobsDel (job, j+1);
+			return 1;
+		}
+		if (arena) elektraKsEnableArena (job[j].keys);
+		ksRewind (job[j].keys);
+		++j;
+	}
+
+	elektraParallelRun (workers, jobs, elektraGetRunJob, job);
+
+	int ret = 0;
+	for (j=0; j<jobs && ret == 0; ++j)
+	{
+		elektraJobMerge (parentKey, &job[j]);
+		if (job[j].ret == -1) ret = -1;
+	}
+	elektraJobsDel (job, jobs);
+	return ret;
+}
+
 /**
  * @internal
  * @brief Do the real update.
  *
+ * With more than one worker, backends are updated concurrently,
+ * see elektraGetDoUpdateParallel().
+ *
  * @retval -1 on error
  * @retval 0 on success
  */
-static int elektraGetDoUpdate(Split *split, Key *parentKey)
+static int elektraGetDoUpdate(Split *split, Key *parentKey, size_t workers,
+		int arena)
 {
+	if (workers > 1)
+	{
+		int ret = elektraGetDoUpdateParallel(split, parentKey, workers,
+				arena);
+		if (ret != 1) return ret;
+	}
+
 	const int bypassedSplits = 1;
 	for (size_t i=0; i<split->size-bypassedSplits;i++)
 	{
@@ -405,27 +675,17 @@ static int elektraGetDoUpdate(Split *split, Key *parentKey)
 			continue;
 		}
 		Backend *backend = split->handles[i];
+		// keys created by the plugins with elektraKsNewKey()
+		if (arena) elektraKsEnableArena (split->keysets[i]);
 		ksRewind (split->keysets[i]);
 		keySetName (parentKey, keyName(split->parents[i]));
 		keySetString(parentKey,
 				keyString(split->parents[i]));
 
-		for (size_t p=1; p<NR_OF_PLUGINS; ++p)
+		if (elektraGetRunPlugins(backend, split->keysets[i],
+					parentKey) == -1)
 		{
-			int ret = 0;
-			if (backend->getplugins[p])
-			{
-				ret = backend->getplugins[p]->kdbGet(
-						backend->getplugins[p],
-						split->keysets[i],
-						parentKey);
-			}
-			if (ret == -1)
-			{
-				// Ohh, an error occurred,
-				// lets stop the process.
-				return -1;
-			}
+			return -1;
 		}
 	}
 	return 0;
@@ -504,7 +764,9 @@ static int elektraGetDoUpdate(Split *split, Key *parentKey)
  * 	finish affairs with the key database.
  * @retval 1 if the keys were retrieved successfully
  * @retval 0 if there was no update - no changes are made to the keyset then
- * @retval -1 on failure - no changes are made to the keyset then
+ * @retval -1 on failure - no changes are made to the keyset then,
+ *         unless merging the retrieved keys failed
+ * @retval -1 if @p ks was frozen with elektraKsFreeze()
  * @ingroup kdb
  */
 int kdbGet(KDB *handle, KeySet *ks, Key *parentKey)
@@ -546,6 +808,13 @@ int kdbGet(KDB *handle, KeySet *ks, Key *parentKey)
 		goto error;
 	}
 
+	if (test_bit(ks->flags, KS_FLAG_FROZEN))
+	{
+		ELEKTRA_SET_ERROR(111, parentKey,
+				"keyset passed to kdbGet is frozen");
+		goto error;
+	}
+
 	if(elektraSplitBuildup (split, handle, parentKey) == -1)
 	{
 		ELEKTRA_SET_ERROR(38, parentKey,
@@ -576,7 +845,8 @@ int kdbGet(KDB *handle, KeySet *ks, Key *parentKey)
 
 	/* Now do the real updating,
 	  but not for bypassed keys in split->size-1 */
-	if(elektraGetDoUpdate(split, parentKey) == -1)
+	if(elektraGetDoUpdate(split, parentKey, handle->workers,
+				handle->arena) == -1)
 	{
 		goto error;
 	}
@@ -588,9 +858,16 @@ int kdbGet(KDB *handle, KeySet *ks, Key *parentKey)
 		// continue, because sizes are already updated
 	}
 
-	/* We are finished, now just merge everything to returned */
-	ksClear (ks);
-	elektraSplitMerge (split, ks);
+	/* We are finished, now replace the keys of the updated backends */
+	if (elektraSplitMergeUpdated (split, handle, ks) == -1)
+	{
+		if (ksClear (ks) == -1 || elektraSplitMerge (split, ks) == -1)
+		{
+			ELEKTRA_SET_ERROR(111, parentKey,
+					"could not merge the retrieved keys");
+			goto error;
+		}
+	}
 
 	keySetName (parentKey, keyName(initialParent));
 	elektraSplitUpdateFileName(split, handle, parentKey);
@@ -608,76 +885,222 @@ error:
 	return -1;
 }
 
+/**
+ * @internal
+ * @brief Runs the resolver of a backend to prepare the commit
+ *
+ * @param parent the parent of the split, gets the name of the temporary file
+ * @param [out] errorKey is set to the current key on errors
+ *
+ * @retval 0 if the backend needs no sync, the other plugins are skipped then
+ * @retval 1 if the other plugins need to run
+ * @retval -1 on error, the other plugins still run
+ */
+static int elektraSetRunResolver(Backend *backend, KeySet *keys, Key *parent,
+		Key *parentKey, Key **errorKey)
+{
+	ksRewind (keys);
+	if (!backend->setplugins[0]) return 1;
+
+	keySetName (parentKey, keyName(parent));
+	int ret = backend->setplugins[0]->kdbSet (
+			backend->setplugins[0],
+			keys,
+			parentKey);
+
+#if VERBOSE && DEBUG
+	printf ("Prepare %s with keys %zd in resolver, ret: %d\n",
+			keyName(parentKey), ksGetSize(keys), ret);
+#endif
+
+	if (ret == 0)
+	{
+		// resolver says that sync is
+		// not needed, so we
+		// skip other pre-commit
+		// plugins
+		return 0;
+	}
+	keySetString (parent, keyString(parentKey));
+
+	if (ret == -1)
+	{
+		*errorKey = ksCurrent(keys);
+		return -1;
+	}
+	return 1;
+}
+
+/**
+ * @internal
+ * @brief Runs the plugins of a backend after the resolver up to the commit
+ *
+ * @param parent the parent of the split with the name of the temporary file
+ * @param [out] errorKey is set to the current key on errors
+ *
+ * @retval -1 on error
+ * @retval 0 on success
+ */
+static int elektraSetRunPlugins(Backend *backend, KeySet *keys, Key *parent,
+		Key *parentKey, Key **errorKey)
+{
+	int any_error = 0;
+	for(size_t p=1; p<COMMIT_PLUGIN; ++p)
+	{
+		ksRewind (keys);
+		if (!backend->setplugins[p]) continue;
+
+		keySetString (parentKey, keyString(parent));
+		keySetName (parentKey, keyName(parent));
+		int ret = backend->setplugins[p]->kdbSet (
+				backend->setplugins[p],
+				keys,
+				parentKey);
+
+#if VERBOSE && DEBUG
+		printf ("Prepare %s with keys %zd in plugin: %zu, ret: %d\n",
+				keyName(parentKey), ksGetSize(keys), p, ret);
+#endif
+
+		if (ret == -1)
+		{
+			// do not
+			// abort because it might
+			// corrupt the KeySet
+			// and leads to warnings
+			// because of .tmp files not
+			// found
+			*errorKey = ksCurrent(keys);
+
+			// so better keep going, but of
+			// course we will not commit
+			any_error = -1;
+		}
+	}
+	return any_error;
+}
+
+static void elektraSetRunJob(void *data, size_t job)
+{
+	ElektraBackendJob *current = (ElektraBackendJob *)data + job;
+	if (current->ret == 0) return;
+
+	if (elektraSetRunPlugins(current->backend, current->keys,
+			current->parent, current->parentKey,
+			&current->errorKey) == -1)
+	{
+		current->ret = -1;
+	}
+}
+
+/**
+ * @internal
+ * @brief Does all set steps but not commit, in worker threads
+ *
+ * The resolvers run one after the other in the calling thread, they
+ * lock the configuration files. Afterwards, the other plugins of the
+ * backends serialize concurrently, each backend with its own copy of
+ * the parentKey. Messages are merged to @p parentKey in the order of
+ * the split, so that the result is the same as with
+ * elektraSetPrepare() without workers.
+ *
+ * The keys of the split are the duplicates elektraSplitPrepare()
+ * made, each with a meta KeySet of its own. Only their meta keys
+ * shared with other keys are replaced by copies, the keys of the
+ * caller are not changed.
+ *
+ * @retval -1 on error
+ * @retval 0 on success
+ * @retval 1 if nothing was done, because there are not enough backends
+ *         or there was no memory left
+ */
+static int elektraSetPrepareParallel(Split *split, Key *parentKey,
+		Key **errorKey, size_t workers)
+{
+	const size_t jobs = split->size;
+	if (jobs < 2) return 1;
+
+	ElektraBackendJob *job = elektraCalloc(jobs * sizeof(ElektraBackendJob));
+	if (!job) return 1;
+
+	for (size_t j=0; j<jobs; ++j)
+	{
+		if (elektraJobInit(&job[j], split, j) == -1)
+		{
+			elektraJobsDel (job, j);
+			return 1;
+		}
+	}
+
+	size_t serialize = 0;
+	for (size_t j=0; j<jobs; ++j)
+	{
+		job[j].ret = elektraSetRunResolver(job[j].backend, job[j].keys,
+				job[j].parent, job[j].parentKey,
+				&job[j].errorKey);
+		if (job[j].ret == 0) continue;
+		++serialize;
+
+		/* the duplicates still share meta keys with the keys of
+		 * the caller, give them copies before other threads see them */
+		if (elektraKsUnshareMeta (job[j].keys) == -1) workers = 1;
+	}
+
+	elektraParallelRun (serialize > 1 ? workers : 1, jobs,
+			elektraSetRunJob, job);
+
+	int any_error = 0;
+	for (size_t j=0; j<jobs; ++j)
+	{
+		elektraJobMerge (parentKey, &job[j]);
+		if (job[j].ret == -1)
+		{
+			*errorKey = job[j].errorKey;
+			any_error = -1;
+		}
+	}
+	elektraJobsDel (job, jobs);
+	return any_error;
+}
+
 /**
  * @internal
  * @brief Does all set steps but not commit
  *
+ * With more than one worker, backends are serialized concurrently,
+ * see elektraSetPrepareParallel().
+ *
  * @param split all information for iteration
  * @param parentKey to add warnings (also passed to plugins for the same reason)
  * @param [out] errorKey may point to which key caused the error or 0 otherwise
+ * @param workers the maximum number of threads
  *
  * @retval -1 on error
  * @retval 0 on success
  */
-static int elektraSetPrepare(Split *split, Key *parentKey, Key **errorKey)
+static int elektraSetPrepare(Split *split, Key *parentKey, Key **errorKey,
+		size_t workers)
 {
+	if (workers > 1)
+	{
+		int ret = elektraSetPrepareParallel(split, parentKey, errorKey,
+				workers);
+		if (ret != 1) return ret;
+	}
+
 	int any_error = 0;
 	for(size_t i=0; i<split->size;i++)
 	{
-		for(size_t p=0; p<COMMIT_PLUGIN; ++p)
+		int ret = elektraSetRunResolver(split->handles[i],
+				split->keysets[i], split->parents[i],
+				parentKey, errorKey);
+		if (ret == 0) continue;
+		if (ret == -1) any_error = -1;
+
+		if (elektraSetRunPlugins(split->handles[i], split->keysets[i],
+				split->parents[i], parentKey, errorKey) == -1)
 		{
-			int ret = 0; // last return value
-
-			Backend *backend = split->handles[i];
-			ksRewind (split->keysets[i]);
-			if(backend->setplugins[p])
-			{
-				if(p != 0)
-				{
-					keySetString (parentKey,
-						keyString(split->parents[i]));
-				}
-				keySetName (parentKey,
-					keyName(split->parents[i]));
-				ret = backend->setplugins[p]->kdbSet (
-						backend->setplugins[p],
-						split->keysets[i],
-						parentKey);
-
-#if VERBOSE && DEBUG
-				printf ("Prepare %s with keys %zd in plugin: %zu, split: %zu, ret: %d\n",
-						keyName(parentKey), ksGetSize(split->keysets[i]), p, i, ret);
-#endif
-
-				if(p == 0)
-				{
-					if (ret == 0)
-					{
-						// resolver says that sync is
-						// not needed, so we
-						// skip other pre-commit
-						// plugins
-						break;
-					}
-					keySetString (split->parents[i],
-						keyString(parentKey));
-				}
-			}
-			if (ret == -1)
-			{
-				// do not
-				// abort because it might
-				// corrupt the KeySet
-				// and leads to warnings
-				// because of .tmp files not
-				// found
-				*errorKey =
-					ksCurrent(split->keysets[i]);
-
-				// so better keep going, but of
-				// course we will not commit
-				any_error = -1;
-			}
+			any_error = -1;
 		}
 	}
 	return any_error;
@@ -911,7 +1334,7 @@ int kdbSet(KDB *handle, KeySet *ks, Key *parentKey)
 
 	elektraSplitPrepare(split);
 
-	if (elektraSetPrepare(split, parentKey, &errorKey) == -1)
+	if (elektraSetPrepare(split, parentKey, &errorKey, handle->workers) == -1)
 	{
 		goto error;
 	}
@@ -224,10 +224,63 @@ Key *keyVNew (const char *name, va_list va)
 	return key;
 }
 
+/**
+ * Create a new key like keyNew(), allocated from the arena of @p ks.
+ *
+ * If @p ks has no arena enabled with elektraKsEnableArena(), this is
+ * the same as keyNew(). Otherwise the key, and later on its name and
+ * value, are allocated from the arena of @p ks.
+ *
+ * The key is not appended to @p ks, use ksAppendKey() or
+ * elektraKsAppendUnsorted() for that. keyDel() works as usual, but
+ * the memory is only given back together with the whole arena.
+ * Duplicates made with keyDup() are allocated on the heap.
+ *
+ * @param ks the keyset whose arena should be used
+ * @param name a valid name to the key, or NULL to get a simple
+ * 	initialized, but really empty, object
+ * @return a pointer to a new allocated and initialized Key object.
+ * @retval NULL on malloc error or if an invalid @p name was passed (see keySetName()).
+ * @see keyNew(), elektraKsEnableArena()
+ * @ingroup proposal
+ */
+Key *elektraKsNewKey(KeySet *ks, const char *name, ...)
+{
+	Key *key;
+	va_list va;
+
+	if (!ks || !test_bit(ks->flags, KS_FLAG_ARENA))
+	{
+		key = elektraKeyMalloc();
+	}
+	else
+	{
+		if (!ks->arena) ks->arena = elektraArenaNew();
+		if (!ks->arena) return 0;
+		key = elektraArenaMalloc(ks->arena, sizeof(struct _Key));
+		if (!key) return 0;
+		keyInit(key);
+		key->arena = ks->arena;
+		elektraArenaIncRef(key->arena);
+	}
+	if (!key) return 0;
+
+	if (name)
+	{
+		va_start(va,name);
+		keyVInit(key, name, va);
+		va_end(va);
+	}
+
+	return key;
+}
+
 /**
  * Return a duplicate of a key.
  *
  * Memory will be allocated as needed for dynamic properties.
+ * Name and value are shared with @p source (copy-on-write), they
+ * are only copied when one of the keys changes them.
  *
  * The new key will not be member of any KeySet and
  * will start with a new reference counter at 0. A
@@ -290,6 +343,9 @@ Key* keyDup(const Key *source)
 	dest->key=
 	dest->data.v=
 	dest->meta=0;
+	dest->arena=0;
+	dest->sharedName=
+	dest->value.shared=0;
 
 	/* copy dynamic properties */
 	if (keyCopy(dest, source) == -1)
@@ -304,6 +360,39 @@ Key* keyDup(const Key *source)
 
 
 
+/**
+ * @internal
+ *
+ * Duplicates the meta data of a read only key without writing
+ * to its meta keys, not even to their reference counters.
+ *
+ * @return the new meta keyset or 0 on memory error
+ */
+static KeySet *keyDupMeta(const KeySet *meta)
+{
+	KeySet *dup = ksNew(meta->size, KS_END);
+	if (!dup) return 0;
+
+	for (size_t i=0; i<meta->size; ++i)
+	{
+		// meta keys are read only, so this is a plain copy
+		Key *metaKey = keyDup(meta->array[i]);
+		if (!metaKey)
+		{
+			ksDel(dup);
+			return 0;
+		}
+		keyLock(metaKey, KEY_LOCK_NAME|KEY_LOCK_VALUE|KEY_LOCK_META);
+		if (ksAppendKey(dup, metaKey) == -1)
+		{
+			ksDel(dup);
+			return 0;
+		}
+	}
+
+	return dup;
+}
+
 /**
  * Copy or Clear a key.
  *
@@ -324,6 +413,9 @@ Key* keyDup(const Key *source)
  * key. So it will not take much additional space, even
  * with lots of metadata.
  *
+ * Name and value are shared with @p source until one of the
+ * keys changes them, so copying them is cheap, too.
+ *
  * When you pass a NULL-pointer as source the
  * data of dest will be cleaned completely
  * (except reference counter, see keyClear()) and
@@ -370,60 +462,56 @@ int keyCopy (Key *dest, const Key *source)
 		return 0;
 	}
 
-	// remember dynamic memory to be removed
-	char *destKey = dest->key;
-	void *destData = dest->data.c;
-	KeySet *destMeta = dest->meta;
-
-	// duplicate dynamic properties
-	if (source->key)
+	if (dest == source)
 	{
-		dest->key = elektraStrNDup(source->key, source->keySize + source->keyUSize);
-		if (!dest->key) goto memerror;
-	} else {
-		dest->key = 0;
+		set_bit(dest->flags, KEY_FLAG_SYNC);
+		return 1;
 	}
 
-	if (source->data.v)
+	// read only keys may be read by other threads, so they are copied
+	// without any write, otherwise name and value are shared and only
+	// the bookkeeping of source changes
+	const int readOnly = elektraKeyIsReadOnly(source);
+	char *name = 0;
+	void *value = 0;
+	if (readOnly)
 	{
-		dest->data.v = elektraStrNDup(source->data.v, source->dataSize);
-		if (!dest->data.v) goto memerror;
-	} else {
-		dest->data.v = 0;
+		if (elektraKeyCopyBuffers(source, &name, &value) == -1) return -1;
 	}
+	else if (elektraKeyPrepareShare((Key *)source) == -1) return -1;
 
+	KeySet *meta = 0;
 	if (source->meta)
 	{
-		dest->meta = ksDup (source->meta);
-		if (!dest->meta) goto memerror;
-	} else {
-		dest->meta = 0;
+		meta = readOnly ? keyDupMeta (source->meta) : ksDup (source->meta);
+		if (!meta)
+		{
+			elektraFree(name);
+			elektraFree(value);
+			return -1;
+		}
 	}
 
 	// successful, now do the irreversible stuff: we obviously modified dest
 	set_bit(dest->flags, KEY_FLAG_SYNC);
 
+	// free old resources of destination
+	if (dest->key) elektraKeyFreeBuffer(dest, dest->key, KEY_FLAG_ARENA_NAME);
+	if (dest->data.v) elektraKeyFreeBuffer(dest, dest->data.v, KEY_FLAG_ARENA_VALUE);
+	ksDel(dest->meta);
+
+	if (readOnly) elektraKeyUseBuffers(dest, source, name, value);
+	else elektraKeyShareBuffers(dest, source);
+	dest->meta = meta;
+
 	// copy sizes accordingly
 	dest->keySize = source->keySize;
 	dest->keyUSize = source->keyUSize;
+	dest->nameHash = source->nameHash;
+	dest->namePrefix = source->namePrefix;
 	dest->dataSize = source->dataSize;
 
-	// free old resources of destination
-	elektraFree(destKey);
-	elektraFree(destData);
-	ksDel(destMeta);
-
 	return 1;
-
-memerror:
-	elektraFree(dest->key);
-	elektraFree(dest->data.v);
-	ksDel(dest->meta);
-
-	dest->key = destKey;
-	dest->data.v = destData;
-	dest->meta = destMeta;
-	return -1;
 }
 
 
@@ -467,8 +555,10 @@ int keyDel(Key *key) {
 		return key->ksReference;
 	}
 
+	KeyArena *arena = key->arena;
 	rc=keyClear(key);
-	elektraFree (key);
+	if (arena) elektraArenaDecRef (arena);
+	else elektraFree (key);
 
 	return rc;
 }
@@ -512,8 +602,9 @@ int keyClear(Key *key)
 	size_t ref = 0;
 
 	ref = key->ksReference;
-	if (key->key) elektraFree(key->key);
-	if (key->data.v) elektraFree(key->data.v);
+	KeyArena *arena = key->arena;
+	if (key->key) elektraKeyFreeBuffer(key, key->key, KEY_FLAG_ARENA_NAME);
+	if (key->data.v) elektraKeyFreeBuffer(key, key->data.v, KEY_FLAG_ARENA_VALUE);
 	if (key->meta) ksDel(key->meta);
 
 	keyInit (key);
@@ -521,6 +612,7 @@ int keyClear(Key *key)
 
 	/* Set reference properties */
 	key->ksReference = ref;
+	key->arena = arena;
 
 	return 0;
 }
@@ -299,6 +299,7 @@ int keyNameIsSystem(const char *name)
 int keyInit(Key *key)
 {
 	memset(key,0,sizeof(struct _Key));
+	elektraKeyNameCache(key);
 
 	return 0;
 }
@@ -325,7 +326,9 @@ void keyVInit(Key *key, const char *name, va_list va)
 
 	if (!key) return;
 
+	KeyArena *arena = key->arena;
 	keyInit(key);
+	key->arena = arena;
 
 	if (name) {
 		while ((action = va_arg(va, keyswitch_t))) {
@@ -117,6 +117,165 @@
 #endif
 
 
+/**
+ * @internal
+ *
+ * Combines the cached hash of the name with the hash of the value,
+ * see elektraKeyNameCache() and elektraKsHashValue().
+ */
+static kdb_unsigned_long_long_t elektraMetaHash(const Key *meta)
+{
+	return (meta->nameHash * 1099511628211ULL) ^
+		elektraKsHashValue(meta->data.c,
+			meta->data.v ? meta->dataSize : 0);
+}
+
+static int elektraMetaEqual(const Key *meta1, const Key *meta2)
+{
+	return meta1->dataSize == meta2->dataSize
+		&& !memcmp(meta1->data.c, meta2->data.c, meta1->dataSize)
+		&& !strcmp(meta1->key, meta2->key);
+}
+
+/**
+ * @internal
+ *
+ * @return the meta key in @p slots equal to @p meta, after adding
+ *         @p meta if there was none
+ */
+static Key *elektraMetaShare(Key **slots, size_t mask, Key *meta)
+{
+	size_t slot = elektraMetaHash(meta) & mask;
+	Key *current;
+
+	while ((current = slots[slot]) != 0)
+	{
+		if (elektraMetaEqual(current, meta)) return current;
+		slot = (slot+1) & mask;
+	}
+	slots[slot] = meta;
+	return meta;
+}
+
+/**
+ * @internal
+ *
+ * Replaces the meta key at @p pos of @p meta by @p with, which has
+ * the same name, so that positions stay valid.
+ */
+static void elektraMetaReplace(KeySet *meta, size_t pos, Key *with)
+{
+	Key *old = meta->array[pos];
+
+	keyIncRef (with);
+	meta->array[pos] = with;
+	if (meta->cursor == old) meta->cursor = with;
+	keyDecRef (old);
+	keyDel (old);
+}
+
+/**
+ * Lets all keys of @p ks share equal meta information.
+ *
+ * Meta keys with the same name and value are replaced by a single
+ * meta key, as if keyCopyMeta() had been used for them. So the
+ * metadata of large keysets, e.g. type=long on thousands of keys,
+ * takes the memory only once.
+ *
+ * Nothing is shared unless this function is called, keySetMeta()
+ * still creates a meta key for every key. Like with keyCopyMeta(),
+ * keys sharing meta keys must not be used by different threads
+ * concurrently.
+ *
+ * Replaced meta keys are deleted, so pointers to them returned by
+ * keyGetMeta() or keyNextMeta() before must not be used anymore,
+ * as after keySetMeta().
+ *
+ * @param ks the keyset whose keys should share their meta keys
+ * @return the number of meta keys that were replaced
+ * @retval -1 on NULL pointer or memory errors
+ * @see keyCopyMeta(), keyCopyAllMeta()
+ */
+ssize_t elektraKsShareMeta(KeySet *ks)
+{
+	if (!ks) return -1;
+
+	size_t metas = 0;
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		if (ks->array[i]->meta) metas += ks->array[i]->meta->size;
+	}
+	if (metas < 2) return 0;
+
+	size_t alloc = KEYSET_HASH_MIN_SIZE;
+	while (alloc < metas*2) alloc *= 2;
+	Key **slots = elektraCalloc(alloc * sizeof(Key*));
+	if (!slots) return -1;
+
+	ssize_t replaced = 0;
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		KeySet *meta = ks->array[i]->meta;
+		if (!meta) continue;
+
+		for (size_t j=0; j<meta->size; ++j)
+		{
+			Key *old = meta->array[j];
+			Key *shared = elektraMetaShare(slots, alloc-1, old);
+			if (shared == old) continue;
+
+			elektraMetaReplace (meta, j, shared);
+			++ replaced;
+		}
+	}
+
+	elektraFree (slots);
+	return replaced;
+}
+
+/**
+ * @internal
+ *
+ * Gives every key of @p ks meta keys of its own.
+ *
+ * Meta keys also referenced by other keys, e.g. after keyDup() or
+ * keyCopyMeta(), are replaced by duplicates. Afterwards the keys of
+ * @p ks may be used in another thread than the keys they shared
+ * meta keys with. Only the meta KeySets of the keys of @p ks change,
+ * the other keys keep their meta keys.
+ *
+ * @param ks the keyset whose keys should not share meta keys
+ * @retval 0 on success
+ * @retval -1 on NULL pointer or memory errors, then some meta keys
+ *         might still be shared
+ */
+int elektraKsUnshareMeta(KeySet *ks)
+{
+	if (!ks) return -1;
+
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		KeySet *meta = ks->array[i]->meta;
+		if (!meta) continue;
+
+		for (size_t j=0; j<meta->size; ++j)
+		{
+			Key *old = meta->array[j];
+			if (old->ksReference < 2) continue;
+
+			Key *own = keyDup (old);
+			if (!own) return -1;
+			own->flags |= old->flags & (KEY_FLAG_RO_NAME
+					| KEY_FLAG_RO_VALUE | KEY_FLAG_RO_META);
+
+			elektraMetaReplace (meta, j, own);
+		}
+	}
+
+	return 0;
+}
+
+
 /**Rewind the internal iterator to first meta data.
  *
  * Use it to set the cursor to the beginning of the Key Meta Infos.
@@ -411,6 +570,12 @@ const Key *keyGetMeta(const Key *key, const char* metaName)
 	if (!metaName) return 0;
 	if (!key->meta) return 0;
 
+	// frozen keys may be read by several threads at once
+	if (test_bit(key->meta->flags, KS_FLAG_FROZEN))
+	{
+		return elektraKeyGetMetaConst(key, metaName);
+	}
+
 	search = keyNew (0);
 	elektraKeySetName(search, metaName, KEY_META_NAME | KEY_EMPTY_NAME);
 
@@ -486,7 +651,8 @@ ssize_t keySetMeta(Key *key, const char* metaName,
 	if (newMetaString)
 	{
 		/*Add the meta information to the key*/
-		metaStringDup = elektraStrNDup(newMetaString, metaStringSize);
+		metaStringDup = elektraKeyMallocBuffer(toSet, metaStringSize,
+				KEY_FLAG_ARENA_VALUE);
 		if (!metaStringDup)
 		{
 			// TODO: actually we might already have changed
@@ -494,8 +660,8 @@ ssize_t keySetMeta(Key *key, const char* metaName,
 			keyDel (toSet);
 			return -1;
 		}
+		memcpy(metaStringDup, newMetaString, metaStringSize);
 
-		if (toSet->data.v) free (toSet->data.v);
 		toSet->data.c = metaStringDup;
 		toSet->dataSize = metaStringSize;
 	} else {
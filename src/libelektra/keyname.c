@@ -349,17 +349,60 @@ ssize_t elektraFinalizeName(Key *key)
 
 	key->keyUSize = elektraUnescapeKeyName(key->key,
 			key->key+key->keySize);
+	elektraKeyNameCache(key);
 
 	key->flags |= KEY_FLAG_SYNC;
 
 	return key->keySize;
 }
 
+/**
+ * @internal
+ *
+ * @brief Computes the hash and the prefix of the unescaped name
+ *
+ * They let comparisons of names skip most memcmp(). Call this
+ * function whenever the unescaped name changed without
+ * elektraFinalizeName(), which already does it.
+ *
+ * @param key the key with the new unescaped name (or none)
+ */
+void elektraKeyNameCache(Key *key)
+{
+	const unsigned char *name = 0;
+	size_t size = 0;
+	kdb_unsigned_long_long_t hash = 14695981039346656037ULL; // FNV-1a
+	kdb_unsigned_long_long_t prefix = 0;
+
+	if (key->key)
+	{
+		name = (const unsigned char *)key->key + key->keySize;
+		size = key->keyUSize;
+	}
+
+	for (size_t i=0; i<size; ++i)
+	{
+		hash ^= name[i];
+		hash *= 1099511628211ULL;
+	}
+
+	for (size_t i=0; i<sizeof(prefix); ++i)
+	{
+		prefix <<= 8;
+		if (i < size) prefix |= name[i];
+	}
+
+	key->nameHash = hash;
+	key->namePrefix = prefix;
+}
+
 ssize_t elektraFinalizeEmptyName(Key *key)
 {
-	key->key = elektraCalloc(2); // two null pointers
+	key->key = elektraKeyMallocBuffer(key, 2, KEY_FLAG_ARENA_NAME);
+	if (key->key) memset(key->key, 0, 2); // two null pointers
 	key->keySize = 1;
 	key->keyUSize = 1;
+	elektraKeyNameCache(key);
 	key->flags |= KEY_FLAG_SYNC;
 
 	return key->keySize;
@@ -376,9 +419,10 @@ static void elektraHandleUserName(Key *key, const char* newName)
 	ELEKTRA_ASSERT(delim == ':');
 
 	// handle owner (compatibility, to be removed)
-	keyNameGetOneLevel(newName, &key->keyUSize);
-	const size_t ownerLength=key->keyUSize-userLength;
-	++key->keyUSize;
+	size_t levelSize = 0;
+	keyNameGetOneLevel(newName, &levelSize);
+	key->keyUSize = levelSize + 1;
+	const size_t ownerLength=levelSize-userLength;
 	char *owner=elektraMalloc(ownerLength+1);
 	if (!owner) return; // out of memory, ok for owner
 	strncpy(owner,newName+userLength,ownerLength);
@@ -389,10 +433,11 @@ static void elektraHandleUserName(Key *key, const char* newName)
 
 static void elektraRemoveKeyName(Key *key)
 {
-	if (key->key) elektraFree(key->key);
+	if (key->key) elektraKeyFreeBuffer(key, key->key, KEY_FLAG_ARENA_NAME);
 	key->key=0;
 	key->keySize=0;
 	key->keyUSize=0;
+	elektraKeyNameCache(key);
 }
 
 /**
@@ -466,6 +511,10 @@ ssize_t elektraKeySetName(Key *key, const char *newName,
 	elektraRemoveKeyName(key);
 	if (!(options & KEY_META_NAME)) keySetOwner (key, NULL);
 
+	// the escaped and the unescaped name have to fit in the buffer
+	const size_t length = newName ? elektraStrLen(newName) : 0;
+	if (length > KEY_MAX_BUFFER_SIZE / 2) return -1;
+
 	switch(keyGetNameNamespace(newName))
 	{
 	case KEY_NS_NONE: ELEKTRA_ASSERT(0);
@@ -479,14 +528,16 @@ ssize_t elektraKeySetName(Key *key, const char *newName,
 	case KEY_NS_USER: elektraHandleUserName(key, newName); break;
 	case KEY_NS_SYSTEM: key->keyUSize=key->keySize=sizeof("system"); break;
 	case KEY_NS_META:
+	{
 		if (!(options & KEY_META_NAME)) return -1;
-		keyNameGetOneLevel(newName,&key->keySize);
-		key->keyUSize = ++ key->keySize; // for null
+		size_t levelSize = 0;
+		keyNameGetOneLevel(newName, &levelSize);
+		key->keyUSize = key->keySize = levelSize + 1; // for null
 		break;
+	}
 	} // Note that we abused keyUSize for cascading and user:owner
 
-	const size_t length = elektraStrLen(newName);
-	key->key=elektraMalloc(key->keySize*2);
+	key->key=elektraKeyMallocBuffer(key, key->keySize*2, KEY_FLAG_ARENA_NAME);
 	memcpy(key->key, newName, key->keySize);
 	if (length == key->keyUSize || length == key->keySize)
 	{	// use || because full length is keyUSize in user, but keySize for /
@@ -794,21 +845,15 @@ ssize_t keyAddBaseName(Key *key, const char *baseName)
 	char *escaped = elektraMalloc (strlen (baseName) * 2 + 2);
 	elektraEscapeKeyNamePart(baseName, escaped);
 	size_t len = strlen (escaped);
-	if (!strcmp(key->key, "/"))
-	{
-		key->keySize += len;
-	}
-	else
-	{
-		key->keySize += len + 1;
-	}
+	size_t size = key->keySize + len;
+	if (strcmp(key->key, "/")) ++size;
 
-	elektraRealloc ((void**)&key->key, key->keySize*2);
-	if (!key->key)
+	if (elektraKeyReallocBuffer (key, (void**)&key->key, size*2, KEY_FLAG_ARENA_NAME) == -1)
 	{
 		elektraFree (escaped);
 		return -1;
 	}
+	key->keySize = size;
 
 	if (strcmp(key->key, "/"))
 	{
@@ -911,8 +956,10 @@ ssize_t keyAddName(Key *key, const char *newName)
 
 	const size_t origSize = key->keySize;
 	const size_t newSize = origSize + nameSize;
-	elektraRealloc ((void**)&key->key, newSize*2);
-	if (!key->key) return -1;
+	if (elektraKeyReallocBuffer (key, (void**)&key->key, newSize*2, KEY_FLAG_ARENA_NAME) == -1)
+	{
+		return -1;
+	}
 
 	size_t size=0;
 	const char * p = newName;
@@ -1025,6 +1072,9 @@ ssize_t keySetBaseName(Key *key, const char *baseName)
 		return -1;
 	}
 
+	// the name is changed in place
+	if (elektraKeyUnshareName(key) == -1) return -1;
+
 	// truncate the key
 	key->keySize -= searchBaseSize;
 
@@ -1039,8 +1089,7 @@ ssize_t keySetBaseName(Key *key, const char *baseName)
 	elektraEscapeKeyNamePart(baseName, escaped);
 	size_t sizeEscaped = elektraStrLen (escaped);
 
-	elektraRealloc((void**)&key->key, (key->keySize+sizeEscaped)*2);
-	if (!key->key)
+	if (elektraKeyReallocBuffer(key, (void**)&key->key, (key->keySize+sizeEscaped)*2, KEY_FLAG_ARENA_NAME) == -1)
 	{
 		elektraFree (escaped);
 		return -1;
@@ -34,6 +34,10 @@
 #include <string.h>
 #endif
 
+#ifdef HAVE_CTYPE_H
+#include <ctype.h>
+#endif
+
 #include <kdbtypes.h>
 
 #include "kdbinternal.h"
@@ -352,6 +356,7 @@ int f (KeySet *ks)
 int ksCopy (KeySet *dest, const KeySet *source)
 {
 	if (!dest) return -1;
+	if (test_bit(dest->flags, KS_FLAG_FROZEN)) return -1;
 	ksClear (dest);
 	if (!source) return 0;
 
@@ -383,6 +388,7 @@ int ksDel(KeySet *ks)
 	if (!ks) return -1;
 
 	rc=ksClose(ks);
+	if (ks->arena) elektraArenaClose(ks->arena);
 	elektraFree(ks);
 
 	return rc;
@@ -404,6 +410,7 @@ int ksDel(KeySet *ks)
  */
 int ksClear(KeySet *ks)
 {
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return -1;
 	ksClose (ks);
 	// ks->array empty now
 
@@ -434,6 +441,10 @@ static int keyCompareByName(const void *p1, const void *p2)
 {
 	Key *key1=*(Key **)p1;
 	Key *key2=*(Key **)p2;
+	if (key1->namePrefix != key2->namePrefix)
+	{
+		return key1->namePrefix < key2->namePrefix ? -1 : 1;
+	}
 	const void *name1 = key1->key+key1->keySize;
 	const void *name2 = key2->key+key2->keySize;
 	size_t const nameSize1 = key1->keyUSize;
@@ -671,1261 +682,4034 @@ ssize_t ksGetSize(const KeySet *ks)
 
 
 
-/******************************************* 
- *           Filling up KeySets            *
+/*******************************************
+ *   Case-folded index for NOCASE lookups  *
  *******************************************/
 
-
 /**
  * @internal
  *
- * Binary search in a keyset that informs where key should be inserted.
+ * Drops the case-folded index.
  *
- * @code
-
-ssize_t result = ksSearchInternal(ks, toAppend);
-
-if (result >= 0)
+ * @param ks the keyset to work with
+ */
+static void elektraKsCaseIndexDrop(KeySet *ks)
 {
-	ssize_t position = result;
-	// Seems like the key already exist.
-} else {
-	ssize_t insertpos = -result-1;
-	// Seems like the key does not exist.
+	elektraFree (ks->caseIndex);
+	ks->caseIndex = 0;
+	ks->caseScans = 0;
 }
- * @endcode
+
+/**
+ * @internal
  *
- * @param ks the keyset to work with
- * @param toAppend the key to check
- * @return position where the key is (>=0) if the key was found
- * @return -insertpos -1 (< 0) if the key was not found 
- *    so to get the insertpos simple do: -insertpos -1
+ * @return the eight bytes of the unescaped name of @p key after
+ *         @p offset in upper case, like elektraMemCaseCmp() compares
+ *         them, packed like Key::namePrefix
  */
-ssize_t ksSearchInternal(const KeySet *ks, const Key *toAppend)
+static kdb_unsigned_long_long_t elektraKsCasePrefix(const Key *key, size_t offset)
 {
-	ssize_t left = 0;
-	ssize_t right = ks->size-1;
-	register int cmpresult = 1;
-	ssize_t middle = -1;
-	ssize_t insertpos = 0;
-#if DEBUG && VERBOSE
-	int c=0;
-#endif
+	const unsigned char *name = (const unsigned char *)key->key + key->keySize;
+	kdb_unsigned_long_long_t prefix = 0;
 
-
-	while(1)
+	for (size_t i=offset; i<offset+sizeof(prefix); ++i)
 	{
-#if DEBUG && VERBOSE
-		++c;
-#endif
-		if (right < left)
-		{
-			/* Nothing was found */
-			break;
-		}
-		middle = left + ((right-left)/2);
-		cmpresult = keyCompareByNameOwner(&toAppend, &ks->array[middle]);
-		if (cmpresult > 0)
-		{
-			insertpos = left = middle + 1;
-		} else if (cmpresult == 0)
-		{
-			/* We have found it */
-			break;
-		} else {
-			insertpos = middle;
-			right = middle - 1;
-		}
-#if DEBUG && VERBOSE
-		/* This is even for verbose too verbose!
-		printf ("bsearch -- c: %d res: %d left: %zd middle: %zd right: %zd insertpos: %zd\n",
-			c, cmpresult, left, middle, right, insertpos);
-		*/
-#endif
+		prefix <<= 8;
+		if (i < key->keyUSize) prefix |= (unsigned char) toupper(name[i]);
 	}
+	return prefix;
+}
 
-	if (!cmpresult)
+/**
+ * @internal
+ *
+ * Like keyCompareByNameCase(), but the first @p offset bytes of
+ * the names are known to be equal ignoring case.
+ */
+static int elektraKsCaseCompareFrom(const Key *key1, const Key *key2, size_t offset)
+{
+	const size_t size1 = key1->keyUSize;
+	const size_t size2 = key2->keyUSize;
+	const int ret = elektraMemCaseCmp(key1->key + key1->keySize + offset,
+		key2->key + key2->keySize + offset,
+		(size1 < size2 ? size1 : size2) - offset);
+	if (ret || size1 == size2) return ret;
+	return size1 < size2 ? -1 : 1;
+}
+
+static int elektraKsCaseCompare(const KeySet *ks, const KeySetCaseEntry *entry1,
+		const KeySetCaseEntry *entry2)
+{
+	if (entry1->prefix != entry2->prefix)
 	{
-		return middle;
-	} else {
-		return -insertpos - 1;
+		return entry1->prefix < entry2->prefix ? -1 : 1;
 	}
+	return elektraKsCaseCompareFrom(ks->array[entry1->pos],
+		ks->array[entry2->pos], ks->caseOffset);
 }
 
 /**
- * Appends a Key to the end of @p ks.
- *
- * Will take ownership of the key @p toAppend.
- * That means ksDel(ks) will remove the key unless
- * the key:
- * - was duplicated before inserting
- * - got its refcount incremented by keyIncRef() before inserting
- * - was also inserted into another keyset with ksAppendKey()
- *
- * The reference counter of the key will be incremented
- * to show this ownership, and thus @p toAppend is not const.
- *
- * @copydetails doxygenFlatCopy
- *
- * @see keyGetRef().
- *
- * If the keyname already existed in the keyset, it will be replaced with
- * the new key.
- *
- * The KeySet internal cursor will be set to the new key.
- *
- * It is save to directly append newly created keys:
- * @snippet keyset.c simple append
- *
- * If you want the key to outlive the keyset, make sure to
- * do proper ref counting:
- * @snippet keyset.c ref append
- *
- * Or if you want to avoid aliasing at all, you can duplicate the key.
- * But then key in the keyset has another identity:
- * @snippet keyset.c dup append
+ * @internal
  *
+ * (Re)builds the case-folded index for all keys of the keyset.
  *
- * @return the size of the KeySet after insertion
- * @return -1 on NULL pointers
- * @return -1 if insertion failed, the key will be deleted then.
- * @param ks KeySet that will receive the key
- * @param toAppend Key that will be appended to ks or deleted
- * @see ksAppend(), keyNew(), ksDel()
- * @see keyIncRef()
+ * Like for KeySet::sortKeys, the bytes after the prefix all names
+ * share are used, so that most comparisons do not touch the names.
+ * A stable merge sort is used, so that keys which only differ in
+ * case stay in the order of their positions.
  *
+ * @pre the keyset is not empty
+ * @retval 1 on success
+ * @retval -1 on memory error (no index afterwards)
  */
-ssize_t ksAppendKey(KeySet *ks, Key *toAppend)
+static int elektraKsCaseIndexBuild(KeySet *ks)
 {
-	ssize_t result = -1;
+	const size_t size = ks->size;
 
-	if (!ks) return -1;
-	if (!toAppend) return -1;
-	if (!toAppend->key)
+	elektraKsCaseIndexDrop(ks);
+	KeySetCaseEntry *index = elektraMalloc (sizeof(KeySetCaseEntry) * size * 2);
+	if (!index) return -1;
+
+	const Key *ref = ks->array[0];
+	const char *refName = ref->key + ref->keySize;
+	size_t offset = ref->keyUSize;
+	for (size_t i=1; i<size; ++i)
 	{
-		// needed for ksAppendKey(ks, keyNew(0))
-		keyDel (toAppend);
-		return -1;
+		const Key *key = ks->array[i];
+		const char *name = key->key + key->keySize;
+		if (offset > key->keyUSize) offset = key->keyUSize;
+		size_t common = 0;
+		while (common < offset && toupper((unsigned char)name[common])
+			== toupper((unsigned char)refName[common]))
+		{
+			++ common;
+		}
+		offset = common;
 	}
+	ks->caseOffset = offset;
 
-	keyLock(toAppend, KEY_LOCK_NAME);
-
-	result = ksSearchInternal(ks, toAppend);
+	KeySetCaseEntry *from = index;
+	KeySetCaseEntry *to = index + size;
+	for (size_t i=0; i<size; ++i)
+	{
+		from[i].prefix = elektraKsCasePrefix(ks->array[i], offset);
+		from[i].pos = i;
+	}
 
-	if (result >= 0)
+	for (size_t width=1; width<size; width*=2)
 	{
-		/* Seems like the key already exist. */
-		if (toAppend == ks->array[result])
+		for (size_t begin=0; begin<size; begin+=2*width)
 		{
-			/* user tried to insert the same key again */
-			return ks->size;
+			const size_t middle = begin+width < size ? begin+width : size;
+			const size_t end = begin+2*width < size ? begin+2*width : size;
+			size_t i = begin;
+			size_t j = middle;
+			size_t k = begin;
+
+			while (i < middle && j < end)
+			{
+				if (elektraKsCaseCompare(ks, &from[j], &from[i]) < 0) to[k++] = from[j++];
+				else to[k++] = from[i++];
+			}
+			while (i < middle) to[k++] = from[i++];
+			while (j < end) to[k++] = from[j++];
 		}
 
-		/* Pop the key in the result */
-		keyDecRef (ks->array[result]);
-		keyDel (ks->array[result]);
+		KeySetCaseEntry *tmp = from;
+		from = to;
+		to = tmp;
+	}
 
-		/* And use the other one instead */
-		keyIncRef (toAppend);
-		ks->array[result] = toAppend;
-		ksSetCursor(ks, result);
-	} else {
-		ssize_t insertpos = -result-1;
+	if (from != index) memcpy(index, from, sizeof(KeySetCaseEntry) * size);
+	elektraRealloc((void **) &index, sizeof(KeySetCaseEntry) * size); // only shrinks
 
-		/* We want to append a new key
-		  in position insertpos */
-		++ ks->size;
-		if (ks->size >= ks->alloc) ksResize (ks, ks->alloc * 2-1);
-		keyIncRef (toAppend);
+	ks->caseIndex = index;
+	return 1;
+}
 
-		if (insertpos == (ssize_t)ks->size-1)
+/**
+ * @internal
+ *
+ * Looks up @p key ignoring case with the case-folded index.
+ *
+ * Like a linear search, the first matching key in the keyset is
+ * found if several keys only differ in case.
+ *
+ * @pre the keyset has a case-folded index
+ * @param options only KDB_O_WITHOWNER is considered
+ * @return the position of the key found or -1
+ */
+static ssize_t elektraKsCaseSearch(const KeySet *ks, const Key *key,
+		option_t options)
+{
+	const size_t offset = ks->caseOffset;
+	const Key *ref = ks->array[0];
+	if (key->keyUSize < offset || elektraMemCaseCmp(key->key + key->keySize,
+		ref->key + ref->keySize, offset))
+	{
+		return -1; // all keys share the prefix
+	}
+
+	const kdb_unsigned_long_long_t prefix = elektraKsCasePrefix(key, offset);
+	size_t begin = 0;
+	size_t end = ks->size;
+
+	while (begin < end)
+	{
+		const size_t middle = begin + (end-begin)/2;
+		const KeySetCaseEntry *entry = &ks->caseIndex[middle];
+		int cmp = entry->prefix < prefix ? -1 : entry->prefix > prefix;
+		if (!cmp) cmp = elektraKsCaseCompareFrom(ks->array[entry->pos], key, offset);
+		if (cmp < 0) begin = middle+1;
+		else end = middle;
+	}
+
+	for (; begin < ks->size; ++begin)
+	{
+		const KeySetCaseEntry *entry = &ks->caseIndex[begin];
+		const Key *current = ks->array[entry->pos];
+		if (entry->prefix != prefix || elektraKsCaseCompareFrom(current, key, offset)) break;
+		if (!(options & KDB_O_WITHOWNER) || !keyCompareByOwner(&current, &key))
 		{
-			/* Append it to the very end */
-			ks->array[ks->size-1] = toAppend;
-			ks->array[ks->size] = 0;
-			ksSetCursor(ks, ks->size-1);
-		} else {
-			size_t n = ks->size-insertpos;
-			memmove(ks->array+(insertpos+1), ks->array+insertpos, n*sizeof(struct Key*));
-			/*
-			printf ("memmove -- ks->size: %zd insertpos: %zd n: %zd\n",
-				ks->size, insertpos, n);
-			*/
-			ks->array[insertpos] = toAppend;
-			ksSetCursor(ks, insertpos);
+			return entry->pos;
 		}
 	}
 
-	return ks->size;
+	return -1;
 }
 
 
-
 /**
- * Append all @p toAppend contained keys to the end of the @p ks.
- *
- * @p toAppend KeySet will be left unchanged.
- *
- * If a key is both in toAppend and ks, the Key in ks will be
- * overridden.
+ * @internal
  *
- * @copydetails doxygenFlatCopy
+ * Like elektraKsCaseSearch(), but scans the keyset without index.
  *
- * @post Sorted KeySet ks with all keys it had before and additionally
- *       the keys from toAppend
- * @return the size of the KeySet after transfer
- * @return -1 on NULL pointers
- * @param ks the KeySet that will receive the keys
- * @param toAppend the KeySet that provides the keys that will be transferred
- * @see ksAppendKey()
- * 
+ * The array is sorted case sensitive, so it cannot be bisected
+ * ignoring case.
  */
-ssize_t ksAppend(KeySet *ks, const KeySet *toAppend)
+static ssize_t elektraKsCaseScan(const KeySet *ks, const Key *key,
+		option_t options)
 {
-	size_t toAlloc = 0;
-
-	if (!ks) return -1;
-	if (!toAppend) return -1;
-
-	if (toAppend->size <= 0) return ks->size;
+	int (*compare)(const void *, const void *) = keyCompareByNameCase;
+	if (options & KDB_O_WITHOWNER) compare = keyCompareByNameOwnerCase;
 
-	/* Do only one resize in advance */
-	for (toAlloc = ks->alloc; ks->size+toAppend->size >= toAlloc; toAlloc *= 2);
-	ksResize (ks, toAlloc-1);
-
-	/* TODO: here is lots of room for optimizations */
-	for (size_t i=0; i<toAppend->size; ++i)
+	for (size_t i=0; i<ks->size; ++i)
 	{
-		ksAppendKey (ks, toAppend->array[i]);
+		if (!compare(&key, &ks->array[i])) return i;
 	}
-	return ks->size;
+
+	return -1;
 }
 
 
 
+/*******************************************
+ *     Tree index for hierarchy walks      *
+ *******************************************/
+
+static int elektraKsCompareBelow(const Key *parent, const Key *key);
+
 /**
  * @internal
  *
- * Copies all Keys until the end of the array from a position
- * in the array to an position in the array.
+ * Drops the tree index.
  *
- * @param ks the keyset where this should be done
- * @param to the position where it should be copied to
- * @param from the position where it should be copied from
- * @retval -1 if length is smaller then 0
- * @return the number of moved elements otherwise
+ * @param ks the keyset to work with
  */
-ssize_t ksCopyInternal(KeySet *ks, size_t to, size_t from)
+static void elektraKsTreeIndexDrop(KeySet *ks)
 {
-	ssize_t ssize = ks->size;
-	ssize_t sto = to;
-	ssize_t sfrom = from;
-
-	ssize_t sizediff = sto-sfrom;
-	ssize_t length = ssize-sfrom;
-	size_t ret = 0;
+	elektraFree (ks->treeIndex);
+	ks->treeIndex = 0;
+}
 
-	if (length < 0) return -1;
-	if (ks->size < to) return -1;
+/**
+ * @internal
+ *
+ * @return the number of parts of the name of @p key, 1 for the root
+ *         of a namespace
+ */
+static size_t elektraKsLevel(const Key *key)
+{
+	const char *name = key->key + key->keySize;
+	size_t level = 0;
 
-	ks->size = ks->size + sizediff;
-	ret = elektraMemmove(ks->array + to, ks->array + from, length);
-	ks->array[ks->size] = 0;
-	return ret;
+	for (size_t i=0; i<key->keyUSize; ++i)
+	{
+		if (!name[i]) ++ level;
+	}
+	return level;
 }
 
 /**
- * Cuts out a keyset at the cutpoint.
+ * @internal
  *
- * Searches for the cutpoint inside the KeySet ks.
- * If found it cuts out everything which is below (see keyIsBelow()) this key.
- * These keys will be missing in the keyset @p ks.
- * Instead, they will be moved to the returned keyset.
- * If @p cutpoint is not found an empty keyset is returned and @p ks
- * is not changed.
- *
- * The cursor will stay at the same key as it was before.
- * If the cursor was inside the region of cut (moved)
- * keys, the cursor will be set to the key before
- * the cutpoint.
+ * @return 1 if the unescaped names of @p key and @p other are the
+ *         same, i.e. they only differ by their owner, 0 otherwise
+ */
+static int elektraKsSameName(const Key *key, const Key *other)
+{
+	return key->keyUSize == other->keyUSize &&
+		!memcmp(key->key + key->keySize,
+			other->key + other->keySize, key->keyUSize);
+}
+
+/**
+ * @internal
  *
- * If you use ksCut() on a keyset you got from kdbGet() and plan to make
- * a kdbSet() later, make sure that you keep all keys that should not
- * be removed permanently. You have to keep the KeySet that was returned
- * and the KeySet @p ks.
+ * (Re)builds the tree index for all keys of the keyset.
  *
- * @par Example:
+ * The keys below a key are next to each other in the sorted array,
+ * so the end of them is found by hopping over the keys below the
+ * keys following it. Going backwards these ends are already known,
+ * and every key is hopped over only once.
  *
- * You have the keyset @p ks:
- * - @p system/mountpoint/interest
- * - @p system/mountpoint/interest/folder
- * - @p system/mountpoint/interest/folder/key1
- * - @p system/mountpoint/interest/folder/key2
- * - @p system/mountpoint/other/key1
+ * @pre the keyset is sorted
+ * @retval 1 on success
+ * @retval -1 on memory error (no index afterwards)
+ */
+static int elektraKsTreeIndexBuild(KeySet *ks)
+{
+	elektraKsTreeIndexDrop(ks);
+	KeySetTreeEntry *index = elektraMalloc (sizeof(KeySetTreeEntry) * (ks->size+1));
+	if (!index) return -1;
+
+	for (size_t i=ks->size; i-- > 0;)
+	{
+		size_t end = i+1;
+		while (end < ks->size &&
+			!elektraKsCompareBelow(ks->array[i], ks->array[end]))
+		{
+			end = index[end].end;
+		}
+		index[i].end = end;
+		index[i].level = elektraKsLevel(ks->array[i]);
+	}
+
+	ks->treeIndex = index;
+	return 1;
+}
+
+/**
+ * @internal
  *
- * When you use
- * @snippet cut.c cut
+ * @return the first position from @p pos to (excluding) @p end with
+ *         a key of @p level, skipping the keys below keys of higher
+ *         levels, or -1
+ */
+static cursor_t elektraKsTreeLevelFrom(const KeySet *ks, size_t pos,
+		size_t end, size_t level)
+{
+	while (pos < end)
+	{
+		const KeySetTreeEntry *entry = &ks->treeIndex[pos];
+		if (entry->level == level) return pos;
+		pos = entry->level < level ? pos+1 : entry->end;
+	}
+	return -1;
+}
+
+/**
+ * @internal
  *
- * Then in @p returned are:
- * - @p system/mountpoint/interest
- * - @p system/mountpoint/interest/folder
- * - @p system/mountpoint/interest/folder/key1
- * - @p system/mountpoint/interest/folder/key2
+ * Makes sure that the tree index is there.
  *
- * And in @p ks are:
- * - @p system/mountpoint/other/key1
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+static int elektraKsTreeIndexPrepare(KeySet *ks)
+{
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+	if (ks->treeIndex) return 0;
+	return elektraKsTreeIndexBuild(ks) == -1 ? -1 : 0;
+}
+
+
+
+/**
+ * @internal
  *
- * So kdbSet() permanently removes all keys below
- * @p system/mountpoint/interest.
+ * Drops the lazily built indices ignoring case and of the tree.
+ * The next lookup needing one of them builds it again.
  *
- * @see kdbGet() for explanation why you might get more keys than you
- * requested.
+ * Must be called whenever keys are added to or removed from the
+ * array or change their positions. The hash index is kept up to date
+ * by its own functions instead, ksClearIndex() drops it, too.
  *
- * @return a new allocated KeySet which needs to deleted with ksDel().
- *         The keyset consists of all keys (of the original keyset ks)
- *         below the cutpoint. If the key cutpoint exists, it will
- *         also be appended.
- * @retval 0 on null pointers, no key name or allocation problems
- * @param ks the keyset to cut. It will be modified by removing
- *           all keys below the cutpoint.
- *           The cutpoint itself will also be removed.
- * @param cutpoint the point where to cut out the keyset
+ * @param ks the keyset to work with
  */
-KeySet *ksCut(KeySet *ks, const Key *cutpoint)
+static void elektraKsClearLazyIndex(KeySet *ks)
 {
-	KeySet *returned = 0;
-	size_t found = 0;
-	size_t it = 0;
-	size_t newsize = 0;
-	int set_cursor = 0;
+	elektraKsCaseIndexDrop(ks);
+	elektraKsTreeIndexDrop(ks);
+}
 
-	if (!ks) return 0;
-	if (!cutpoint) return 0;
 
-	char *name = cutpoint->key;
-	if (!name) return 0;
-	// if (strcmp(name, "")) return 0;
 
-	if (name[0] == '/')
+/*******************************************
+ *      Hash index for exact lookups       *
+ *******************************************/
+
+/**
+ * @internal
+ *
+ * Hash over the unescaped name of a key.
+ *
+ * @see elektraKeyNameCache()
+ */
+static kdb_unsigned_long_long_t elektraKsHashName(const Key *key)
+{
+	return key->nameHash;
+}
+
+/**
+ * @internal
+ *
+ * Hash over the bytes of a value up to the first null byte.
+ *
+ * @param value the value, may be 0 if size is 0
+ * @param size the maximum number of bytes to hash
+ */
+kdb_unsigned_long_long_t elektraKsHashValue(const char *value, size_t size)
+{
+	kdb_unsigned_long_long_t hash = 14695981039346656037ULL; // FNV-1a
+
+	for (size_t i=0; i<size && value[i]; ++i)
 	{
-		Key *key = (Key *) cutpoint;
-		size_t size = key->keySize;
-		size_t usize = key->keyUSize;
-		size_t length = strlen (name) + ELEKTRA_MAX_NAMESPACE_SIZE;
-		char newname[length*2];
+		hash ^= (unsigned char)value[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
 
-		KeySet *ret = ksNew(0, KS_END);
+/**
+ * @internal
+ *
+ * Inserts the key at position pos into the hash index.
+ *
+ * @pre the hash index has a free slot
+ */
+static void elektraKsHashInsertAt(KeySet *ks, size_t pos)
+{
+	const size_t mask = ks->hashAlloc-1;
+	const Key *key = ks->array[pos];
+	kdb_unsigned_long_long_t hash = elektraKsHashName(key);
+	size_t slot = hash & mask;
 
-		for (elektraNamespace ns=KEY_NS_FIRST; ns<=KEY_NS_LAST; ++ns)
-		{
-			int validNS = 1;
-		switch (ns)
+	while (ks->hashTable[slot].pos)
+	{
+		if (test_bit(ks->flags, KS_FLAG_UNSORTED) &&
+			ks->hashTable[slot].hash == hash)
 		{
-		case KEY_NS_SPEC:
-			strncpy (newname+2, "spec", 4);
-			strcpy  (newname+6, name);
-			key->key = newname+2;
-			key->keySize = length-2;
-			if (!strcmp(name, "/")) key->keySize = 5;
-			elektraFinalizeName(key);
-			break;
-		case KEY_NS_PROC:
-			strncpy (newname+2, "proc", 4);
-			strcpy  (newname+6, name);
-			key->key = newname+2;
-			key->keySize = length-2;
-			if (!strcmp(name, "/")) key->keySize = 5;
-			elektraFinalizeName(key);
-			break;
-		case KEY_NS_DIR:
-			strncpy (newname+3, "dir", 3);
-			strcpy  (newname+6, name);
-			key->key = newname+3;
-			key->keySize = length-3;
-			if (!strcmp(name, "/")) key->keySize = 4;
-			elektraFinalizeName(key);
-			break;
-		case KEY_NS_USER:
-			strncpy (newname+2, "user", 4);
-			strcpy  (newname+6, name);
-			key->key = newname+2;
-			key->keySize = length-2;
-			if (!strcmp(name, "/")) key->keySize = 5;
-			elektraFinalizeName(key);
-			break;
-		case KEY_NS_SYSTEM:
-			strncpy (newname, "system",6);
-			strcpy  (newname+6, name);
-			key->key = newname;
-			key->keySize = length;
-			if (!strcmp(name, "/")) key->keySize = 7;
-			elektraFinalizeName(key);
-			break;
-		case KEY_NS_EMPTY:
-		case KEY_NS_NONE:
-		case KEY_NS_META:
-		case KEY_NS_CASCADING:
-			validNS = 0;
-		}
-			if (validNS)
+			/* Keys appended unsorted may have the same name,
+			 * the last one will win in elektraKsSort() */
+			const Key *cur = ks->array[ks->hashTable[slot].pos-1];
+			if (cur->keyUSize == key->keyUSize &&
+				!memcmp(cur->key + cur->keySize,
+					key->key + key->keySize, key->keyUSize))
 			{
-				KeySet * n = ksCut(ks, key);
-				ksAppend(ret, n);
-				ksDel(n);
+				break;
 			}
 		}
+		slot = (slot+1) & mask;
+	}
+	ks->hashTable[slot].hash = hash;
+	ks->hashTable[slot].pos = pos+1;
+}
 
-		// restore old cascading name
-		key->key = name;
-		key->keySize = size;
-		key->keyUSize = usize ;
-		return ret;
+/**
+ * @internal
+ *
+ * (Re)builds the hash index for all keys of the keyset.
+ *
+ * @retval 1 on success
+ * @retval -1 on memory error (no index afterwards)
+ */
+static int elektraKsHashBuild(KeySet *ks)
+{
+	size_t alloc = KEYSET_SIZE * 2;
+	while (alloc < ks->size * 2 + 2) alloc *= 2;
+
+	elektraFree (ks->hashTable);
+	ks->hashTable = elektraCalloc (sizeof(KeySetHashEntry) * alloc);
+	if (!ks->hashTable)
+	{
+		ks->hashAlloc = 0;
+		return -1;
 	}
+	ks->hashAlloc = alloc;
 
-	// search the cutpoint
-	while (it < ks->size && keyIsBelowOrSame(cutpoint, ks->array[it]) == 0)
+	for (size_t i=0; i<ks->size; ++i)
 	{
-		++it;
+		elektraKsHashInsertAt(ks, i);
 	}
 
-	// we found nothing
-	if (it == ks->size) return ksNew(0, KS_END);
+	return 1;
+}
 
-	// we found the cutpoint
-	found = it;
+/**
+ * @internal
+ *
+ * Keeps the hash index up to date after a key was
+ * appended at the very end of the array.
+ * The other indices are dropped.
+ */
+static void elektraKsHashAppended(KeySet *ks)
+{
+	elektraKsClearLazyIndex(ks);
+	if (!ks->hashTable) return;
 
-	// search the end of the keyset to cut
-	while (it < ks->size && keyIsBelowOrSame(cutpoint, ks->array[it]) == 1)
+	if (ks->size * 2 + 2 > ks->hashAlloc)
 	{
-		++it;
+		elektraKsHashBuild(ks);
+		return;
 	}
 
-	// correct cursor if cursor is in cutted keyset
-	if (ks->current >= found && ks->current < it)
+	elektraKsHashInsertAt(ks, ks->size-1);
+}
+
+/**
+ * @internal
+ *
+ * Removes the key at position pos from the hash index.
+ *
+ * Uses backward shift deletion, so that no tombstones
+ * are needed.
+ *
+ * The other indices are dropped.
+ *
+ * @pre the position is not used by any other key anymore
+ */
+static void elektraKsHashRemoveAt(KeySet *ks, size_t pos)
+{
+	elektraKsClearLazyIndex(ks);
+	if (!ks->hashTable) return;
+
+	const size_t mask = ks->hashAlloc-1;
+	size_t slot = elektraKsHashName(ks->array[pos]) & mask;
+
+	while (ks->hashTable[slot].pos != pos+1)
 	{
-		if (found == 0)
-		{
-			ksRewind(ks);
-		}
-		else
+		if (!ks->hashTable[slot].pos)
 		{
-			ks->current = found - 1;
-			set_cursor = 1;
+			ELEKTRA_ASSERT(0 && "key to remove not in hash index");
+			return;
 		}
+		slot = (slot+1) & mask;
 	}
 
-	// correct the cursor for the keys after the cutted keyset
-	if (ks->current >= it)
+	size_t next = (slot+1) & mask;
+	while (ks->hashTable[next].pos)
 	{
-		if (it >= ks->size)
+		size_t home = ks->hashTable[next].hash & mask;
+		// move entry back if its home is not between slot and next
+		if (((next - home) & mask) >= ((next - slot) & mask))
 		{
-			ksRewind(ks);
-		}
-		else
-		{
-			ks->current = found + ks->current - it;
-			set_cursor = 1;
+			ks->hashTable[slot] = ks->hashTable[next];
+			slot = next;
 		}
+		next = (next+1) & mask;
 	}
+	ks->hashTable[slot].pos = 0;
+}
 
-	newsize = it-found;
-
-	returned = ksNew(newsize, KS_END);
-	elektraMemcpy (returned->array, ks->array+found, newsize);
-	returned->size = newsize;
-	returned->array[returned->size] = 0;
+/**
+ * @internal
+ *
+ * Looks up the position of a key with the same unescaped name.
+ *
+ * @return the position of the key
+ * @retval -1 if no such key is in the keyset
+ */
+static ssize_t elektraKsHashLookup(const KeySet *ks, const Key *key)
+{
+	const size_t mask = ks->hashAlloc-1;
+	kdb_unsigned_long_long_t hash = elektraKsHashName(key);
+	const void *name = key->key + key->keySize;
+	size_t slot = hash & mask;
 
-	if (ksCopyInternal(ks, found, it) == -1)
+	while (ks->hashTable[slot].pos)
 	{
-		ELEKTRA_ASSERT(0 && "ksCopyInternal returned an error inside ksCut");
+		if (ks->hashTable[slot].hash == hash)
+		{
+			const Key *cur = ks->array[ks->hashTable[slot].pos-1];
+			if (cur->keyUSize == key->keyUSize &&
+				!memcmp(cur->key + cur->keySize, name, key->keyUSize))
+			{
+				return ks->hashTable[slot].pos-1;
+			}
+		}
+		slot = (slot+1) & mask;
 	}
 
-	if (set_cursor) ks->cursor = ks->array[ks->current];
-
-	return returned;
+	return -1;
 }
 
-
-
-
 /**
- * Remove and return the last key of @p ks.
+ * @internal
  *
- * The reference counter will be decremented by one.
+ * Drops the hash index together with the other lookup indices,
+ * but keeps the namespace ranges and sort keys.
  *
- * The KeySets cursor will not be effected if it did not
- * point to the popped key.
+ * @param ks the keyset to work with
+ */
+void ksClearHashIndex(KeySet *ks)
+{
+	elektraKsClearLazyIndex(ks);
+	elektraFree (ks->hashTable);
+	ks->hashTable = 0;
+	ks->hashAlloc = 0;
+	ks->hashMisses = 0;
+}
+
+/**
+ * @internal
  *
- * @note You need to keyDel() the key afterwards, if
- * you don't append it to another keyset. It has the
- * same semantics like a key allocated with keyNew()
- * or keyDup().
+ * Drops all lazily built lookup indices.
  *
- *@code
-ks1=ksNew(0, KS_END);
-ks2=ksNew(0, KS_END);
+ * Must be called whenever positions of keys in the array are changed
+ * in another way than inserting or popping single keys.
+ *
+ * @param ks the keyset to work with
+ */
+void ksClearIndex(KeySet *ks)
+{
+	ksClearHashIndex(ks);
+	clear_bit(ks->flags, KS_FLAG_RANGES);
+	clear_bit(ks->flags, KS_FLAG_SORTKEYS);
+}
 
-k1=keyNew("user/name", KEY_END); // ref counter 0
-ksAppendKey(ks1, k1); // ref counter 1
-ksAppendKey(ks2, k1); // ref counter 2
 
-k1=ksPop (ks1); // ref counter 1
-k1=ksPop (ks2); // ref counter 0, like after keyNew()
 
-ksAppendKey(ks1, k1); // ref counter 1
+/*******************************************
+ *           Namespace ranges              *
+ *******************************************/
 
-ksDel (ks1); // key is deleted too
-ksDel (ks2);
- *@endcode
+/**
+ * @internal
  *
- * @return the last key of @p ks
- * @return NULL if @p ks is empty or on NULL pointer
- * @param ks KeySet to work with
- * @see ksAppendKey(), ksAppend()
- * @see commandList() for an example
+ * The namespaces with a range, in the order they are sorted in.
+ * The first part of their unescaped names is compared.
+ */
+static const char * const elektraKsNamespaces[KEYSET_NAMESPACES] =
+	{"", "dir", "proc", "spec", "system", "user"};
+
+/**
+ * @internal
  *
+ * @return the first part of the unescaped name of key, e.g. the namespace
  */
-Key *ksPop(KeySet *ks)
+static const char *elektraKsFirstPart(const Key *key)
 {
-	Key *ret=0;
+	return key->keyUSize ? key->key + key->keySize : "";
+}
 
-	if (!ks) return 0;
+/**
+ * @internal
+ *
+ * @return the index of the namespace of key in nsRanges
+ * @retval -1 if the namespace has no range, e.g. for meta keys
+ */
+static int elektraKsNamespaceIndex(const Key *key)
+{
+	const char *part = elektraKsFirstPart(key);
 
-	ks->flags |= KS_FLAG_SYNC;
+	switch (part[0])
+	{
+	case 0: return 0;
+	case 'd': return strcmp(part, "dir") ? -1 : 1;
+	case 'p': return strcmp(part, "proc") ? -1 : 2;
+	case 's':
+		if (!strcmp(part, "spec")) return 3;
+		return strcmp(part, "system") ? -1 : 4;
+	case 'u': return strcmp(part, "user") ? -1 : 5;
+	}
+	return -1;
+}
 
-	if (ks->size <= 0) return 0;
+/**
+ * @internal
+ *
+ * Binary search for the first position from left on, where the first
+ * part of the unescaped name is not less than namespace, or with
+ * after, is greater than namespace.
+ */
+static size_t elektraKsNamespaceBound(const KeySet *ks, size_t left,
+		const char *namespace, int after)
+{
+	size_t right = ks->size;
 
-	-- ks->size;
-	if (ks->size+1 < ks->alloc/2) ksResize (ks, ks->alloc / 2-1);
-	ret = ks->array[ks->size];
-	ks->array[ks->size] = 0;
-	keyDecRef(ret);
+	while (left < right)
+	{
+		const size_t middle = left + (right-left)/2;
+		const int cmpresult = strcmp(elektraKsFirstPart(ks->array[middle]),
+				namespace);
+		if (cmpresult < 0 || (after && cmpresult == 0)) left = middle+1;
+		else right = middle;
+	}
 
-	return ret;
+	return left;
 }
 
+/**
+ * @internal
+ *
+ * Computes the ranges of all namespaces.
+ *
+ * @pre the keyset is sorted
+ */
+static void elektraKsRangesBuild(KeySet *ks)
+{
+	size_t begin = 0;
 
-/*******************************************
- *           KeySet browsing methods       *
- *******************************************/
-
+	for (int i=0; i<KEYSET_NAMESPACES; ++i)
+	{
+		begin = elektraKsNamespaceBound(ks, begin, elektraKsNamespaces[i], 0);
+		ks->nsRanges[i].begin = begin;
+		begin = elektraKsNamespaceBound(ks, begin, elektraKsNamespaces[i], 1);
+		ks->nsRanges[i].end = begin;
+	}
 
+	set_bit(ks->flags, KS_FLAG_RANGES);
+}
 
 /**
- * Rewinds the KeySet internal cursor.
- *
- * Use it to set the cursor to the beginning of the KeySet.
- * ksCurrent() will then always return NULL afterwards. So
- * you want to ksNext() first.
+ * @internal
  *
- * @code
-ksRewind (ks);
-while ((key = ksNext (ks))!=0) {}
- * @endcode
+ * Keeps the ranges up to date after count keys with the same
+ * first part of the unescaped name as key were inserted, or
+ * with a negative count, popped.
  *
- * @param ks the keyset object to work with
- * @return 0 on success
- * @return -1 on NULL pointer
- * @see ksNext(), ksCurrent()
+ * Keys of other namespaces are sorted in between the ranges,
+ * so they only move the ranges behind them.
  */
-int ksRewind(KeySet *ks)
+static void elektraKsRangesChanged(KeySet *ks, const Key *key, ssize_t count)
 {
-	if (!ks) return -1;
+	if (!test_bit(ks->flags, KS_FLAG_RANGES)) return;
 
-	ks->cursor=0;
-	ks->current=0;
-	return 0;
-}
+	const char *part = elektraKsFirstPart(key);
 
+	for (int i=0; i<KEYSET_NAMESPACES; ++i)
+	{
+		const int cmpresult = strcmp(elektraKsNamespaces[i], part);
+		if (cmpresult > 0) ks->nsRanges[i].begin += count;
+		if (cmpresult >= 0) ks->nsRanges[i].end += count;
+	}
+}
 
 /**
- * Returns the next Key in a KeySet.
- *
- * KeySets have an internal cursor that can be reset with ksRewind(). Every
- * time ksNext() is called the cursor is incremented and the new current Key
- * is returned.
+ * @internal
  *
- * You'll get a NULL pointer if the key after the end of the KeySet was reached.
- * On subsequent calls of ksNext() it will still return the NULL pointer.
+ * Like elektraKsRange(), but only uses ranges which are
+ * already computed.
+ */
+static int elektraKsRangeConst(const KeySet *ks, const Key *key, size_t *begin, size_t *end)
+{
+	*begin = 0;
+	*end = ks->size;
+
+	if (!test_bit(ks->flags, KS_FLAG_RANGES)) return 0;
+
+	const int index = elektraKsNamespaceIndex(key);
+	if (index == -1) return 0;
+
+	*begin = ks->nsRanges[index].begin;
+	*end = ks->nsRanges[index].end;
+
+	return 1;
+}
+
+/**
+ * @internal
  *
- * The @p ks internal cursor will be changed, so it is not const.
+ * Gets the positions in the array where keys with the same
+ * namespace as key are, the ranges are computed on demand.
  *
- * @note You must not delete or change the key, use ksPop() if you want to delete it.
+ * Small or unsorted keysets and keys of namespaces without
+ * a range always get the whole array.
  *
- * @param ks the keyset object to work with
- * @return the new current Key
- * @return 0 when the end is reached
- * @return 0 on NULL pointer
- * @see ksRewind(), ksCurrent()
+ * @retval 1 if a namespace range was found
+ * @retval 0 if it is the whole array
  */
-Key *ksNext(KeySet *ks)
+static int elektraKsRange(KeySet *ks, const Key *key, size_t *begin, size_t *end)
 {
-	if (!ks) return 0;
+	if (!test_bit(ks->flags, KS_FLAG_RANGES) &&
+		ks->size >= KEYSET_RANGES_MIN_SIZE &&
+		!test_bit(ks->flags, KS_FLAG_UNSORTED))
+	{
+		elektraKsRangesBuild(ks);
+	}
 
-	if (ks->size == 0) return 0;
-	if (ks->current >= ks->size)
+	if (ks->size < KEYSET_RANGES_MIN_SIZE)
 	{
+		*begin = 0;
+		*end = ks->size;
 		return 0;
 	}
 
-	if (ks->cursor) ks->current++;
-	return ks->cursor = ks->array[ks->current];
+	return elektraKsRangeConst(ks, key, begin, end);
 }
 
+/**
+ * @internal
+ *
+ * @return the eight bytes of the unescaped name of key starting
+ *         at offset, packed like Key::namePrefix
+ */
+static kdb_unsigned_long_long_t elektraKsSortKeyAt(const Key *key, size_t offset)
+{
+	if (offset == 0) return key->namePrefix;
 
+	const unsigned char *name = (const unsigned char *)key->key + key->keySize;
+	kdb_unsigned_long_long_t sortKey = 0;
 
+	for (size_t i=offset; i<offset+sizeof(sortKey); ++i)
+	{
+		sortKey <<= 8;
+		if (i < key->keyUSize) sortKey |= name[i];
+	}
+	return sortKey;
+}
 
 /**
- * Return the current Key.
+ * @internal
  *
- * The pointer is NULL if you reached the end or after
- * ksRewind().
+ * Computes the sort key of key, see KeySet::sortKeys.
  *
- * @note You must not delete the key or change the key,
- *    use ksPop() if you want to delete it.
+ * @param ref a key in ks other than key, to check if key starts
+ *        with the prefix all names in ks share
+ * @retval 1 if sortKey was set
+ * @retval 0 if there are no sort keys or key does not start
+ *         with the shared prefix
+ */
+static int elektraKsSortKey(const KeySet *ks, const Key *key,
+		const Key *ref, kdb_unsigned_long_long_t *sortKey)
+{
+	if (!test_bit(ks->flags, KS_FLAG_SORTKEYS)) return 0;
+	if (!key->key || key->keyUSize < ks->sortOffset) return 0;
+	if (memcmp(key->key + key->keySize, ref->key + ref->keySize,
+				ks->sortOffset)) return 0;
+
+	*sortKey = elektraKsSortKeyAt(key, ks->sortOffset);
+	return 1;
+}
+
+/**
+ * @internal
  *
- * @param ks the keyset object to work with
- * @return pointer to the Key pointed by @p ks's cursor
- * @return 0 on NULL pointer
- * @see ksNext(), ksRewind()
+ * Computes the sort keys of all keys in ks.
+ *
+ * Like the names, the sort keys are sorted then. Names which
+ * differ in their sort keys are ordered like their sort keys.
+ *
+ * @retval 1 on success
+ * @retval 0 if ks is too small or not sorted
+ * @retval -1 on memory error
  */
-Key *ksCurrent(const KeySet *ks)
+static int elektraKsSortKeysBuild(KeySet *ks)
 {
-	if (!ks) return 0;
+	if (ks->size < KEYSET_SORTKEYS_MIN_SIZE) return 0;
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) return 0;
 
-	return ks->cursor;
+	if (ks->sortAlloc < ks->alloc)
+	{
+		elektraFree (ks->sortKeys);
+		ks->sortKeys = elektraMalloc (sizeof(kdb_unsigned_long_long_t) * ks->alloc);
+		ks->sortAlloc = ks->sortKeys ? ks->alloc : 0;
+		if (!ks->sortKeys) return -1;
+	}
+
+	// names between the first and the last key share their prefix
+	const Key *first = ks->array[0];
+	const Key *last = ks->array[ks->size-1];
+	const char *name1 = first->key + first->keySize;
+	const char *name2 = last->key + last->keySize;
+	size_t offset = 0;
+	while (offset < first->keyUSize && offset < last->keyUSize &&
+			name1[offset] == name2[offset]) ++offset;
+
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		ks->sortKeys[i] = elektraKsSortKeyAt(ks->array[i], offset);
+	}
+	ks->sortOffset = offset;
+
+	set_bit(ks->flags, KS_FLAG_SORTKEYS);
+	return 1;
 }
 
+/**
+ * @internal
+ *
+ * Keeps the sort keys up to date after a key was
+ * inserted at position pos in the array.
+ *
+ * They are dropped if the key does not start with
+ * the shared prefix.
+ */
+static void elektraKsSortKeysInserted(KeySet *ks, size_t pos)
+{
+	kdb_unsigned_long_long_t sortKey;
+
+	if (!test_bit(ks->flags, KS_FLAG_SORTKEYS)) return;
+
+	if (ks->size < 2 || !elektraKsSortKey(ks, ks->array[pos],
+				ks->array[pos ? 0 : 1], &sortKey))
+	{
+		clear_bit(ks->flags, KS_FLAG_SORTKEYS);
+		return;
+	}
+
+	if (ks->sortAlloc < ks->size)
+	{
+		size_t alloc = ks->alloc > ks->size ? ks->alloc : ks->size;
+		if (elektraRealloc ((void**) &ks->sortKeys,
+				sizeof(kdb_unsigned_long_long_t) * alloc) == -1)
+		{
+			clear_bit(ks->flags, KS_FLAG_SORTKEYS);
+			return;
+		}
+		ks->sortAlloc = alloc;
+	}
 
+	memmove(ks->sortKeys+pos+1, ks->sortKeys+pos,
+		(ks->size-1-pos) * sizeof(kdb_unsigned_long_long_t));
+	ks->sortKeys[pos] = sortKey;
+}
+
+/**
+ * @internal
+ *
+ * Compares the unescaped names of key and parent, but
+ * keys below parent are equal to it.
+ *
+ * @retval <0 if key is sorted before parent
+ * @retval 0 if key is below or the same as parent
+ * @retval >0 if key is sorted after all keys below parent
+ */
+static int elektraKsCompareBelow(const Key *parent, const Key *key)
+{
+	const size_t size = key->keyUSize < parent->keyUSize ?
+		key->keyUSize : parent->keyUSize;
+	const int ret = memcmp(key->key + key->keySize,
+			parent->key + parent->keySize, size);
 
+	if (ret) return ret;
+	return key->keyUSize < parent->keyUSize ? -1 : 0;
+}
 
 /**
- * Return the first key in the KeySet.
+ * @internal
  *
- * The KeySets cursor will not be effected.
+ * Narrows the positions from begin to (excluding) end to the keys
+ * below or the same as parent, see keyIsBelowOrSame().
  *
- * If ksCurrent()==ksHead() you know you are
- * on the first key.
+ * The unescaped names of these keys start with the whole unescaped
+ * name of parent, so they are next to each other in the array and
+ * two binary searches find them.
  *
- * @param ks the keyset object to work with
- * @return the first Key of a keyset
- * @return 0 on NULL pointer or empty keyset
- * @see ksTail() for the last key
- * @see ksRewind(), ksCurrent() and ksNext() for iterating over the keyset
+ * @pre ks is sorted and parent has a name with at least one part,
+ *      i.e. is not "" or "/"
  */
-Key *ksHead(const KeySet *ks)
+static void elektraKsBelowRange(const KeySet *ks, const Key *parent,
+		size_t *begin, size_t *end)
 {
-	if (!ks) return 0;
+	size_t left = *begin;
+	size_t right = *end;
 
-	if (ks->size > 0) return ks->array[0];
-	else return 0;
+	while (left < right)
+	{
+		const size_t middle = left + (right-left)/2;
+		if (elektraKsCompareBelow(parent, ks->array[middle]) < 0) left = middle+1;
+		else right = middle;
+	}
+	*begin = left;
+
+	right = *end;
+	while (left < right)
+	{
+		const size_t middle = left + (right-left)/2;
+		if (elektraKsCompareBelow(parent, ks->array[middle]) <= 0) left = middle+1;
+		else right = middle;
+	}
+	*end = left;
 }
 
 
+/******************************************* 
+ *           Filling up KeySets            *
+ *******************************************/
 
+static ssize_t elektraKsSearchRange(const KeySet *ks, const Key *toAppend,
+		size_t begin, size_t end);
+static ssize_t elektraKsSearchRangeWith(const KeySet *ks, const Key *toAppend,
+		size_t begin, size_t end, int (*compare)(const void *, const void *));
 
 
 /**
- * Return the last key in the KeySet.
- *
- * The KeySets cursor will not be effected.
+ * @internal
  *
- * If ksCurrent()==ksTail() you know you
- * are on the last key. ksNext() will return
- * a NULL pointer afterwards.
+ * Binary search in a keyset that informs where key should be inserted.
  *
- * @param ks the keyset object to work with
- * @return the last Key of a keyset
- * @return 0 on NULL pointer or empty keyset
- * @see ksHead() for the first key
- * @see ksRewind(), ksCurrent() and ksNext() for iterating over the keyset
- */
-Key *ksTail(const KeySet *ks)
+ * @code
+
+ssize_t result = ksSearchInternal(ks, toAppend);
+
+if (result >= 0)
 {
-	if (!ks) return 0;
+	ssize_t position = result;
+	// Seems like the key already exist.
+} else {
+	ssize_t insertpos = -result-1;
+	// Seems like the key does not exist.
+}
+ * @endcode
+ *
+ * @param ks the keyset to work with
+ * @param toAppend the key to check
+ * @return position where the key is (>=0) if the key was found
+ * @return -insertpos -1 (< 0) if the key was not found 
+ *    so to get the insertpos simple do: -insertpos -1
+ */
+ssize_t ksSearchInternal(const KeySet *ks, const Key *toAppend)
+{
+	return elektraKsSearchRange(ks, toAppend, 0, ks->size);
+}
+
+/**
+ * @internal
+ *
+ * Like ksSearchInternal(), but only searches the positions
+ * from begin to (excluding) end.
+ *
+ * @pre toAppend belongs between begin and end, e.g. they are
+ *      the range of its namespace
+ */
+static ssize_t elektraKsSearchRange(const KeySet *ks, const Key *toAppend,
+		size_t begin, size_t end)
+{
+	return elektraKsSearchRangeWith(ks, toAppend, begin, end,
+			keyCompareByNameOwner);
+}
+
+/**
+ * @internal
+ *
+ * Like elektraKsSearchRange(), but compares with compare.
+ *
+ * If the sort keys are up to date only keys with the same
+ * sort key are compared.
+ *
+ * @param compare keyCompareByNameOwner() or keyCompareByName()
+ */
+static ssize_t elektraKsSearchRangeWith(const KeySet *ks, const Key *toAppend,
+		size_t begin, size_t end, int (*compare)(const void *, const void *))
+{
+	kdb_unsigned_long_long_t sortKey = 0;
+	const int sorted = ks->size > 0 &&
+		elektraKsSortKey(ks, toAppend, ks->array[0], &sortKey);
+	ssize_t left = begin;
+	ssize_t right = (ssize_t)end-1;
+	register int cmpresult = 1;
+	ssize_t middle = -1;
+	ssize_t insertpos = begin;
+#if DEBUG && VERBOSE
+	int c=0;
+#endif
+
+
+	while(1)
+	{
+#if DEBUG && VERBOSE
+		++c;
+#endif
+		if (right < left)
+		{
+			/* Nothing was found */
+			break;
+		}
+		middle = left + ((right-left)/2);
+		if (sorted && ks->sortKeys[middle] != sortKey)
+		{
+			cmpresult = sortKey < ks->sortKeys[middle] ? -1 : 1;
+		}
+		else cmpresult = compare(&toAppend, &ks->array[middle]);
+		if (cmpresult > 0)
+		{
+			insertpos = left = middle + 1;
+		} else if (cmpresult == 0)
+		{
+			/* We have found it */
+			break;
+		} else {
+			insertpos = middle;
+			right = middle - 1;
+		}
+#if DEBUG && VERBOSE
+		/* This is even for verbose too verbose!
+		printf ("bsearch -- c: %d res: %d left: %zd middle: %zd right: %zd insertpos: %zd\n",
+			c, cmpresult, left, middle, right, insertpos);
+		*/
+#endif
+	}
+
+	if (!cmpresult)
+	{
+		return middle;
+	} else {
+		return -insertpos - 1;
+	}
+}
+
+/**
+ * Appends a Key to the end of @p ks.
+ *
+ * Will take ownership of the key @p toAppend.
+ * That means ksDel(ks) will remove the key unless
+ * the key:
+ * - was duplicated before inserting
+ * - got its refcount incremented by keyIncRef() before inserting
+ * - was also inserted into another keyset with ksAppendKey()
+ *
+ * The reference counter of the key will be incremented
+ * to show this ownership, and thus @p toAppend is not const.
+ *
+ * @copydetails doxygenFlatCopy
+ *
+ * @see keyGetRef().
+ *
+ * If the keyname already existed in the keyset, it will be replaced with
+ * the new key.
+ *
+ * The KeySet internal cursor will be set to the new key.
+ *
+ * It is save to directly append newly created keys:
+ * @snippet keyset.c simple append
+ *
+ * If you want the key to outlive the keyset, make sure to
+ * do proper ref counting:
+ * @snippet keyset.c ref append
+ *
+ * Or if you want to avoid aliasing at all, you can duplicate the key.
+ * But then key in the keyset has another identity:
+ * @snippet keyset.c dup append
+ *
+ *
+ * @return the size of the KeySet after insertion
+ * @return -1 on NULL pointers
+ * @return -1 if insertion failed, the key will be deleted then.
+ * @param ks KeySet that will receive the key
+ * @param toAppend Key that will be appended to ks or deleted
+ * @see ksAppend(), keyNew(), ksDel()
+ * @see keyIncRef()
+ *
+ */
+ssize_t ksAppendKey(KeySet *ks, Key *toAppend)
+{
+	ssize_t result = -1;
+
+	if (!ks) return -1;
+	if (!toAppend) return -1;
+	if (!toAppend->key)
+	{
+		// needed for ksAppendKey(ks, keyNew(0))
+		keyDel (toAppend);
+		return -1;
+	}
+	if (test_bit(ks->flags, KS_FLAG_FROZEN))
+	{
+		keyDel (toAppend);
+		return -1;
+	}
+
+	keyLock(toAppend, KEY_LOCK_NAME);
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+
+	size_t begin, end;
+	elektraKsRange(ks, toAppend, &begin, &end);
+	if (!test_bit(ks->flags, KS_FLAG_SORTKEYS)) elektraKsSortKeysBuild(ks);
+	result = elektraKsSearchRange(ks, toAppend, begin, end);
+
+	if (result >= 0)
+	{
+		/* Seems like the key already exist. */
+		if (toAppend == ks->array[result])
+		{
+			/* user tried to insert the same key again */
+			return ks->size;
+		}
+
+		/* Pop the key in the result */
+		keyDecRef (ks->array[result]);
+		keyDel (ks->array[result]);
+
+		/* And use the other one instead */
+		keyIncRef (toAppend);
+		ks->array[result] = toAppend;
+		ksSetCursor(ks, result);
+	} else {
+		ssize_t insertpos = -result-1;
+
+		/* We want to append a new key
+		  in position insertpos */
+		++ ks->size;
+		if (ks->size >= ks->alloc) ksResize (ks, ks->alloc * 2-1);
+		keyIncRef (toAppend);
+
+		if (insertpos == (ssize_t)ks->size-1)
+		{
+			/* Append it to the very end */
+			ks->array[ks->size-1] = toAppend;
+			ks->array[ks->size] = 0;
+			ksSetCursor(ks, ks->size-1);
+			elektraKsHashAppended(ks);
+		} else {
+			size_t n = ks->size-insertpos;
+			ksClearHashIndex(ks);
+			memmove(ks->array+(insertpos+1), ks->array+insertpos, n*sizeof(struct Key*));
+			/*
+			printf ("memmove -- ks->size: %zd insertpos: %zd n: %zd\n",
+				ks->size, insertpos, n);
+			*/
+			ks->array[insertpos] = toAppend;
+			ksSetCursor(ks, insertpos);
+		}
+		elektraKsRangesChanged(ks, toAppend, 1);
+		elektraKsSortKeysInserted(ks, insertpos);
+	}
+
+	return ks->size;
+}
+
+
+
+/**
+ * @internal
+ *
+ * Merges the sorted array toAppend into the first size keys of ks
+ * in a single pass.
+ *
+ * Keys of toAppend replace equal keys of ks.
+ * The merged array replaces the array of ks, so toAppend
+ * may point into it.
+ *
+ * @param ks the keyset to merge into
+ * @param size how many keys of ks are part of the merge
+ * @param toAppend sorted array of keys without duplicates
+ * @param toAppendSize the number of keys in toAppend
+ * @param alloc the allocation size of the merged array
+ * @param owned if the keys of toAppend already hold a reference
+ *        for ks, otherwise their references will be incremented
+ *
+ * @return the position of the last key of toAppend
+ * @retval -1 on memory error, ks is unchanged then
+ */
+static ssize_t elektraKsMerge(KeySet *ks, size_t size, Key **toAppend,
+		size_t toAppendSize, size_t alloc, int owned)
+{
+	Key **array = elektraMalloc (sizeof(struct _Key *) * alloc);
+	if (!array) return -1;
+
+	size_t i = 0; // position in ks
+	size_t j = 0; // position in toAppend
+	size_t k = 0; // position in merged array
+	size_t last = 0; // position of last key from toAppend
+
+	while (i < size && j < toAppendSize)
+	{
+		int cmpresult = keyCompareByNameOwner(&ks->array[i],
+				&toAppend[j]);
+		if (cmpresult < 0)
+		{
+			array[k++] = ks->array[i++];
+			continue;
+		}
+
+		Key *key = toAppend[j++];
+		if (cmpresult == 0)
+		{
+			/* The key in toAppend replaces the key in ks */
+			Key *old = ks->array[i++];
+			if (old != key)
+			{
+				keyDecRef (old);
+				keyDel (old);
+				if (!owned) keyIncRef (key);
+			} else if (owned) {
+				keyDecRef (key);
+			}
+		} else if (!owned) {
+			keyIncRef (key);
+		}
+		last = k;
+		array[k++] = key;
+	}
+
+	while (i < size)
+	{
+		array[k++] = ks->array[i++];
+	}
+
+	while (j < toAppendSize)
+	{
+		if (!owned) keyIncRef (toAppend[j]);
+		last = k;
+		array[k++] = toAppend[j++];
+	}
+
+	array[k] = 0;
+
+	elektraFree (ks->array);
+	ks->array = array;
+	ks->alloc = alloc;
+	ks->size = k;
+
+	ksClearIndex(ks);
+
+	return last;
+}
+
+/**
+ * @internal
+ *
+ * Appends the sorted array toAppend to the sorted ks, keys of
+ * toAppend replace equal keys of ks.
+ *
+ * @return the size of ks afterwards
+ * @retval -1 on memory error
+ */
+static ssize_t elektraKsAppendSorted(KeySet *ks, Key **toAppend, size_t size)
+{
+	size_t toAlloc = 0;
+
+	/* Do only one resize in advance */
+	for (toAlloc = ks->alloc; ks->size+size >= toAlloc; toAlloc *= 2);
+
+	if (ks->size == 0 || keyCompareByNameOwner(&ks->array[ks->size-1],
+				&toAppend[0]) < 0)
+	{
+		/* All keys are behind the last one, so just copy them */
+		if (ksResize (ks, toAlloc-1) == -1) return -1;
+		clear_bit(ks->flags, KS_FLAG_RANGES);
+		elektraMemcpy (ks->array+ks->size, toAppend, size);
+		for (size_t i=0; i<size; ++i)
+		{
+			keyIncRef (ks->array[ks->size]);
+			++ ks->size;
+			elektraKsHashAppended(ks);
+			elektraKsSortKeysInserted(ks, ks->size-1);
+		}
+		ks->array[ks->size] = 0;
+		ksSetCursor(ks, ks->size-1);
+		return ks->size;
+	}
+
+	/* Merge both sorted arrays in a single pass */
+	ssize_t last = elektraKsMerge(ks, ks->size, toAppend,
+			size, toAlloc, 0);
+	if (last == -1) return -1;
+
+	ksSetCursor(ks, last);
+
+	return ks->size;
+}
+
+/**
+ * Append all @p toAppend contained keys to the end of the @p ks.
+ *
+ * @p toAppend KeySet will be left unchanged.
+ *
+ * If a key is both in toAppend and ks, the Key in ks will be
+ * overridden.
+ *
+ * Both keysets are already sorted, so they are merged in a single
+ * pass, which is linear in the size of both keysets.
+ *
+ * The KeySet internal cursor will be set to the last key
+ * of @p toAppend.
+ *
+ * @copydetails doxygenFlatCopy
+ *
+ * @post Sorted KeySet ks with all keys it had before and additionally
+ *       the keys from toAppend
+ * @return the size of the KeySet after transfer
+ * @return -1 on NULL pointers
+ * @param ks the KeySet that will receive the keys
+ * @param toAppend the KeySet that provides the keys that will be transferred
+ * @see ksAppendKey()
+ * 
+ */
+ssize_t ksAppend(KeySet *ks, const KeySet *toAppend)
+{
+	if (!ks) return -1;
+	if (!toAppend) return -1;
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return -1;
+
+	if (toAppend->size <= 0) return ks->size;
+	if (ks == toAppend) return ks->size;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+	if (test_bit(toAppend->flags, KS_FLAG_UNSORTED))
+	{
+		// sorting does not change the content of toAppend
+		elektraKsSort((KeySet *)toAppend);
+	}
+
+	return elektraKsAppendSorted(ks, toAppend->array, toAppend->size);
+}
+
+/**
+ * @internal
+ *
+ * Appends the keys of source from position begin to (excluding)
+ * end to ks, like ksAppend() does with all keys of a keyset.
+ *
+ * Together with elektraKsBelow() whole slices of a keyset are
+ * appended at once.
+ *
+ * @pre source is sorted, e.g. by elektraKsBelow()
+ * @param ks the keyset to append to
+ * @param source the keyset the keys are from
+ * @param begin the position of the first key to append
+ * @param end the position after the last key to append
+ * @return the size of ks afterwards
+ * @retval -1 on NULL pointers, memory errors or if ks is frozen
+ */
+ssize_t elektraKsAppendRange(KeySet *ks, const KeySet *source,
+		size_t begin, size_t end)
+{
+	if (!ks) return -1;
+	if (!source) return -1;
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return -1;
+
+	if (end > source->size) end = source->size;
+	if (begin >= end) return ks->size;
+	if (ks == source) return ks->size;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+
+	return elektraKsAppendSorted(ks, source->array+begin, end-begin);
+}
+
+/**
+ * @internal
+ *
+ * Removes all keys of ks whose mark is set, in a single pass.
+ *
+ * The other keys keep their order and are moved at most once, so
+ * removing many slices is as cheap as removing one.
+ *
+ * @param ks the keyset to remove keys from
+ * @param marks one mark for every position in ks
+ * @return the number of keys removed
+ * @retval -1 on NULL pointers or if ks is frozen
+ */
+ssize_t elektraKsRemoveMarked(KeySet *ks, const char *marks)
+{
+	if (!ks) return -1;
+	if (!marks) return -1;
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return -1;
+
+	size_t k = 0;
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		if (marks[i])
+		{
+			keyDecRef (ks->array[i]);
+			keyDel (ks->array[i]);
+			continue;
+		}
+		ks->array[k++] = ks->array[i];
+	}
+
+	const size_t removed = ks->size - k;
+	if (removed == 0) return 0;
+
+	ks->size = k;
+	ks->array[k] = 0;
+	ksClearIndex(ks);
+	ksRewind(ks);
+
+	return removed;
+}
+
+
+/**
+ * @internal
+ *
+ * Stable merge sort of an array of keys.
+ *
+ * @param array the keys to sort
+ * @param tmp a buffer for at least size/2 keys
+ * @param size the number of keys in array
+ */
+static void elektraKsMergeSort(Key **array, Key **tmp, size_t size)
+{
+	if (size < 2) return;
+
+	const size_t half = size/2;
+	elektraKsMergeSort(array, tmp, half);
+	elektraKsMergeSort(array+half, tmp, size-half);
+
+	/* already in order */
+	if (keyCompareByNameOwner(&array[half-1], &array[half]) <= 0) return;
+
+	elektraMemcpy(tmp, array, half);
+
+	size_t i = 0; // position in tmp (left half)
+	size_t j = half; // position in right half
+	size_t k = 0; // position in array
+	while (i < half && j < size)
+	{
+		if (keyCompareByNameOwner(&tmp[i], &array[j]) <= 0)
+		{
+			array[k++] = tmp[i++];
+		} else {
+			array[k++] = array[j++];
+		}
+	}
+	while (i < half)
+	{
+		array[k++] = tmp[i++];
+	}
+}
+
+
+/**
+ * Appends a Key to the end of @p ks without keeping the KeySet sorted.
+ *
+ * This is the fast way for storage plugins to build up a KeySet
+ * in the order of their file. Instead of a binary search and
+ * a memmove for every key, the keys are only sorted once
+ * within elektraKsSort().
+ *
+ * Like ksAppendKey() it takes ownership of the key and sets the
+ * internal cursor to it.
+ *
+ * Until elektraKsSort() is called, ksNext(), ksHead() and ksTail()
+ * see the keys in the order they were appended, and ksGetSize() also
+ * counts keys which will be replaced by a later key with the same name.
+ * Lookups with ksLookup() (without options) are done with a hash index
+ * and do not need the keys to be sorted. All other operations, e.g.
+ * ksAppendKey(), ksAppend() or ksCut(), call elektraKsSort() first.
+ *
+ * If keys are appended in order (the common case for files written
+ * by Elektra), the KeySet stays sorted and elektraKsSort() has
+ * nothing to do.
+ *
+ * @param ks KeySet that will receive the key
+ * @param toAppend Key that will be appended to ks or deleted
+ * @return the size of the KeySet after insertion
+ * @retval -1 on NULL pointers
+ * @retval -1 if insertion failed, the key will be deleted then.
+ * @see elektraKsSort(), ksAppendKey()
+ * @ingroup proposal
+ */
+ssize_t elektraKsAppendUnsorted(KeySet *ks, Key *toAppend)
+{
+	if (!ks) return -1;
+	if (!toAppend) return -1;
+	if (!toAppend->key || test_bit(ks->flags, KS_FLAG_FROZEN))
+	{
+		keyDel (toAppend);
+		return -1;
+	}
+
+	keyLock(toAppend, KEY_LOCK_NAME);
+
+	if (!test_bit(ks->flags, KS_FLAG_UNSORTED) && ks->size > 0 &&
+		keyCompareByNameOwner(&ks->array[ks->size-1], &toAppend) >= 0)
+	{
+		if (ks->array[ks->size-1] == toAppend)
+		{
+			/* user tried to insert the same key again */
+			return ks->size;
+		}
+
+		/* From now on the keys are not sorted anymore */
+		set_bit(ks->flags, KS_FLAG_UNSORTED);
+		ks->unsortedBegin = ks->size;
+	}
+
+	if (ks->size+1 >= ks->alloc)
+	{
+		if (ksResize (ks, ks->alloc * 2-1) == -1)
+		{
+			keyDel (toAppend);
+			return -1;
+		}
+	}
+
+	keyIncRef (toAppend);
+	ks->array[ks->size] = toAppend;
+	++ ks->size;
+	ks->array[ks->size] = 0;
+	ksSetCursor(ks, ks->size-1);
+	elektraKsHashAppended(ks);
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED))
+	{
+		clear_bit(ks->flags, KS_FLAG_RANGES);
+		clear_bit(ks->flags, KS_FLAG_SORTKEYS);
+	}
+	else
+	{
+		elektraKsRangesChanged(ks, toAppend, 1);
+		elektraKsSortKeysInserted(ks, ks->size-1);
+	}
+
+	return ks->size;
+}
+
+
+/**
+ * Sorts the keys appended with elektraKsAppendUnsorted().
+ *
+ * The unsorted keys are sorted once with a stable merge sort
+ * and then merged with the keys which were already sorted.
+ * If a name occurs more than once, the key appended last wins,
+ * exactly as if all keys were appended with ksAppendKey().
+ *
+ * The internal cursor will stay on a key with the same name as before.
+ *
+ * @param ks the keyset to sort
+ * @return the size of the KeySet afterwards
+ * @retval -1 on NULL pointer
+ * @retval -1 on memory error, the keyset is still unsorted then
+ * @see elektraKsAppendUnsorted()
+ * @ingroup proposal
+ */
+ssize_t elektraKsSort(KeySet *ks)
+{
+	if (!ks) return -1;
+
+	if (!test_bit(ks->flags, KS_FLAG_UNSORTED)) return ks->size;
+
+	if (ks->unsortedBegin >= ks->size)
+	{
+		/* all unsorted keys were popped */
+		clear_bit(ks->flags, KS_FLAG_UNSORTED);
+		ksClearIndex(ks);
+		return ks->size;
+	}
+
+	size_t begin = ks->unsortedBegin;
+	Key **unsorted = ks->array+begin;
+	size_t size = ks->size-begin;
+
+	Key **tmp = elektraMalloc (sizeof(struct _Key *) * (size/2+1));
+	if (!tmp) return -1;
+
+	/* make sure the current key survives, to find its position afterwards */
+	Key *current = ks->cursor;
+	keyIncRef (current);
+
+	elektraKsMergeSort(unsorted, tmp, size);
+	elektraFree (tmp);
+
+	/* remove duplicates, the last one wins */
+	size_t k = 0;
+	for (size_t i=0; i<size; ++i)
+	{
+		if (i+1 < size && keyCompareByNameOwner(&unsorted[i],
+					&unsorted[i+1]) == 0)
+		{
+			keyDecRef (unsorted[i]);
+			keyDel (unsorted[i]);
+			continue;
+		}
+		unsorted[k++] = unsorted[i];
+	}
+	size = k;
+	ks->size = begin+size;
+	ks->array[ks->size] = 0;
+
+	clear_bit(ks->flags, KS_FLAG_UNSORTED);
+	ksClearIndex(ks);
+
+	if (begin > 0 && keyCompareByNameOwner(&ks->array[begin-1],
+				&unsorted[0]) >= 0)
+	{
+		/* sorted keys are not all in front, so merge them */
+		if (elektraKsMerge(ks, begin, unsorted, size,
+					ks->alloc, 1) == -1)
+		{
+			/* still unsorted, but sorted from begin on */
+			set_bit(ks->flags, KS_FLAG_UNSORTED);
+			ksRewind(ks);
+			keyDecRef (current);
+			keyDel (current);
+			return -1;
+		}
+	}
+
+	ksRewind(ks);
+	if (current)
+	{
+		ssize_t pos = ksSearchInternal(ks, current);
+		if (pos >= 0) ksSetCursor(ks, pos);
+		keyDecRef (current);
+		keyDel (current);
+	}
+
+	return ks->size;
+}
+
+
+/**
+ * Lets @p ks allocate the keys created by elektraKsNewKey() from
+ * an arena.
+ *
+ * Such keys, together with their names and values, are allocated
+ * from large chunks instead of one malloc() each. The chunks are
+ * given back at once when the KeySet and all keys allocated from
+ * it were deleted. Memory of keys deleted earlier is not reused,
+ * so the arena fits KeySets filled once, e.g. by a storage plugin
+ * in kdbGet().
+ *
+ * Keys may be appended to other KeySets and outlive @p ks. After
+ * ksDel() of @p ks they keep the arena alive, but any name or value
+ * they need from then on is allocated on the heap again.
+ *
+ * The arena itself is only created by the first elektraKsNewKey().
+ *
+ * @param ks the keyset which should use an arena
+ * @retval 0 on success
+ * @retval -1 on NULL pointer
+ * @see elektraKsNewKey()
+ * @ingroup proposal
+ */
+int elektraKsEnableArena(KeySet *ks)
+{
+	if (!ks) return -1;
+
+	set_bit(ks->flags, KS_FLAG_ARENA);
+
+	return 0;
+}
+
+
+/**
+ * @internal
+ *
+ * @return the arena space a frozen copy of key needs
+ */
+static size_t elektraKsFrozenSize(const Key *key)
+{
+	size_t size = elektraArenaBlockSize(sizeof(struct _Key));
+
+	size += elektraArenaBlockSize(key->keySize + key->keyUSize);
+	if (key->dataSize > KEY_INLINE_VALUE_SIZE)
+	{
+		size += elektraArenaBlockSize(key->dataSize);
+	}
+	for (size_t i=0; key->meta && i<key->meta->size; ++i)
+	{
+		size += elektraKsFrozenSize(key->meta->array[i]);
+	}
+
+	return size;
+}
+
+/**
+ * @internal
+ *
+ * Creates a read only copy of key in arena.
+ *
+ * @return the copy or 0 on memory error
+ */
+static Key *elektraKsFrozenCopy(KeyArena *arena, const Key *key)
+{
+	Key *copy = elektraArenaMalloc(arena, sizeof(struct _Key));
+	if (!copy) return 0;
+
+	keyInit(copy);
+	copy->arena = arena;
+	elektraArenaIncRef(arena);
+
+	copy->key = elektraKeyMallocBuffer(copy,
+			key->keySize + key->keyUSize, KEY_FLAG_ARENA_NAME);
+	if (!copy->key) goto error;
+	memcpy(copy->key, key->key, key->keySize + key->keyUSize);
+	copy->keySize = key->keySize;
+	copy->keyUSize = key->keyUSize;
+	copy->nameHash = key->nameHash;
+	copy->namePrefix = key->namePrefix;
+
+	if (key->data.v)
+	{
+		copy->data.v = elektraKeyMallocBuffer(copy,
+				key->dataSize, KEY_FLAG_ARENA_VALUE);
+		if (!copy->data.v) goto error;
+		memcpy(copy->data.v, key->data.v, key->dataSize);
+		copy->dataSize = key->dataSize;
+	}
+
+	if (key->meta)
+	{
+		// meta keys are copied too, nothing is shared with key
+		copy->meta = ksNew(key->meta->size, KS_END);
+		if (!copy->meta) goto error;
+		for (size_t i=0; i<key->meta->size; ++i)
+		{
+			Key *meta = elektraKsFrozenCopy(arena, key->meta->array[i]);
+			if (!meta || ksAppendKey(copy->meta, meta) == -1) goto error;
+		}
+		// so that keyGetMeta() does not change the meta data
+		set_bit(copy->meta->flags, KS_FLAG_FROZEN);
+	}
+
+	if (test_bit(key->flags, KEY_FLAG_SYNC))
+	{
+		set_bit(copy->flags, KEY_FLAG_SYNC);
+	}
+	keyLock(copy, KEY_LOCK_NAME|KEY_LOCK_VALUE|KEY_LOCK_META);
+
+	return copy;
+
+error:
+	keyDel(copy);
+	return 0;
+}
+
+/**
+ * Freezes @p ks into a compact, read only snapshot.
+ *
+ * All keys are replaced by copies which are, together with their
+ * names and values, allocated one after the other in one block of
+ * memory, in the order of the KeySet. Their meta keys are copied
+ * into the same block. Names, values and meta data
+ * of these keys are locked (see keyLock()) and no keys can be added
+ * to or removed from @p ks anymore: ksAppendKey(), ksAppend(),
+ * ksCut(), ksPop(), ksClear() and lookups with ::KDB_O_CREATE fail.
+ *
+ * The indexes for ksLookup() are built at once, so lookups do not
+ * change @p ks anymore. Together with elektraKsLookupConst() the
+ * frozen KeySet can be read from several threads. keyGetMeta() does
+ * not change frozen keys either, but iterating their meta data with
+ * keyNextMeta() moves a cursor.
+ *
+ * Keys which were in @p ks before are not part of it anymore,
+ * pointers to them must not be used to access @p ks. Use keyDup()
+ * to get a key of the snapshot which can be changed again.
+ *
+ * @param ks the keyset to freeze
+ * @retval 1 on success
+ * @retval 0 if @p ks was already frozen
+ * @retval -1 on NULL pointer or memory error, @p ks is unchanged then
+ * @see elektraKsLookupConst()
+ * @ingroup proposal
+ */
+int elektraKsFreeze(KeySet *ks)
+{
+	if (!ks) return -1;
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return 0;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+
+	size_t size = 0;
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		size += elektraKsFrozenSize(ks->array[i]);
+	}
+
+	KeyArena *arena = elektraArenaNew();
+	if (!arena) return -1;
+
+	Key **copies = elektraCalloc(sizeof(struct _Key *) * (ks->size + 1));
+	if (!copies || elektraArenaReserve(arena, size) == -1)
+	{
+		elektraFree(copies);
+		elektraArenaClose(arena);
+		return -1;
+	}
+
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		copies[i] = elektraKsFrozenCopy(arena, ks->array[i]);
+		if (!copies[i])
+		{
+			for (size_t j=0; j<i; ++j) keyDel(copies[j]);
+			elektraFree(copies);
+			elektraArenaClose(arena);
+			return -1;
+		}
+	}
+
+	// positions do not change, so the hash index stays valid
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		keyIncRef(copies[i]);
+		keyDecRef(ks->array[i]);
+		keyDel(ks->array[i]);
+		ks->array[i] = copies[i];
+	}
+	elektraFree(copies);
+	if (ks->cursor) ks->cursor = ks->array[ks->current];
+
+	if (!ks->hashTable && ks->size >= KEYSET_HASH_MIN_SIZE)
+	{
+		elektraKsHashBuild(ks);
+	}
+	if (!test_bit(ks->flags, KS_FLAG_RANGES) &&
+		ks->size >= KEYSET_RANGES_MIN_SIZE)
+	{
+		elektraKsRangesBuild(ks);
+	}
+	if (!test_bit(ks->flags, KS_FLAG_SORTKEYS)) elektraKsSortKeysBuild(ks);
+
+	set_bit(ks->flags, KS_FLAG_FROZEN);
+	elektraArenaClose(arena);
+
+	return 1;
+}
+
+
+
+/**
+ * @internal
+ *
+ * Copies all Keys until the end of the array from a position
+ * in the array to an position in the array.
+ *
+ * @param ks the keyset where this should be done
+ * @param to the position where it should be copied to
+ * @param from the position where it should be copied from
+ * @retval -1 if length is smaller then 0
+ * @return the number of moved elements otherwise
+ */
+ssize_t ksCopyInternal(KeySet *ks, size_t to, size_t from)
+{
+	ssize_t ssize = ks->size;
+	ssize_t sto = to;
+	ssize_t sfrom = from;
+
+	ssize_t sizediff = sto-sfrom;
+	ssize_t length = ssize-sfrom;
+	size_t ret = 0;
+
+	if (length < 0) return -1;
+	if (ks->size < to) return -1;
+
+	if (length > 0) ksClearIndex(ks);
+
+	ks->size = ks->size + sizediff;
+	ret = elektraMemmove(ks->array + to, ks->array + from, length);
+	ks->array[ks->size] = 0;
+	return ret;
+}
+
+/**
+ * Cuts out a keyset at the cutpoint.
+ *
+ * Searches for the cutpoint inside the KeySet ks.
+ * If found it cuts out everything which is below (see keyIsBelow()) this key.
+ * These keys will be missing in the keyset @p ks.
+ * Instead, they will be moved to the returned keyset.
+ * If @p cutpoint is not found an empty keyset is returned and @p ks
+ * is not changed.
+ *
+ * The cursor will stay at the same key as it was before.
+ * If the cursor was inside the region of cut (moved)
+ * keys, the cursor will be set to the key before
+ * the cutpoint.
+ *
+ * If you use ksCut() on a keyset you got from kdbGet() and plan to make
+ * a kdbSet() later, make sure that you keep all keys that should not
+ * be removed permanently. You have to keep the KeySet that was returned
+ * and the KeySet @p ks.
+ *
+ * @par Example:
+ *
+ * You have the keyset @p ks:
+ * - @p system/mountpoint/interest
+ * - @p system/mountpoint/interest/folder
+ * - @p system/mountpoint/interest/folder/key1
+ * - @p system/mountpoint/interest/folder/key2
+ * - @p system/mountpoint/other/key1
+ *
+ * When you use
+ * @snippet cut.c cut
+ *
+ * Then in @p returned are:
+ * - @p system/mountpoint/interest
+ * - @p system/mountpoint/interest/folder
+ * - @p system/mountpoint/interest/folder/key1
+ * - @p system/mountpoint/interest/folder/key2
+ *
+ * And in @p ks are:
+ * - @p system/mountpoint/other/key1
+ *
+ * So kdbSet() permanently removes all keys below
+ * @p system/mountpoint/interest.
+ *
+ * @see kdbGet() for explanation why you might get more keys than you
+ * requested.
+ *
+ * @return a new allocated KeySet which needs to deleted with ksDel().
+ *         The keyset consists of all keys (of the original keyset ks)
+ *         below the cutpoint. If the key cutpoint exists, it will
+ *         also be appended.
+ * @retval 0 on null pointers, no key name or allocation problems
+ * @param ks the keyset to cut. It will be modified by removing
+ *           all keys below the cutpoint.
+ *           The cutpoint itself will also be removed.
+ * @param cutpoint the point where to cut out the keyset
+ */
+KeySet *ksCut(KeySet *ks, const Key *cutpoint)
+{
+	KeySet *returned = 0;
+	size_t found = 0;
+	size_t it = 0;
+	size_t newsize = 0;
+	int set_cursor = 0;
+
+	if (!ks) return 0;
+	if (!cutpoint) return 0;
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return 0;
+
+	char *name = cutpoint->key;
+	if (!name) return 0;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+	// if (strcmp(name, "")) return 0;
+
+	if (name[0] == '/')
+	{
+		Key *key = (Key *) cutpoint;
+		size_t size = key->keySize;
+		size_t usize = key->keyUSize;
+		kdb_unsigned_long_long_t hash = key->nameHash;
+		kdb_unsigned_long_long_t prefix = key->namePrefix;
+		size_t length = strlen (name) + ELEKTRA_MAX_NAMESPACE_SIZE;
+		char newname[length*2];
+
+		KeySet *ret = ksNew(0, KS_END);
+
+		for (elektraNamespace ns=KEY_NS_FIRST; ns<=KEY_NS_LAST; ++ns)
+		{
+			int validNS = 1;
+		switch (ns)
+		{
+		case KEY_NS_SPEC:
+			strncpy (newname+2, "spec", 4);
+			strcpy  (newname+6, name);
+			key->key = newname+2;
+			key->keySize = length-2;
+			if (!strcmp(name, "/")) key->keySize = 5;
+			elektraFinalizeName(key);
+			break;
+		case KEY_NS_PROC:
+			strncpy (newname+2, "proc", 4);
+			strcpy  (newname+6, name);
+			key->key = newname+2;
+			key->keySize = length-2;
+			if (!strcmp(name, "/")) key->keySize = 5;
+			elektraFinalizeName(key);
+			break;
+		case KEY_NS_DIR:
+			strncpy (newname+3, "dir", 3);
+			strcpy  (newname+6, name);
+			key->key = newname+3;
+			key->keySize = length-3;
+			if (!strcmp(name, "/")) key->keySize = 4;
+			elektraFinalizeName(key);
+			break;
+		case KEY_NS_USER:
+			strncpy (newname+2, "user", 4);
+			strcpy  (newname+6, name);
+			key->key = newname+2;
+			key->keySize = length-2;
+			if (!strcmp(name, "/")) key->keySize = 5;
+			elektraFinalizeName(key);
+			break;
+		case KEY_NS_SYSTEM:
+			strncpy (newname, "system",6);
+			strcpy  (newname+6, name);
+			key->key = newname;
+			key->keySize = length;
+			if (!strcmp(name, "/")) key->keySize = 7;
+			elektraFinalizeName(key);
+			break;
+		case KEY_NS_EMPTY:
+		case KEY_NS_NONE:
+		case KEY_NS_META:
+		case KEY_NS_CASCADING:
+			validNS = 0;
+		}
+			size_t begin, end;
+			if (validNS && elektraKsRange(ks, key, &begin, &end) &&
+				begin == end)
+			{
+				// nothing in this namespace
+				validNS = 0;
+			}
+			if (validNS)
+			{
+				KeySet * n = ksCut(ks, key);
+				ksAppend(ret, n);
+				ksDel(n);
+			}
+		}
+
+		// restore old cascading name
+		key->key = name;
+		key->keySize = size;
+		key->keyUSize = usize ;
+		key->nameHash = hash;
+		key->namePrefix = prefix;
+		return ret;
+	}
+
+	// only the namespace of the cutpoint needs to be searched
+	size_t end = 0;
+	elektraKsRange(ks, cutpoint, &it, &end);
+
+	if (cutpoint->keyUSize > 1)
+	{
+		// the keys to cut are next to each other
+		elektraKsBelowRange(ks, cutpoint, &it, &end);
+		found = it;
+		it = end;
+	}
+	else
+	{
+		// search the cutpoint
+		while (it < end && keyIsBelowOrSame(cutpoint, ks->array[it]) == 0)
+		{
+			++it;
+		}
+
+		// we found the cutpoint
+		found = it;
+
+		// search the end of the keyset to cut
+		while (it < end && keyIsBelowOrSame(cutpoint, ks->array[it]) == 1)
+		{
+			++it;
+		}
+	}
+
+	// we found nothing
+	if (found == it) return ksNew(0, KS_END);
+
+	// correct cursor if cursor is in cutted keyset
+	if (ks->current >= found && ks->current < it)
+	{
+		if (found == 0)
+		{
+			ksRewind(ks);
+		}
+		else
+		{
+			ks->current = found - 1;
+			set_cursor = 1;
+		}
+	}
+
+	// correct the cursor for the keys after the cutted keyset
+	if (ks->current >= it)
+	{
+		if (it >= ks->size)
+		{
+			ksRewind(ks);
+		}
+		else
+		{
+			ks->current = found + ks->current - it;
+			set_cursor = 1;
+		}
+	}
+
+	newsize = it-found;
+
+	if (it == ks->size)
+	{
+		// cut at the end: positions before found stay valid
+		for (size_t i=found; i<it; ++i) elektraKsHashRemoveAt(ks, i);
+	}
+
+	// the ranges stay valid if only keys of one namespace are cut
+	const int ranges = test_bit(ks->flags, KS_FLAG_RANGES) &&
+		!strcmp(elektraKsFirstPart(ks->array[found]),
+			elektraKsFirstPart(ks->array[it-1]));
+	// the remaining names still share the prefix of the sort keys
+	const int sortKeys = test_bit(ks->flags, KS_FLAG_SORTKEYS);
+	Key *first = ks->array[found];
+
+	returned = ksNew(newsize, KS_END);
+	elektraMemcpy (returned->array, ks->array+found, newsize);
+	returned->size = newsize;
+	returned->array[returned->size] = 0;
+
+	if (ksCopyInternal(ks, found, it) == -1)
+	{
+		ELEKTRA_ASSERT(0 && "ksCopyInternal returned an error inside ksCut");
+	}
+
+	if (ranges)
+	{
+		set_bit(ks->flags, KS_FLAG_RANGES);
+		elektraKsRangesChanged(ks, first, -(ssize_t)newsize);
+	}
+
+	if (sortKeys)
+	{
+		memmove(ks->sortKeys+found, ks->sortKeys+found+newsize,
+			(ks->size-found) * sizeof(kdb_unsigned_long_long_t));
+		set_bit(ks->flags, KS_FLAG_SORTKEYS);
+	}
+
+	if (set_cursor) ks->cursor = ks->array[ks->current];
+
+	return returned;
+}
+
+/**
+ * Finds the keys below @p parent without copying them.
+ *
+ * Unlike ksCut() nothing is removed from @p ks. The keys below or
+ * the same as @p parent (see keyIsBelowOrSame()) are the keys from
+ * position @p begin to (excluding) @p end, which can be accessed with
+ * ksAtCursor(). Reference counters are not changed, so the positions
+ * are only valid until @p ks is changed the next time.
+ *
+ * The positions are found with two binary searches. Like for
+ * keyIsBelowOrSame() a cascading @p parent only finds cascading keys.
+ *
+ * @code
+cursor_t begin, end;
+if (elektraKsBelow(ks, parent, &begin, &end) > 0)
+{
+	for (cursor_t it = begin; it < end; ++it)
+	{
+		Key *k = ksAtCursor(ks, it);
+		// work with keys below parent
+	}
+}
+ * @endcode
+ *
+ * @param ks the keyset to look in, it will be sorted if necessary
+ * @param parent the root of the keys to find
+ * @param begin will be set to the position of the first key
+ * @param end will be set to the position after the last key
+ * @return the number of keys found, @p end - @p begin
+ * @retval -1 on NULL pointers or if @p parent has no name, or
+ *         its name is "/"
+ * @see ksCut() to remove the keys from @p ks
+ * @ingroup proposal
+ */
+ssize_t elektraKsBelow(KeySet *ks, const Key *parent,
+		cursor_t *begin, cursor_t *end)
+{
+	if (!ks || !parent || !begin || !end) return -1;
+	if (!parent->key || parent->keyUSize <= 1) return -1;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+
+	size_t first = 0;
+	size_t last = 0;
+	elektraKsRange(ks, parent, &first, &last);
+	elektraKsBelowRange(ks, parent, &first, &last);
+
+	*begin = first;
+	*end = last;
+	return last - first;
+}
+
+/**
+ * Finds the first key directly below @p parent.
+ *
+ * Together with elektraKsNextChild() the children of @p parent are
+ * enumerated in O(log n + k) for k children, without looking at the
+ * keys further below them. A tree index of the keyset is built
+ * lazily for it, it is dropped when the keyset changes.
+ *
+ * Keys further below a child, which is not in @p ks itself, are
+ * skipped but not returned, like keyIsDirectBelow() does. Keys with
+ * the same name but different owners, e.g. user/a and user:o/a, are
+ * all children. They are next to each other and the keys below them
+ * are below all of them.
+ *
+ * @code
+cursor_t end;
+for (cursor_t it = elektraKsFirstChild(ks, parent, &end); it != -1;
+	it = elektraKsNextChild(ks, it, end))
+{
+	Key *child = ksAtCursor(ks, it);
+	// keys below child are from it to elektraKsSubtreeEnd(ks, it)
+}
+ * @endcode
+ *
+ * @param ks the keyset to look in, it will be sorted if necessary
+ * @param parent the key to find the children of, it does not need
+ *        to be in @p ks
+ * @param end will be set to the position after the last key below
+ *        @p parent, to be passed to elektraKsNextChild()
+ * @return the position of the first child
+ * @retval -1 if there is none, on NULL pointers, memory errors,
+ *         or if @p parent has no name or its name is "/"
+ * @see elektraKsBelow() for all keys below @p parent
+ * @ingroup proposal
+ */
+cursor_t elektraKsFirstChild(KeySet *ks, const Key *parent, cursor_t *end)
+{
+	cursor_t begin = 0;
+	if (!end) return -1;
+	if (elektraKsBelow(ks, parent, &begin, end) <= 0) return -1;
+	if (elektraKsTreeIndexPrepare(ks) == -1) return -1;
+
+	return elektraKsTreeLevelFrom(ks, begin, *end, elektraKsLevel(parent)+1);
+}
+
+/**
+ * Finds the next key directly below the same parent.
+ *
+ * @param ks the keyset, unchanged since elektraKsFirstChild()
+ * @param child the position of a child
+ * @param end the end of the keys below the parent, as returned by
+ *        elektraKsFirstChild()
+ * @return the position of the next child
+ * @retval -1 if there is none or on invalid positions
+ * @see elektraKsFirstChild()
+ * @ingroup proposal
+ */
+cursor_t elektraKsNextChild(KeySet *ks, cursor_t child, cursor_t end)
+{
+	if (!ks || child < 0 || (size_t)child >= ks->size) return -1;
+	if (end < 0 || (size_t)end > ks->size) return -1;
+	if (elektraKsTreeIndexPrepare(ks) == -1) return -1;
+
+	// the same name with another owner is the next child
+	const size_t next = child+1;
+	if (next < (size_t)end &&
+		elektraKsSameName(ks->array[child], ks->array[next]))
+	{
+		return next;
+	}
+
+	const KeySetTreeEntry *entry = &ks->treeIndex[child];
+	return elektraKsTreeLevelFrom(ks, entry->end, end, entry->level);
+}
+
+/**
+ * Finds the end of the keys below the key at position @p pos.
+ *
+ * The keys below are next to each other, from @p pos + 1 to
+ * (excluding) the position returned. Keys with the same name but
+ * other owners following @p pos are in between, too. The end is
+ * found in constant time with the tree index, see
+ * elektraKsFirstChild().
+ *
+ * @param ks the keyset to look in, it will be sorted if necessary
+ * @param pos the position of the key
+ * @return the position after the last key below the key at @p pos
+ * @retval -1 on NULL pointers, invalid positions or memory errors
+ * @ingroup proposal
+ */
+cursor_t elektraKsSubtreeEnd(KeySet *ks, cursor_t pos)
+{
+	if (!ks || pos < 0 || (size_t)pos >= ks->size) return -1;
+	if (elektraKsTreeIndexPrepare(ks) == -1) return -1;
+
+	return ks->treeIndex[pos].end;
+}
+
+/**
+ * Iterates over keys in tree order, telling their levels.
+ *
+ * The keys are returned in the order of the keyset, which is the
+ * order of a depth-first walk, parents before their children.
+ * The level of the name tells how deep a key is, e.g. to open and
+ * close elements when writing it as tree, without splitting names.
+ * A subtree can be skipped by setting @p it to elektraKsSubtreeEnd().
+ *
+ * @code
+cursor_t it, end;
+size_t level;
+Key *key;
+if (elektraKsBelow(ks, parent, &it, &end) > 0)
+{
+	while ((key = elektraKsNextInTree(ks, &it, end, &level)) != 0)
+	{
+		// level is 1 for user, 2 for user/a, ...
+	}
+}
+ * @endcode
+ *
+ * @param ks the keyset to iterate, it will be sorted if necessary
+ * @param it the position of the next key, will be incremented
+ * @param end the position after the last key to iterate
+ * @param level will be set to the number of parts of the name of
+ *        the key returned, 1 for the root of a namespace, may be 0
+ * @return the key at @p it
+ * @retval 0 at @p end, on NULL pointers or memory errors
+ * @ingroup proposal
+ */
+Key *elektraKsNextInTree(KeySet *ks, cursor_t *it, cursor_t end, size_t *level)
+{
+	if (!ks || !it || *it < 0) return 0;
+	if (*it >= end || (size_t)*it >= ks->size) return 0;
+	if (elektraKsTreeIndexPrepare(ks) == -1) return 0;
+
+	if (level) *level = ks->treeIndex[*it].level;
+	return ks->array[(*it)++];
+}
+
+
+
+
+/**
+ * Remove and return the last key of @p ks.
+ *
+ * The reference counter will be decremented by one.
+ *
+ * The KeySets cursor will not be effected if it did not
+ * point to the popped key.
+ *
+ * @note You need to keyDel() the key afterwards, if
+ * you don't append it to another keyset. It has the
+ * same semantics like a key allocated with keyNew()
+ * or keyDup().
+ *
+ *@code
+ks1=ksNew(0, KS_END);
+ks2=ksNew(0, KS_END);
+
+k1=keyNew("user/name", KEY_END); // ref counter 0
+ksAppendKey(ks1, k1); // ref counter 1
+ksAppendKey(ks2, k1); // ref counter 2
+
+k1=ksPop (ks1); // ref counter 1
+k1=ksPop (ks2); // ref counter 0, like after keyNew()
+
+ksAppendKey(ks1, k1); // ref counter 1
+
+ksDel (ks1); // key is deleted too
+ksDel (ks2);
+ *@endcode
+ *
+ * @return the last key of @p ks
+ * @return NULL if @p ks is empty or on NULL pointer
+ * @param ks KeySet to work with
+ * @see ksAppendKey(), ksAppend()
+ * @see commandList() for an example
+ *
+ */
+Key *ksPop(KeySet *ks)
+{
+	Key *ret=0;
+
+	if (!ks) return 0;
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return 0;
+
+	ks->flags |= KS_FLAG_SYNC;
+
+	if (ks->size <= 0) return 0;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) ksClearIndex(ks);
+	else
+	{
+		elektraKsHashRemoveAt(ks, ks->size-1);
+		elektraKsRangesChanged(ks, ks->array[ks->size-1], -1);
+	}
+
+	-- ks->size;
+	if (ks->size+1 < ks->alloc/2) ksResize (ks, ks->alloc / 2-1);
+	ret = ks->array[ks->size];
+	ks->array[ks->size] = 0;
+	keyDecRef(ret);
+
+	return ret;
+}
+
+
+/*******************************************
+ *           KeySet browsing methods       *
+ *******************************************/
+
+
+
+/**
+ * Rewinds the KeySet internal cursor.
+ *
+ * Use it to set the cursor to the beginning of the KeySet.
+ * ksCurrent() will then always return NULL afterwards. So
+ * you want to ksNext() first.
+ *
+ * @code
+ksRewind (ks);
+while ((key = ksNext (ks))!=0) {}
+ * @endcode
+ *
+ * @param ks the keyset object to work with
+ * @return 0 on success
+ * @return -1 on NULL pointer
+ * @see ksNext(), ksCurrent()
+ */
+int ksRewind(KeySet *ks)
+{
+	if (!ks) return -1;
+
+	ks->cursor=0;
+	ks->current=0;
+	return 0;
+}
+
+
+/**
+ * Returns the next Key in a KeySet.
+ *
+ * KeySets have an internal cursor that can be reset with ksRewind(). Every
+ * time ksNext() is called the cursor is incremented and the new current Key
+ * is returned.
+ *
+ * You'll get a NULL pointer if the key after the end of the KeySet was reached.
+ * On subsequent calls of ksNext() it will still return the NULL pointer.
+ *
+ * The @p ks internal cursor will be changed, so it is not const.
+ *
+ * @note You must not delete or change the key, use ksPop() if you want to delete it.
+ *
+ * @param ks the keyset object to work with
+ * @return the new current Key
+ * @return 0 when the end is reached
+ * @return 0 on NULL pointer
+ * @see ksRewind(), ksCurrent()
+ */
+Key *ksNext(KeySet *ks)
+{
+	if (!ks) return 0;
+
+	if (ks->size == 0) return 0;
+	if (ks->current >= ks->size)
+	{
+		return 0;
+	}
+
+	if (ks->cursor) ks->current++;
+	return ks->cursor = ks->array[ks->current];
+}
+
+
+
+
+/**
+ * Return the current Key.
+ *
+ * The pointer is NULL if you reached the end or after
+ * ksRewind().
+ *
+ * @note You must not delete the key or change the key,
+ *    use ksPop() if you want to delete it.
+ *
+ * @param ks the keyset object to work with
+ * @return pointer to the Key pointed by @p ks's cursor
+ * @return 0 on NULL pointer
+ * @see ksNext(), ksRewind()
+ */
+Key *ksCurrent(const KeySet *ks)
+{
+	if (!ks) return 0;
+
+	return ks->cursor;
+}
+
+
+
+
+/**
+ * Return the first key in the KeySet.
+ *
+ * The KeySets cursor will not be effected.
+ *
+ * If ksCurrent()==ksHead() you know you are
+ * on the first key.
+ *
+ * @param ks the keyset object to work with
+ * @return the first Key of a keyset
+ * @return 0 on NULL pointer or empty keyset
+ * @see ksTail() for the last key
+ * @see ksRewind(), ksCurrent() and ksNext() for iterating over the keyset
+ */
+Key *ksHead(const KeySet *ks)
+{
+	if (!ks) return 0;
+
+	if (ks->size > 0) return ks->array[0];
+	else return 0;
+}
+
+
+
+
+
+/**
+ * Return the last key in the KeySet.
+ *
+ * The KeySets cursor will not be effected.
+ *
+ * If ksCurrent()==ksTail() you know you
+ * are on the last key. ksNext() will return
+ * a NULL pointer afterwards.
+ *
+ * @param ks the keyset object to work with
+ * @return the last Key of a keyset
+ * @return 0 on NULL pointer or empty keyset
+ * @see ksHead() for the first key
+ * @see ksRewind(), ksCurrent() and ksNext() for iterating over the keyset
+ */
+Key *ksTail(const KeySet *ks)
+{
+	if (!ks) return 0;
+
+	if (ks->size > 0) return ks->array[ks->size-1];
+	else return 0;
+}
+
+
+
+/**
+ * Get the KeySet internal cursor.
+ *
+ * Use it to get the cursor of the actual position.
+ *
+ * @warning Cursors are getting invalid when the key
+ * was ksPop()ed or ksLookup() with KDB_O_POP was
+ * used.
+ *
+ * @section readahead Read ahead
+ *
+ * With the cursors it is possible to read ahead
+ * in a keyset:
+ *
+ * @code
+cursor_t jump;
+ksRewind (ks);
+while ((key = keyNextMeta (ks))!=0)
+{
+	// now mark this key
+	jump = ksGetCursor(ks);
+
+	//code..
+	keyNextMeta (ks); // now browse on
+	// use ksCurrent(ks) to check the keys
+	//code..
+
+	// jump back to the position marked before
+	ksSetCursor(ks, jump);
+}
+ * @endcode
+ *
+ * @section restore Restoring state
+ *
+ * It can also be used to restore the state of a
+ * keyset in a function
+ *
+ * @code
+int f (KeySet *ks)
+{
+	cursor_t state = ksGetCursor(ks);
+
+	// work with keyset
+
+	// now bring the keyset to the state before
+	ksSetCursor (ks, state);
+}
+ * @endcode
+ *
+ * It is of course possible to make the KeySet const
+ * and cast its const away to set the cursor.
+ * Another way to achieve
+ * the same is to ksDup() the keyset, but it is
+ * not as efficient.
+ *
+ * An invalid cursor will be returned directly after
+ * ksRewind(). When you set an invalid cursor ksCurrent()
+ * is 0 and ksNext() == ksHead().
+ *
+ * @note Only use a cursor for the same keyset which it was
+ * made for.
+ *
+ * @param ks the keyset object to work with
+ * @return a valid cursor on success
+ * @return an invalid cursor on NULL pointer or after ksRewind()
+ * @see ksNext(), ksSetCursor()
+ */
+cursor_t ksGetCursor(const KeySet *ks)
+{
+	if (!ks) return (cursor_t) -1;
+
+	if (ks->cursor == 0) return (cursor_t) -1;
+	else return (cursor_t) ks->current;
+}
+
+/**
+ * @brief return key at given cursor position
+ *
+ * @param ks the keyset to pop key from
+ * @param pos where to get
+ * @return the key at the cursor position on success
+ * @retval NULL on NULL pointer, negative cursor position
+ * or a position that does not lie within the keyset
+ */
+Key *ksAtCursor(KeySet *ks, cursor_t pos)
+{
+	if (!ks) return 0;
+	if (pos < 0) return 0;
+	if (ks->size < (size_t)pos) return 0;
+	return ks->array[pos];
+}
+
+
+/**
+ * Set the KeySet internal cursor.
+ *
+ * Use it to set the cursor to a stored position.
+ * ksCurrent() will then be the position which you got with.
+ *
+ * @warning Cursors may get invalid when the key
+ * was ksPop()ed or ksLookup() was used together
+ * with KDB_O_POP.
+ *
+ * @code
+cursor_t cursor;
+..
+// key now in any position here
+cursor = ksGetCursor (ks);
+while ((key = keyNextMeta (ks))!=0) {}
+ksSetCursor (ks, cursor); // reset state
+ksCurrent(ks); // in same position as before
+ * @endcode
+ *
+ * An invalid cursor will set the keyset to its beginning like
+ * ksRewind(). When you set an invalid cursor ksCurrent()
+ * is 0 and ksNext() == ksHead().
+ *
+ * @param cursor the cursor to use
+ * @param ks the keyset object to work with
+ * @return 0 when the keyset is ksRewind()ed
+ * @return 1 otherwise
+ * @return -1 on NULL pointer
+ * @see ksNext(), ksGetCursor()
+ */
+int ksSetCursor(KeySet *ks, cursor_t cursor)
+{
+	if (!ks) return -1;
+
+	if ((cursor_t) -1 == cursor)
+	{
+		ksRewind (ks);
+		return 0;
+	}
+	ks->current= (size_t)cursor;
+	ks->cursor=ks->array[ks->current];
+	return 1;
+}
+
+
+
+
+/******************************************* 
+ *    Looking up Keys inside KeySets       *
+ *******************************************/
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupBySpec
+ *
+ * Lookup using links (fallback or override passed as buffer)
+ *
+ * @param ks the keyset to search in
+ * @param specKey contains metadata as specified in buffer+#<number>
+ * @param buffer the buffer used for incrementing numbers
+ *
+ * @return 
+ */
+static Key *elektraLookupBySpecLinks(KeySet *ks, Key *specKey, char *buffer)
+{
+	Key *ret = 0;
+	Key *k = 0;
+	const int prefixSize = ELEKTRA_MAX_PREFIX_SIZE - 2;
+	kdb_long_long_t i=0;
+	const Key *m = 0;
+
+	do {
+		elektraWriteArrayNumber(&buffer[prefixSize], i);
+		m = keyGetMeta(specKey, buffer);
+		if (!m) break;
+		// optimization: lazy instanziation of k
+		if (!k) k = keyNew(keyString(m), KEY_CASCADING_NAME,
+				KEY_END);
+		else elektraKeySetName(k, keyString(m),
+				KEY_CASCADING_NAME);
+		ret=ksLookup(ks, k, KDB_O_NODEFAULT);
+		if (ret) break;
+		++i;
+	} while(m);
+
+	keyDel(k);
+	return ret;
+}
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupBySpec
+ */
+static Key *elektraLookupBySpecDefault(KeySet *ks, Key *specKey)
+{
+	Key *ret = 0;
+	const Key *m = 0;
+
+	ret=ksLookup(ks, specKey, KDB_O_NOCASCADING);
+	if (ret) return ret; // return previous added default key
+
+	m = keyGetMeta(specKey, "default");
+	if (!m) return ret;
+	// a default key could not be added, so nobody would own it
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return 0;
+	ret=keyNew(
+		keyName(specKey),
+		KEY_CASCADING_NAME,
+		KEY_VALUE, keyString(m),
+		KEY_END);
+	ksAppendKey(ks, ret);
+
+	return ret;
+}
+
+static Key *elektraLookupByCascading(KeySet *ks, Key *key, option_t options);
+static Key *elektraLookupSearch(KeySet *ks, Key *key, option_t options);
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupBySpec
+ *
+ * Lookup using namespaces
+ *
+ * @param ks the keyset to search in
+ * @param specKey contains metadata as specified in buffer+#<number>
+ * @param buffer the buffer used for incrementing numbers
+ */
+static Key *elektraLookupBySpecNamespaces(KeySet *ks, Key *specKey, char *buffer)
+{
+	Key *ret = 0;
+	const int prefixSize = ELEKTRA_MAX_PREFIX_SIZE - 1;
+	kdb_long_long_t i=0;
+	const Key *m = 0;
+
+	m = keyGetMeta(specKey, buffer);
+	// no namespaces specified, so do a default cascading lookup
+	// (obviously w/o spec)
+	if (!m) return elektraLookupByCascading(ks, specKey, KDB_O_NOSPEC | KDB_O_NODEFAULT);
+
+	// store old name of specKey
+	char * name = specKey->key;
+	size_t size = specKey->keySize;
+	size_t usize = specKey->keyUSize;
+	kdb_unsigned_long_long_t hash = specKey->nameHash;
+	kdb_unsigned_long_long_t prefix = specKey->namePrefix;
+	size_t nameLength = strlen (name);
+	size_t maxSize = nameLength + ELEKTRA_MAX_NAMESPACE_SIZE;
+	char newname[maxSize*2]; // buffer for all new names (namespace + cascading key name)
+
+	do {
+		// lookup with given namespace
+		size_t namespaceSize = keyGetValueSize(m);
+		char *startOfName = newname+ELEKTRA_MAX_NAMESPACE_SIZE-namespaceSize;
+		strncpy (startOfName, keyString(m), namespaceSize);
+		strcpy  (newname+ELEKTRA_MAX_NAMESPACE_SIZE-1, name); // name starts with /
+		specKey->key = startOfName;
+		specKey->keySize = nameLength + namespaceSize;
+		elektraFinalizeName(specKey);
+		ret=ksLookup(ks, specKey, 0);
+		if (ret) break;
+		++i; // start with 1 (#0 was already in buffer)
+
+		elektraWriteArrayNumber(&buffer[prefixSize], i);
+		m = keyGetMeta(specKey, buffer);
+	} while(m);
+
+	// restore old cascading name
+	specKey->key = name;
+	specKey->keySize = size;
+	specKey->keyUSize = usize ;
+	specKey->nameHash = hash;
+	specKey->namePrefix = prefix;
+	return ret;
+}
+
+
+/**
+ * @internal
+ * @brief Helper for ksLookup
+ */
+static Key *elektraLookupBySpec(KeySet *ks, Key *specKey, option_t options)
+{
+	Key *ret = 0;
+	// the name of specKey is changed in place
+	if (elektraKeyUnshareName(specKey) == -1) return 0;
+	// strip away beginning of specKey
+	char * name = specKey->key;
+	// stays same if already cascading and
+	// root must not be cascaded, so the usage of strchr is safe.
+	specKey->key = strchr(name, '/');
+	size_t size = specKey->keySize;
+	specKey->keySize = size - (specKey->key - name);
+	elektraFinalizeName(specKey);
+
+	// lookup by override
+	char buffer [ELEKTRA_MAX_PREFIX_SIZE + ELEKTRA_MAX_ARRAY_SIZE]
+		= "override/";
+	ret = elektraLookupBySpecLinks(ks, specKey, buffer);
+	if (ret) goto finished;
+
+	// lookup by namespaces
+	strcpy (buffer, "namespace/#0");
+	ret=elektraLookupBySpecNamespaces(ks, specKey, buffer);
+	if (ret) goto finished;
+
+	// lookup by fallback
+	strcpy (buffer, "fallback/");
+	ret = elektraLookupBySpecLinks(ks, specKey, buffer);
+	if (ret) goto finished;
+
+	if (!(options & KDB_O_NODEFAULT))
+	{
+		ret = elektraLookupBySpecDefault(ks, specKey);
+	}
+
+finished:
+	specKey->key = name;
+	specKey->keySize = size;
+	elektraFinalizeName(specKey);
+
+	return ret;
+}
+
+/**
+ * @internal
+ * @brief Helper for cascading lookups
+ *
+ * Lets the cascading @p key have the name in one namespace.
+ *
+ * The searches only compare unescaped names. So the unescaped
+ * name is put together by writing the namespace right before
+ * the tail, which is already in @p buffer, and the escaped name
+ * of @p key is left empty.
+ *
+ * @param buffer the tail of the unescaped name starts at
+ *        buffer+ELEKTRA_MAX_NAMESPACE_SIZE
+ * @param usize the size of the unescaped cascading name
+ */
+static void elektraLookupSetNamespace(Key *key, char *buffer,
+		size_t usize, const char *namespace)
+{
+	const size_t namespaceSize = strlen(namespace) + 1;
+	char *begin = buffer + ELEKTRA_MAX_NAMESPACE_SIZE - namespaceSize;
+	memcpy(begin, namespace, namespaceSize);
+
+	key->key = begin;
+	key->keySize = 0;
+	// replaces the empty first part of the cascading name
+	key->keyUSize = namespaceSize + usize - 1;
+	elektraKeyNameCache(key);
+}
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupByCascading
+ *
+ * Looks up the cascading @p key in one namespace.
+ *
+ * @see elektraLookupSetNamespace()
+ */
+static Key *elektraLookupByNamespace(KeySet *ks, Key *key, char *buffer,
+		size_t usize, const char *namespace, option_t options)
+{
+	elektraLookupSetNamespace(key, buffer, usize, namespace);
+
+	return elektraLookupSearch(ks, key, options);
+}
+
+/**
+ * @internal
+ * @brief Helper for ksLookup
+ */
+static Key *elektraLookupByCascading(KeySet *ks, Key *key, option_t options)
+{
+	char * name = key->key;
+	size_t size = key->keySize;
+	size_t usize = key->keyUSize;
+	kdb_unsigned_long_long_t hash = key->nameHash;
+	kdb_unsigned_long_long_t prefix = key->namePrefix;
+	// the unescaped cascading name is an empty part followed
+	// by the tail, which is the same in all namespaces
+	char newname[ELEKTRA_MAX_NAMESPACE_SIZE + usize];
+	memcpy(newname + ELEKTRA_MAX_NAMESPACE_SIZE, name + size + 1, usize - 1);
+	Key *found = 0;
+	Key *specKey = 0;
+
+	options &= ~KDB_O_DEL;
+
+	if (!(options & KDB_O_NOSPEC))
+	{
+		specKey = elektraLookupByNamespace(ks, key, newname, usize,
+				"spec", options);
+	}
+
+	if (specKey)
+	{
+		// restore old name
+		key->key = name;
+		key->keySize = size;
+		key->keyUSize = usize ;
+		key->nameHash = hash;
+		key->namePrefix = prefix;
+
+		// we found a spec key, so we know what to do
+		specKey = keyDup(specKey);
+		found = elektraLookupBySpec(ks, specKey, options);
+		keyDel(specKey);
+		return found;
+	}
+
+	// default cascading:
+	found = elektraLookupByNamespace(ks, key, newname, usize,
+			"proc", options);
+
+	if (!found)
+	{
+		found = elektraLookupByNamespace(ks, key, newname, usize,
+				"dir", options);
+	}
+
+	if (!found)
+	{
+		found = elektraLookupByNamespace(ks, key, newname, usize,
+				"user", options);
+	}
+
+	if (!found)
+	{
+		found = elektraLookupByNamespace(ks, key, newname, usize,
+				"system", options);
+	}
+
+	// restore old cascading name
+	key->key = name;
+	key->keySize = size;
+	key->keyUSize = usize ;
+	key->nameHash = hash;
+	key->namePrefix = prefix;
+
+	if (!found && !(options & KDB_O_NODEFAULT))
+	{
+		// search / key itself
+		found = elektraLookupSearch(ks, key, options);
+	}
+
+	return found;
+}
+
+static Key * elektraLookupLinearSearch(KeySet *ks, Key *key, option_t options)
+{
+	cursor_t cursor = 0;
+	cursor = ksGetCursor (ks);
+	Key *current;
+	if (!(options & KDB_O_NOALL)) ksRewind(ks);
+	while ((current=ksNext(ks)) != 0)
+	{
+		if ((options & KDB_O_WITHOWNER) && (options & KDB_O_NOCASE))
+		{
+			if (!keyCompareByNameOwnerCase(&key, &current)) break;
+		}
+		else if (options & KDB_O_WITHOWNER)
+		{
+			if (!keyCompareByNameOwner(&key, &current)) break;
+		}
+		else if (options & KDB_O_NOCASE)
+		{
+			if (!keyCompareByNameCase(&key, &current)) break;
+		}
+		else if (!keyCompareByName(&key, &current)) break;
+	}
+	if (current == 0)
+	{
+		/*Reset Cursor to old position*/
+		ksSetCursor (ks, cursor);
+	}
+	return current;
+}
+
+/**
+ * @internal
+ *
+ * Exact lookup by name using the hash index.
+ *
+ * The index is built lazily, when enough binary searches were
+ * done on an unchanged keyset to pay for it.
+ *
+ * @retval 1 if the index was used, pos is set to the position or -1
+ * @retval 0 if there is no index (yet), binary search must be used
+ */
+static int elektraLookupHash(KeySet *ks, Key *key, ssize_t *pos)
+{
+	if (!ks->hashTable)
+	{
+		// unsorted keysets can only be searched using the index
+		if (!test_bit(ks->flags, KS_FLAG_UNSORTED))
+		{
+			if (ks->size < KEYSET_HASH_MIN_SIZE) return 0;
+			if (++ks->hashMisses * KEYSET_HASH_RATIO < ks->size) return 0;
+		}
+		if (elektraKsHashBuild(ks) == -1) return 0;
+	}
+
+	*pos = elektraKsHashLookup(ks, key);
+	return 1;
+}
+
+/**
+ * @internal
+ *
+ * Lookup ignoring case using the case-folded index.
+ *
+ * The index is built lazily on the second search of an unchanged
+ * keyset, so that single lookups do not pay for it.
+ *
+ * @retval 1 if the index was used, pos is set to the position or -1
+ * @retval 0 if there is no index (yet), linear search must be used
+ */
+static int elektraLookupCase(KeySet *ks, Key *key, option_t options,
+		ssize_t *pos)
+{
+	if (!ks->caseIndex)
+	{
+		if (ks->size < KEYSET_CASE_MIN_SIZE) return 0;
+		if (ks->caseScans++ == 0) return 0;
+		if (elektraKsCaseIndexBuild(ks) == -1) return 0;
+	}
+
+	*pos = elektraKsCaseSearch(ks, key, options);
+	return 1;
+}
+
+static Key * elektraLookupBinarySearch(KeySet *ks, Key *key, option_t options)
+{
+	cursor_t cursor = 0;
+	cursor = ksGetCursor (ks);
+	Key ** found;
+	size_t jump = 0;
+	size_t end = 0;
+	ssize_t pos = -1;
+
+	/* popping must not leave older keys with the same name behind */
+	if ((options & KDB_O_POP) && test_bit(ks->flags, KS_FLAG_UNSORTED))
+	{
+		elektraKsSort(ks);
+	}
+
+	if (!(options & (KDB_O_WITHOWNER|KDB_O_NOCASE)) &&
+		elektraLookupHash(ks, key, &pos))
+	{
+		if (pos == -1) return 0;
+		if (options & KDB_O_POP)
+		{
+			return ksPopAtCursor(ks, pos);
+		}
+		ksSetCursor(ks, pos);
+		return ks->array[pos];
+	}
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED))
+	{
+		elektraKsSort(ks);
+		cursor = ksGetCursor (ks);
+	}
+
+	if (options & KDB_O_NOCASE)
+	{
+		if (!elektraLookupCase(ks, key, options, &pos))
+		{
+			pos = elektraKsCaseScan(ks, key, options);
+		}
+		found = pos >= 0 ? ks->array+pos : 0;
+	}
+	else
+	{
+		end = ks->size;
+		elektraKsRange(ks, key, &jump, &end);
+		if (!test_bit(ks->flags, KS_FLAG_SORTKEYS)) elektraKsSortKeysBuild(ks);
+		const ssize_t result = elektraKsSearchRangeWith(ks, key, jump, end,
+			options & KDB_O_WITHOWNER ? keyCompareByNameOwner : keyCompareByName);
+		found = result >= 0 ? ks->array+result : 0;
+	}
+	if (found)
+	{
+		cursor = found-ks->array;
+		if (options & KDB_O_POP)
+		{
+			return ksPopAtCursor(ks, cursor);
+		} else {
+			ksSetCursor(ks, cursor);
+			return (*found);
+		}
+	} else {
+		ksSetCursor (ks, cursor);
+	}
+	return 0;
+}
+
+/**
+ * @internal
+ * @brief Helper for ksLookup
+ *
+ * Looks up exactly the name of @p key, without cascading.
+ */
+static Key *elektraLookupSearch(KeySet *ks, Key *key, option_t options)
+{
+	if (options & KDB_O_NOALL)
+	{
+		return elektraLookupLinearSearch(ks, key, options);
+	}
+
+	return elektraLookupBinarySearch(ks, key, options);
+}
+
+static Key * elektraLookupCreateKey(KeySet *ks, Key * key, ELEKTRA_UNUSED option_t options)
+{
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return 0;
+	Key *ret = keyDup(key);
+	ksAppendKey(ks, ret);
+	return ret;
+}
+
+
+/**
+ * Look for a Key contained in @p ks that matches the name of the @p key.
+ *
+ * @section Introduction
+ *
+ * @p ksLookup() is designed to let you work with
+ * entirely pre-loaded KeySets, so instead of kdbGetKey(), key by key, the
+ * idea is to fully kdbGet() for your application root key and
+ * process it all at once with @p ksLookup().
+ *
+ * This function is very efficient by using binary search. Together with
+ * kdbGet() which can you load the whole configuration with only
+ * some communication to backends you can write very effective but short
+ * code for configuration.
+ *
+ * When many lookups are done on a large keyset which is not modified
+ * in between, a hash index is built so that lookups by exact name
+ * take constant time.
+ *
+ * @section Usage
+ *
+ * If found, @p ks internal cursor will be positioned in the matched key
+ * (also accessible by ksCurrent()), and a pointer to the Key is returned.
+ * If not found, @p ks internal cursor will not move, and a NULL pointer is
+ * returned.
+ *
+ * Cascading is done if the first character is a /. This leads to ignoring
+ * the prefix like system/ and user/.
+ * @code
+if (kdbGet(handle, "user/myapp", myConfig, 0 ) == -1)
+	errorHandler ("Could not get Keys");
+
+if (kdbGet(handle, "system/myapp", myConfig, 0 ) == -1)
+	errorHandler ("Could not get Keys");
+
+if ((myKey = ksLookup(myConfig, key, 0)) == NULL)
+	errorHandler ("Could not Lookup Key");
+ * @endcode
+ *
+ * This is the way multi user Programs should get there configuration and
+ * search after the values. It is guaranteed that more namespaces can be
+ * added easily and that all values can be set by admin and user.
+ *
+ * @subsection KDB_O_NOALL
+ *
+ * When KDB_O_NOALL is set the keyset will be only searched from ksCurrent()
+ * to ksTail(). You need to ksRewind() the keyset yourself. ksCurrent() is
+ * always set properly after searching a key, so you can go on searching
+ * another key after the found key.
+ *
+ * When KDB_O_NOALL is not set the cursor will stay untouched and all keys
+ * are considered. A much more efficient binary search will be used then.
+ *
+ * @subsection KDB_O_POP
+ *
+ * When KDB_O_POP is set the key which was found will be ksPop()ed. ksCurrent()
+ * will not be changed, only iff ksCurrent() is the searched key, then the keyset
+ * will be ksRewind()ed.
+ *
+ * @note Like in ksPop() the popped key always needs to be keyDel() afterwards, even
+ * if it is appended to another keyset.
+ *
+ * @warning All cursors on the keyset will be invalid
+ * iff you use KDB_O_POP, so don't use this if you rely on a cursor, see ksGetCursor().
+ *
+ * You can solve this problem by using KDB_O_NOALL, risking you have to iterate n^2 instead of n.
+ *
+ * The more elegant way is to separate the keyset you use for ksLookup() and ksAppendKey():
+ * @code
+int f(KeySet *iterator, KeySet *lookup)
+{
+	KeySet *append = ksNew (ksGetSize(lookup), KS_END);
+	Key *key;
+	Key *current;
+
+	ksRewind(iterator);
+	while (current=ksNext(iterator))
+	{
+		key = ksLookup (lookup, current, KDB_O_POP);
+		// do something...
+		ksAppendKey(append, key); // now append it to append, not lookup!
+		keyDel (key); // make sure to ALWAYS delete poped keys.
+	}
+	ksAppend(lookup, append);
+	// now lookup needs to be sorted only once, append never
+	ksDel (append);
+}
+ * @endcode
+ *
+ * @param ks where to look for
+ * @param key the key object you are looking for
+ * @param options some @p KDB_O_* option bits:
+ * 	- @p KDB_O_NOCASE @n
+ * 		Lookup ignoring case. If several keys only differ in case,
+ * 		the first of them is found. Repeated lookups use a lazily
+ * 		built case-folded index.
+ * 	- @p KDB_O_WITHOWNER @n
+ * 		Also consider correct owner.
+ * 	- @p KDB_O_NOALL @n
+ * 		Only search from ksCurrent() to end of keyset, see above text.
+ * 	- @p KDB_O_POP @n
+ * 		Pop the key which was found.
+ *	- @p KDB_O_DEL @n
+ *		Delete the passed key.
+ * @return pointer to the Key found, 0 otherwise
+ * @return 0 on NULL pointers
+ * @see ksLookupByName() to search by a name given by a string
+ * @see ksCurrent(), ksRewind(), ksNext() for iterating over a keyset
+ */
+Key *ksLookup(KeySet *ks, Key * key, option_t options)
+{
+	if (!ks) return 0;
+	if (!key) return 0;
+
+	const char * name = key->key;
+	if (!name) return 0;
+
+	Key *ret = 0;
+	const int mask = ~KDB_O_DEL & ~KDB_O_CREATE;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED) && (options & KDB_O_NOALL))
+	{
+		elektraKsSort(ks);
+	}
+
+	if (options & KDB_O_SPEC)
+	{
+		Key *lookupKey = key;
+		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) lookupKey = keyDup(key);
+		ret = elektraLookupBySpec(ks, lookupKey, options & mask);
+		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) keyDel(lookupKey);
+	}
+	else if (!(options & KDB_O_NOCASCADING) && strcmp(name, "") && name[0] == '/')
+	{
+		Key *lookupKey = key;
+		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) lookupKey = keyDup(key);
+		ret = elektraLookupByCascading(ks, lookupKey, options & mask);
+		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) keyDel(lookupKey);
+	}
+	else
+	{
+		ret = elektraLookupSearch(ks, key, options & mask);
+	}
 
-	if (ks->size > 0) return ks->array[ks->size-1];
-	else return 0;
-}
+	if (!ret && options & KDB_O_CREATE) ret = elektraLookupCreateKey(ks, key, options & mask);
 
+	if (options & KDB_O_DEL) keyDel (key);
 
+	return ret;
+}
 
 /**
- * Get the KeySet internal cursor.
+ * Convenience method to look for a Key contained in @p ks that matches @p name.
  *
- * Use it to get the cursor of the actual position.
+ * @p ksLookupByName() is designed to let you work with
+ * entirely pre-loaded KeySets, so instead of kdbGetKey(), key by key, the
+ * idea is to fully kdbGetByName() for your application root key and
+ * process it all at once with @p ksLookupByName().
  *
- * @warning Cursors are getting invalid when the key
- * was ksPop()ed or ksLookup() with KDB_O_POP was
- * used.
+ * This function is very efficient by using binary search. Together with
+ * kdbGetByName() which can you load the whole configuration with only
+ * some communication to backends you can write very effective but short
+ * code for configuration.
  *
- * @section readahead Read ahead
+ * If found, @p ks internal cursor will be positioned in the matched key
+ * (also accessible by ksCurrent()), and a pointer to the Key is returned.
+ * If not found, @p ks internal cursor will not move, and a NULL pointer is
+ * returned.
+ * If requested to pop the key, the cursor will be rewinded.
  *
- * With the cursors it is possible to read ahead
- * in a keyset:
+ * @section cascading Cascading
  *
+ * Cascading is done if the first character is a /. This leads to ignoring
+ * the prefix like system/ and user/.
  * @code
-cursor_t jump;
-ksRewind (ks);
-while ((key = keyNextMeta (ks))!=0)
-{
-	// now mark this key
-	jump = ksGetCursor(ks);
+if (kdbGet(handle, "user/sw/myapp/current", myConfig, parentKey ) == -1)
+	errorHandler ("Could not get Keys", parentKey);
 
-	//code..
-	keyNextMeta (ks); // now browse on
-	// use ksCurrent(ks) to check the keys
-	//code..
+if (kdbGet(handle, "system/sw/myapp/current", myConfig, parentKey ) == -1)
+	errorHandler ("Could not get Keys", parentKey);
 
-	// jump back to the position marked before
-	ksSetCursor(ks, jump);
-}
+if ((myKey = ksLookupByName (myConfig, "/myapp/current/key", 0)) == NULL)
+	errorHandler ("Could not Lookup Key");
  * @endcode
  *
- * @section restore Restoring state
- *
- * It can also be used to restore the state of a
- * keyset in a function
+ * This is the way multi user Programs should get there configuration and
+ * search after the values. It is guaranteed that more namespaces can be
+ * added easily and that all values can be set by admin and user.
  *
+ * It is up to the application to implement a sophisticated cascading
+ * algorithm, for e.g. a list of profiles (specific, group and fallback):
  * @code
-int f (KeySet *ks)
-{
-	cursor_t state = ksGetCursor(ks);
-
-	// work with keyset
-
-	// now bring the keyset to the state before
-	ksSetCursor (ks, state);
-}
+if ((myKey = ksLookupByName (myConfig, "/myapp/current/specific/key", 0)) == NULL)
+	if ((myKey = ksLookupByName (myConfig, "/myapp/current/group/key", 0)) == NULL)
+		if ((myKey = ksLookupByName (myConfig, "/myapp/current/fallback/key", 0)) == NULL)
+			errorHandler ("All fallbacks failed to lookup key");
  * @endcode
  *
- * It is of course possible to make the KeySet const
- * and cast its const away to set the cursor.
- * Another way to achieve
- * the same is to ksDup() the keyset, but it is
- * not as efficient.
+ * Note that for every profile both the user and the system key are
+ * searched. The first key found will be used.
  *
- * An invalid cursor will be returned directly after
- * ksRewind(). When you set an invalid cursor ksCurrent()
- * is 0 and ksNext() == ksHead().
+ * @section fullsearch Full Search
  *
- * @note Only use a cursor for the same keyset which it was
- * made for.
+ * When KDB_O_NOALL is set the keyset will be only searched from ksCurrent()
+ * to ksTail(). You need to ksRewind() the keyset yourself. ksCurrent() is
+ * always set properly after searching a key, so you can go on searching
+ * another key after the found key.
  *
- * @param ks the keyset object to work with
- * @return a valid cursor on success
- * @return an invalid cursor on NULL pointer or after ksRewind()
- * @see ksNext(), ksSetCursor()
- */
-cursor_t ksGetCursor(const KeySet *ks)
-{
-	if (!ks) return (cursor_t) -1;
-
-	if (ks->cursor == 0) return (cursor_t) -1;
-	else return (cursor_t) ks->current;
-}
-
-/**
- * @brief return key at given cursor position
+ * When KDB_O_NOALL is not set the cursor will stay untouched and all keys
+ * are considered. A much more efficient binary search will be used then.
  *
- * @param ks the keyset to pop key from
- * @param pos where to get
- * @return the key at the cursor position on success
- * @retval NULL on NULL pointer, negative cursor position
- * or a position that does not lie within the keyset
+ * The name is canonicalized in a buffer on the stack, so no memory is
+ * allocated for usual names (except with @p KDB_O_CREATE).
+ * 
+ * @param ks where to look for
+ * @param name key name you are looking for
+ * @param options some @p KDB_O_* option bits:
+ * 	- @p KDB_O_NOCASE @n
+ * 		Lookup ignoring case.
+ * 	- @p KDB_O_WITHOWNER @n
+ * 		Also consider correct owner.
+ * 	- @p KDB_O_NOALL @n
+ * 		Only search from ksCurrent() to end of keyset, see above text.
+ * 	- @p KDB_O_POP @n
+ * 		Pop the key which was found.
+ *
+ * 	Currently no options supported.
+ * @return pointer to the Key found, 0 otherwise
+ * @return 0 on NULL pointers
+ * @see keyCompare() for very powerful Key lookups in KeySets
+ * @see ksCurrent(), ksRewind(), ksNext()
  */
-Key *ksAtCursor(KeySet *ks, cursor_t pos)
+Key *ksLookupByName(KeySet *ks, const char *name, option_t options)
 {
+	Key * found=0;
+
 	if (!ks) return 0;
-	if (pos < 0) return 0;
-	if (ks->size < (size_t)pos) return 0;
-	return ks->array[pos];
-}
+	if (!name) return 0;
 
+	if (!ks->size) return 0;
 
-/**
- * Set the KeySet internal cursor.
- *
- * Use it to set the cursor to a stored position.
- * ksCurrent() will then be the position which you got with.
- *
- * @warning Cursors may get invalid when the key
- * was ksPop()ed or ksLookup() was used together
- * with KDB_O_POP.
- *
- * @code
-cursor_t cursor;
-..
-// key now in any position here
-cursor = ksGetCursor (ks);
-while ((key = keyNextMeta (ks))!=0) {}
-ksSetCursor (ks, cursor); // reset state
-ksCurrent(ks); // in same position as before
- * @endcode
- *
- * An invalid cursor will set the keyset to its beginning like
- * ksRewind(). When you set an invalid cursor ksCurrent()
- * is 0 and ksNext() == ksHead().
- *
- * @param cursor the cursor to use
- * @param ks the keyset object to work with
- * @return 0 when the keyset is ksRewind()ed
- * @return 1 otherwise
- * @return -1 on NULL pointer
- * @see ksNext(), ksGetCursor()
- */
-int ksSetCursor(KeySet *ks, cursor_t cursor)
-{
-	if (!ks) return -1;
+	size_t buffer[KEY_STACK_ARENA_SIZE / sizeof(size_t)];
+	KeyArena arena;
+	struct _Key key;
 
-	if ((cursor_t) -1 == cursor)
+	keyInit(&key);
+	// the name is built on the stack, unless KDB_O_CREATE shares it
+	if (!(options & KDB_O_CREATE))
 	{
-		ksRewind (ks);
-		return 0;
+		elektraArenaInitStack(&arena, buffer, sizeof(buffer));
+		key.arena = &arena;
 	}
-	ks->current= (size_t)cursor;
-	ks->cursor=ks->array[ks->current];
-	return 1;
-}
+	elektraKeySetName(&key, name, KEY_META_NAME|KEY_CASCADING_NAME);
 
+	found = ksLookup(ks, &key, options & ~KDB_O_DEL);
+	elektraKeyFreeBuffer(&key, key.key, KEY_FLAG_ARENA_NAME);
+	ksDel(key.meta); // sometimes owner is set
+	if (key.arena) elektraArenaFreeStack(&arena, buffer);
+	return found;
+}
 
 
 
-/******************************************* 
- *    Looking up Keys inside KeySets       *
+/*******************************************
+ *             Batched lookups             *
  *******************************************/
 
 /**
  * @internal
- * @brief Helper for elektraLookupBySpec
- *
- * Lookup using links (fallback or override passed as buffer)
- *
- * @param ks the keyset to search in
- * @param specKey contains metadata as specified in buffer+#<number>
- * @param buffer the buffer used for incrementing numbers
  *
- * @return 
+ * Like keyCompareByName(), but keys without a name are sorted first.
  */
-static Key *elektraLookupBySpecLinks(KeySet *ks, Key *specKey, char *buffer)
+static int elektraKsCompareNamed(const void *p1, const void *p2)
 {
-	Key *ret = 0;
-	Key *k = 0;
-	const int prefixSize = ELEKTRA_MAX_PREFIX_SIZE - 2;
-	kdb_long_long_t i=0;
-	const Key *m = 0;
-
-	do {
-		elektraWriteArrayNumber(&buffer[prefixSize], i);
-		m = keyGetMeta(specKey, buffer);
-		if (!m) break;
-		// optimization: lazy instanziation of k
-		if (!k) k = keyNew(keyString(m), KEY_CASCADING_NAME,
-				KEY_END);
-		else elektraKeySetName(k, keyString(m),
-				KEY_CASCADING_NAME);
-		ret=ksLookup(ks, k, KDB_O_NODEFAULT);
-		if (ret) break;
-		++i;
-	} while(m);
+	const Key *key1 = *(const Key **)p1;
+	const Key *key2 = *(const Key **)p2;
+	if (!key1->key || !key2->key) return !!key1->key - !!key2->key;
+	return keyCompareByName(p1, p2);
+}
 
-	keyDel(k);
-	return ret;
+static int elektraKsCompareSortEntries(const void *p1, const void *p2)
+{
+	const KeySetSortEntry *entry1 = p1;
+	const KeySetSortEntry *entry2 = p2;
+	if (entry1->sortKey != entry2->sortKey)
+	{
+		return entry1->sortKey < entry2->sortKey ? -1 : 1;
+	}
+	return elektraKsCompareNamed(&entry1->key, &entry2->key);
 }
 
 /**
  * @internal
- * @brief Helper for elektraLookupBySpec
+ *
+ * Sorts keys by name, see elektraKsCompareNamed().
+ *
+ * Like for KeySet::sortKeys, the sort keys after the prefix all names
+ * share are sorted together with the keys, so that most comparisons
+ * neither call a function nor touch the names.
+ *
+ * @param entries space for count entries
  */
-static Key *elektraLookupBySpecDefault(KeySet *ks, Key *specKey)
+static void elektraKsSortNamed(Key **keys, KeySetSortEntry *entries, size_t count)
 {
-	Key *ret = 0;
-	const Key *m = 0;
-
-	ret=ksLookup(ks, specKey, KDB_O_NOCASCADING);
-	if (ret) return ret; // return previous added default key
+	const Key *ref = 0;
+	size_t offset = SIZE_MAX;
 
-	m = keyGetMeta(specKey, "default");
-	if (!m) return ret;
-	ret=keyNew(
-		keyName(specKey),
-		KEY_CASCADING_NAME,
-		KEY_VALUE, keyString(m),
-		KEY_END);
-	ksAppendKey(ks, ret);
+	for (size_t i=0; i<count; ++i)
+	{
+		if (!keys[i]->key) continue;
+		if (!ref) ref = keys[i];
+
+		const char *name = keys[i]->key + keys[i]->keySize;
+		const char *refName = ref->key + ref->keySize;
+		size_t common = 0;
+		while (common < offset && common < keys[i]->keyUSize &&
+			common < ref->keyUSize && name[common] == refName[common])
+		{
+			++ common;
+		}
+		offset = common;
+	}
 
-	return ret;
-}
+	for (size_t i=0; i<count; ++i)
+	{
+		entries[i].key = keys[i];
+		entries[i].sortKey = keys[i]->key ?
+			elektraKsSortKeyAt(keys[i], offset) : 0;
+	}
 
-static Key *elektraLookupByCascading(KeySet *ks, Key *key, option_t options);
+	qsort(entries, count, sizeof(KeySetSortEntry), elektraKsCompareSortEntries);
+
+	for (size_t i=0; i<count; ++i) keys[i] = entries[i].key;
+}
 
 /**
  * @internal
- * @brief Helper for elektraLookupBySpec
  *
- * Lookup using namespaces
+ * Prepares ks for looking up count keys at once.
  *
- * @param ks the keyset to search in
- * @param specKey contains metadata as specified in buffer+#<number>
- * @param buffer the buffer used for incrementing numbers
+ * Like for ksLookup(), the hash index is built if the lookups pay
+ * for it, otherwise the sort keys are built for the merge.
+ *
+ * @retval 1 if the hash index will be used
+ * @retval 0 if the wanted keys need to be sorted
  */
-static Key *elektraLookupBySpecNamespaces(KeySet *ks, Key *specKey, char *buffer)
+static int elektraKsBatchPrepare(KeySet *ks, size_t count)
 {
-	Key *ret = 0;
-	const int prefixSize = ELEKTRA_MAX_PREFIX_SIZE - 1;
-	kdb_long_long_t i=0;
-	const Key *m = 0;
-
-	m = keyGetMeta(specKey, buffer);
-	// no namespaces specified, so do a default cascading lookup
-	// (obviously w/o spec)
-	if (!m) return elektraLookupByCascading(ks, specKey, KDB_O_NOSPEC | KDB_O_NODEFAULT);
-
-	// store old name of specKey
-	char * name = specKey->key;
-	size_t size = specKey->keySize;
-	size_t usize = specKey->keyUSize;
-	size_t nameLength = strlen (name);
-	size_t maxSize = nameLength + ELEKTRA_MAX_NAMESPACE_SIZE;
-	char newname[maxSize*2]; // buffer for all new names (namespace + cascading key name)
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
 
-	do {
-		// lookup with given namespace
-		size_t namespaceSize = keyGetValueSize(m);
-		char *startOfName = newname+ELEKTRA_MAX_NAMESPACE_SIZE-namespaceSize;
-		strncpy (startOfName, keyString(m), namespaceSize);
-		strcpy  (newname+ELEKTRA_MAX_NAMESPACE_SIZE-1, name); // name starts with /
-		specKey->key = startOfName;
-		specKey->keySize = nameLength + namespaceSize;
-		elektraFinalizeName(specKey);
-		ret=ksLookup(ks, specKey, 0);
-		if (ret) break;
-		++i; // start with 1 (#0 was already in buffer)
-
-		elektraWriteArrayNumber(&buffer[prefixSize], i);
-		m = keyGetMeta(specKey, buffer);
-	} while(m);
+	if (!ks->hashTable && ks->size >= KEYSET_HASH_MIN_SIZE &&
+		(ks->hashMisses + count) * KEYSET_HASH_RATIO >= ks->size)
+	{
+		elektraKsHashBuild(ks);
+	}
+	if (ks->hashTable) return 1;
 
-	// restore old cascading name
-	specKey->key = name;
-	specKey->keySize = size;
-	specKey->keyUSize = usize ;
-	return ret;
+	ks->hashMisses += count;
+	if (!test_bit(ks->flags, KS_FLAG_SORTKEYS)) elektraKsSortKeysBuild(ks);
+	return 0;
 }
 
-
 /**
  * @internal
- * @brief Helper for ksLookup
+ *
+ * Looks up sorted keys in one pass over the keyset.
+ *
+ * Every search starts where the previous one ended. The end of
+ * the search is found by doubling the distance, so that looking
+ * up a few keys in a large keyset needs no more comparisons than
+ * single binary searches. If the keyset has a hash index, it is
+ * used instead.
+ *
+ * @pre elektraKsBatchPrepare() was called
+ * @pre wanted is sorted by name, see keyCompareByName(),
+ *      unless ks has a hash index
+ * @param found gets the key found for every wanted key or 0
+ * @return the number of keys found
  */
-static Key *elektraLookupBySpec(KeySet *ks, Key *specKey, option_t options)
+static ssize_t elektraKsMergeLookup(KeySet *ks, Key **wanted, size_t count,
+		Key **found)
 {
-	Key *ret = 0;
-	// strip away beginning of specKey
-	char * name = specKey->key;
-	// stays same if already cascading and
-	// root must not be cascaded, so the usage of strchr is safe.
-	specKey->key = strchr(name, '/');
-	size_t size = specKey->keySize;
-	specKey->keySize = size - (specKey->key - name);
-	elektraFinalizeName(specKey);
+	const cursor_t cursor = ksGetCursor(ks);
+	ssize_t matches = 0;
+	size_t pos = 0;
 
-	// lookup by override
-	char buffer [ELEKTRA_MAX_PREFIX_SIZE + ELEKTRA_MAX_ARRAY_SIZE]
-		= "override/";
-	ret = elektraLookupBySpecLinks(ks, specKey, buffer);
-	if (ret) goto finished;
+	for (size_t i=0; i<count; ++i)
+	{
+		Key *key = wanted[i];
+		found[i] = 0;
 
-	// lookup by namespaces
-	strcpy (buffer, "namespace/#0");
-	ret=elektraLookupBySpecNamespaces(ks, specKey, buffer);
-	if (ret) goto finished;
+		if (!key->key || !ks->size) continue;
 
-	// lookup by fallback
-	strcpy (buffer, "fallback/");
-	ret = elektraLookupBySpecLinks(ks, specKey, buffer);
-	if (ret) goto finished;
+		if (key->key[0] == '/')
+		{
+			// cascading keys are spread over all namespaces
+			found[i] = ksLookup(ks, key, 0);
+			if (found[i]) ++ matches;
+			continue;
+		}
 
-	if (!(options & KDB_O_NODEFAULT))
-	{
-		ret = elektraLookupBySpecDefault(ks, specKey);
-	}
+		if (ks->hashTable)
+		{
+			const ssize_t result = elektraKsHashLookup(ks, key);
+			if (result >= 0)
+			{
+				found[i] = ks->array[result];
+				++ matches;
+			}
+			continue;
+		}
 
-finished:
-	specKey->key = name;
-	specKey->keySize = size;
-	elektraFinalizeName(specKey);
+		kdb_unsigned_long_long_t sortKey = 0;
+		const int sorted = elektraKsSortKey(ks, key, ks->array[0], &sortKey);
+		size_t end = pos;
+		size_t step = 1;
+		while (end < ks->size &&
+			(sorted && ks->sortKeys[end] != sortKey ?
+				ks->sortKeys[end] < sortKey :
+				keyCompareByName(&ks->array[end], &key) < 0))
+		{
+			pos = end+1;
+			end += step;
+			step *= 2;
+		}
+		if (end >= ks->size) end = ks->size-1;
 
-	return ret;
+		const ssize_t result = elektraKsSearchRangeWith(ks, key,
+			pos, end+1, keyCompareByName);
+		if (result >= 0)
+		{
+			found[i] = ks->array[result];
+			pos = result;
+			++ matches;
+		}
+		else pos = -result-1;
+	}
+
+	ksSetCursor(ks, cursor);
+	return matches;
 }
 
 /**
- * @internal
- * @brief Helper for ksLookup
+ * Looks up many keys at once.
+ *
+ * Instead of a ksLookup() for every key, the keys in @p wanted are
+ * looked up in a single pass over @p ks. Large batches use the hash
+ * index of @p ks instead, which is built like for ksLookup().
+ * Keys of @p wanted are only compared by name, like ksLookup()
+ * without options does. Cascading keys are looked up with
+ * ksLookup(), the cursor of @p ks is left untouched.
+ *
+ * @code
+KeySet *wanted = ksNew(3,
+	keyNew("user/sw/app/width", KEY_END),
+	keyNew("user/sw/app/height", KEY_END),
+	keyNew("user/sw/app/color", KEY_END),
+	KS_END);
+Key *found[3];
+elektraKsLookupKeys(config, wanted, found);
+// found[i] is the key for the i-th key of wanted
+ * @endcode
+ *
+ * @param ks the keyset to look up the keys in
+ * @param wanted the keys to look for, it will be sorted
+ * @param found array with space for ksGetSize(wanted) keys, gets the
+ *        key found for every key of @p wanted in its order, or 0
+ * @return the number of keys found
+ * @retval -1 on NULL pointers
+ * @see elektraKsLookupNames() to look up names
+ * @ingroup proposal
  */
-static Key *elektraLookupByCascading(KeySet *ks, Key *key, option_t options)
+ssize_t elektraKsLookupKeys(KeySet *ks, KeySet *wanted, Key **found)
 {
-	char * name = key->key;
-	size_t size = key->keySize;
-	size_t usize = key->keyUSize;
-	size_t length = strlen (name) + ELEKTRA_MAX_NAMESPACE_SIZE;
-	char newname[length*2];
-	Key *found = 0;
-	Key *specKey = 0;
+	if (!ks || !wanted || !found) return -1;
 
-	if (!(options & KDB_O_NOSPEC))
-	{
-		strncpy (newname+2, "spec", 4);
-		strcpy  (newname+6, name);
-		key->key = newname+2;
-		key->keySize = length-2;
-		elektraFinalizeName(key);
-		specKey = ksLookup(ks, key, options & ~KDB_O_DEL);
-	}
+	elektraKsBatchPrepare(ks, wanted->size);
+	if (test_bit(wanted->flags, KS_FLAG_UNSORTED)) elektraKsSort(wanted);
 
-	if (specKey)
-	{
-		// restore old name
-		key->key = name;
-		key->keySize = size;
-		key->keyUSize = usize ;
+	return elektraKsMergeLookup(ks, wanted->array, wanted->size, found);
+}
 
-		// we found a spec key, so we know what to do
-		specKey = keyDup(specKey);
-		found = elektraLookupBySpec(ks, specKey, options);
-		keyDel(specKey);
-		return found;
-	}
+/**
+ * Looks up many key names at once.
+ *
+ * Like elektraKsLookupKeys(), but with names as ksLookupByName()
+ * takes them. The names are sorted once and looked up in a single
+ * pass over @p ks, or with its hash index.
+ * All names are allocated together, so that there is no allocation
+ * per name.
+ *
+ * @code
+const char *names[] = {"user/sw/app/width", "user/sw/app/height", "/sw/app/color"};
+Key *found[3];
+elektraKsLookupNames(config, names, 3, found);
+// found[i] is the key named names[i] or 0
+ * @endcode
+ *
+ * @param ks the keyset to look up the keys in
+ * @param names the names to look for, in any order
+ * @param count the number of names
+ * @param found array with space for @p count keys, gets the key
+ *        found for every name, or 0
+ * @return the number of keys found
+ * @retval -1 on NULL pointers or memory errors
+ * @see elektraKsLookupKeys()
+ * @ingroup proposal
+ */
+ssize_t elektraKsLookupNames(KeySet *ks, const char **names, size_t count,
+		Key **found)
+{
+	if (!ks || !names || !found) return -1;
+	if (!count) return 0;
 
-	// default cascading:
-	strncpy (newname+2, "proc", 4);
-	strcpy  (newname+6, name);
-	key->key = newname+2;
-	key->keySize = length-2;
-	elektraFinalizeName(key);
-	found = ksLookup(ks, key, options & ~KDB_O_DEL);
+	KeyArena *arena = elektraArenaNew();
+	if (!arena) return -1;
 
-	if (!found)
+	// the keys, their sort entries, the sorted keys and what was found for them
+	char *buffer = elektraMalloc(count * (sizeof(struct _Key) +
+		sizeof(KeySetSortEntry) + 2*sizeof(Key *)));
+	if (!buffer)
 	{
-		strncpy (newname+3, "dir", 3);
-		strcpy  (newname+6, name);
-		key->key = newname+3;
-		key->keySize = length-3;
-		elektraFinalizeName(key);
-		found = ksLookup(ks, key, options & ~KDB_O_DEL);
+		elektraArenaClose(arena);
+		return -1;
 	}
+	struct _Key *keys = (struct _Key *) buffer;
+	KeySetSortEntry *entries = (KeySetSortEntry *) (keys + count);
+	Key **sorted = (Key **) (entries + count);
+	Key **sortedFound = sorted + count;
 
-	if (!found)
+	int isSorted = 1;
+	for (size_t i=0; i<count; ++i)
 	{
-		strncpy (newname+2, "user", 4);
-		strcpy  (newname+6, name);
-		key->key = newname+2;
-		key->keySize = length-2;
-		elektraFinalizeName(key);
-		found = ksLookup(ks, key, options & ~KDB_O_DEL);
+		keyInit(&keys[i]);
+		keys[i].arena = arena;
+		if (names[i]) elektraKeySetName(&keys[i], names[i],
+			KEY_META_NAME|KEY_CASCADING_NAME);
+		sorted[i] = &keys[i];
+		if (i > 0 && elektraKsCompareNamed(&sorted[i-1], &sorted[i]) > 0)
+		{
+			isSorted = 0;
+		}
 	}
 
-	if (!found)
+	if (!elektraKsBatchPrepare(ks, count) && !isSorted)
 	{
-		strncpy (newname, "system",6);
-		strcpy  (newname+6, name);
-		key->key = newname;
-		key->keySize = length;
-		elektraFinalizeName(key);
-		found = ksLookup(ks, key, options & ~KDB_O_DEL);
+		elektraKsSortNamed(sorted, entries, count);
 	}
+	const ssize_t matches = elektraKsMergeLookup(ks, sorted, count, sortedFound);
 
-	// restore old cascading name
-	key->key = name;
-	key->keySize = size;
-	key->keyUSize = usize ;
-
-	if (!found && !(options & KDB_O_NODEFAULT))
+	for (size_t i=0; i<count; ++i)
 	{
-		// search / key itself
-		found = ksLookup(ks, key, (options & ~KDB_O_DEL) | KDB_O_NOCASCADING);
+		found[sorted[i]-keys] = sortedFound[i];
+		if (keys[i].key) elektraKeyFreeBuffer(&keys[i], keys[i].key, KEY_FLAG_ARENA_NAME);
+		ksDel(keys[i].meta); // sometimes owner is set
 	}
+	elektraFree(buffer);
+	elektraArenaClose(arena);
 
-	return found;
+	return matches;
 }
 
-static Key * elektraLookupLinearSearch(KeySet *ks, Key *key, option_t options)
+
+
+/*******************************************
+ *          Non-mutating lookups           *
+ *******************************************/
+
+/**
+ * @internal
+ * @brief Helper for elektraKsLookupConst
+ *
+ * Looks up exactly the name of @p key, without cascading.
+ *
+ * Indices are used if they are there, but never built.
+ */
+static const Key *elektraLookupConstSearch(const KeySet *ks, const Key *key,
+		option_t options)
 {
-	cursor_t cursor = 0;
-	cursor = ksGetCursor (ks);
-	Key *current;
-	if (!(options & KDB_O_NOALL)) ksRewind(ks);
-	while ((current=ksNext(ks)) != 0)
+	int (*compare)(const void *, const void *) = keyCompareByName;
+	if (options & KDB_O_NOCASE)
 	{
-		if ((options & KDB_O_WITHOWNER) && (options & KDB_O_NOCASE))
-		{
-			if (!keyCompareByNameOwnerCase(&key, &current)) break;
-		}
-		else if (options & KDB_O_WITHOWNER)
+		compare = keyCompareByNameCase;
+		if (ks->caseIndex)
 		{
-			if (!keyCompareByNameOwner(&key, &current)) break;
+			const ssize_t pos = elektraKsCaseSearch(ks, key, 0);
+			return pos == -1 ? 0 : ks->array[pos];
 		}
-		else if (options & KDB_O_NOCASE)
+	}
+	else if (ks->hashTable)
+	{
+		const ssize_t pos = elektraKsHashLookup(ks, key);
+		return pos == -1 ? 0 : ks->array[pos];
+	}
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED))
+	{
+		// the key appended last wins, see elektraKsSort()
+		for (size_t i=ks->size; i>0; --i)
 		{
-			if (!keyCompareByNameCase(&key, &current)) break;
+			if (!compare(&key, &ks->array[i-1])) return ks->array[i-1];
 		}
-		else if (!keyCompareByName(&key, &current)) break;
+		return 0;
 	}
-	if (current == 0)
+
+	if (options & KDB_O_NOCASE)
 	{
-		/*Reset Cursor to old position*/
-		ksSetCursor (ks, cursor);
+		const ssize_t pos = elektraKsCaseScan(ks, key, 0);
+		return pos == -1 ? 0 : ks->array[pos];
 	}
-	return current;
+
+	size_t begin = 0;
+	size_t end = ks->size;
+	elektraKsRangeConst(ks, key, &begin, &end);
+
+	const ssize_t pos = elektraKsSearchRangeWith(ks, key, begin, end, compare);
+	return pos >= 0 ? ks->array[pos] : 0;
 }
 
-static Key * elektraLookupBinarySearch(KeySet *ks, Key *key, option_t options)
+/**
+ * @internal
+ *
+ * Like keyGetMeta(), but does not move the cursor of the meta data
+ * and does not build indices, used for frozen keys and by
+ * elektraLookupConstBySpec().
+ */
+const Key *elektraKeyGetMetaConst(const Key *key, const char *metaName)
+{
+	if (!key->meta) return 0;
+
+	struct _Key search;
+	keyInit(&search);
+	elektraKeySetName(&search, metaName, KEY_META_NAME);
+
+	const Key *ret = elektraLookupConstSearch(key->meta, &search, 0);
+	elektraKeyFreeBuffer(&search, search.key, KEY_FLAG_ARENA_NAME);
+
+	return ret;
+}
+
+static const Key *elektraLookupConstByCascading(const KeySet *ks,
+		const Key *key, option_t options);
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupConstBySpec
+ *
+ * Like elektraLookupBySpecLinks()
+ */
+static const Key *elektraLookupConstBySpecLinks(const KeySet *ks,
+		const Key *specKey, char *buffer)
+{
+	const Key *ret = 0;
+	const int prefixSize = ELEKTRA_MAX_PREFIX_SIZE - 2;
+	kdb_long_long_t i=0;
+	const Key *m = 0;
+
+	do {
+		elektraWriteArrayNumber(&buffer[prefixSize], i);
+		m = elektraKeyGetMetaConst(specKey, buffer);
+		if (!m) break;
+		ret = elektraKsLookupByNameConst(ks, keyString(m), KDB_O_NODEFAULT);
+		if (ret) break;
+		++i;
+	} while(m);
+
+	return ret;
+}
+
+/**
+ * @internal
+ * @brief Helper for elektraLookupConstBySpec
+ *
+ * Like elektraLookupBySpecNamespaces()
+ */
+static const Key *elektraLookupConstBySpecNamespaces(const KeySet *ks,
+		const Key *specKey, char *buffer)
+{
+	const Key *ret = 0;
+	const int prefixSize = ELEKTRA_MAX_PREFIX_SIZE - 1;
+	kdb_long_long_t i=0;
+	const Key *m = 0;
+
+	m = elektraKeyGetMetaConst(specKey, buffer);
+	if (!m) return elektraLookupConstByCascading(ks, specKey,
+			KDB_O_NOSPEC | KDB_O_NODEFAULT);
+
+	const char *name = specKey->key;
+	size_t nameLength = strlen (name);
+	size_t maxSize = nameLength + ELEKTRA_MAX_NAMESPACE_SIZE;
+	char newname[maxSize*2];
+	struct _Key probe = *specKey;
+
+	do {
+		size_t namespaceSize = keyGetValueSize(m);
+		char *startOfName = newname+ELEKTRA_MAX_NAMESPACE_SIZE-namespaceSize;
+		strncpy (startOfName, keyString(m), namespaceSize);
+		strcpy  (newname+ELEKTRA_MAX_NAMESPACE_SIZE-1, name);
+		probe.key = startOfName;
+		probe.keySize = nameLength + namespaceSize;
+		elektraFinalizeName(&probe);
+		ret = elektraKsLookupConst(ks, &probe, 0);
+		if (ret) break;
+		++i;
+
+		elektraWriteArrayNumber(&buffer[prefixSize], i);
+		m = elektraKeyGetMetaConst(specKey, buffer);
+	} while(m);
+
+	return ret;
+}
+
+/**
+ * @internal
+ * @brief Helper for elektraKsLookupConst
+ *
+ * Like elektraLookupBySpec(), but works on a copy of the name.
+ * Defaults are only found if ksLookup() added them before.
+ */
+static const Key *elektraLookupConstBySpec(const KeySet *ks,
+		const Key *specKey, option_t options)
 {
-	cursor_t cursor = 0;
-	cursor = ksGetCursor (ks);
-	Key ** found;
-	size_t jump = 0;
-	/*If there is a known offset in the beginning jump could be set*/
-	if ((options & KDB_O_WITHOWNER) && (options & KDB_O_NOCASE))
-		found = (Key **) bsearch (&key, ks->array+jump, ks->size-jump,
-			sizeof (Key *), keyCompareByNameOwnerCase);
-	else if (options & KDB_O_WITHOWNER)
-		found = (Key **) bsearch (&key, ks->array+jump, ks->size-jump,
-			sizeof (Key *), keyCompareByNameOwner);
-	else if (options & KDB_O_NOCASE)
-		found = (Key **) bsearch (&key, ks->array+jump, ks->size-jump,
-			sizeof (Key *), keyCompareByNameCase);
-	else
-		found = (Key **) bsearch (&key, ks->array+jump, ks->size-jump,
-			sizeof (Key *), keyCompareByName);
-	if (found)
+	const char *cascading = strchr(specKey->key, '/');
+	if (!cascading) return 0;
+
+	const size_t size = specKey->keySize - (cascading - specKey->key);
+	char name[size*2];
+	memcpy(name, cascading, size);
+
+	struct _Key probe = *specKey;
+	probe.key = name;
+	probe.keySize = size;
+	elektraFinalizeName(&probe);
+
+	const Key *ret = 0;
+	char buffer [ELEKTRA_MAX_PREFIX_SIZE + ELEKTRA_MAX_ARRAY_SIZE]
+		= "override/";
+	ret = elektraLookupConstBySpecLinks(ks, &probe, buffer);
+	if (ret) return ret;
+
+	strcpy (buffer, "namespace/#0");
+	ret = elektraLookupConstBySpecNamespaces(ks, &probe, buffer);
+	if (ret) return ret;
+
+	strcpy (buffer, "fallback/");
+	ret = elektraLookupConstBySpecLinks(ks, &probe, buffer);
+	if (ret) return ret;
+
+	if (!(options & KDB_O_NODEFAULT))
 	{
-		cursor = found-ks->array;
-		if (options & KDB_O_POP)
-		{
-			return ksPopAtCursor(ks, cursor);
-		} else {
-			ksSetCursor(ks, cursor);
-			return (*found);
-		}
-	} else {
-		ksSetCursor (ks, cursor);
+		ret = elektraLookupConstSearch(ks, &probe, 0);
 	}
-	return 0;
-}
 
-static Key * elektraLookupCreateKey(KeySet *ks, Key * key, ELEKTRA_UNUSED option_t options)
-{
-	Key *ret = keyDup(key);
-	ksAppendKey(ks, ret);
 	return ret;
 }
 
-
 /**
- * Look for a Key contained in @p ks that matches the name of the @p key.
- *
- * @section Introduction
- *
- * @p ksLookup() is designed to let you work with
- * entirely pre-loaded KeySets, so instead of kdbGetKey(), key by key, the
- * idea is to fully kdbGet() for your application root key and
- * process it all at once with @p ksLookup().
- *
- * This function is very efficient by using binary search. Together with
- * kdbGet() which can you load the whole configuration with only
- * some communication to backends you can write very effective but short
- * code for configuration.
- *
- * @section Usage
- *
- * If found, @p ks internal cursor will be positioned in the matched key
- * (also accessible by ksCurrent()), and a pointer to the Key is returned.
- * If not found, @p ks internal cursor will not move, and a NULL pointer is
- * returned.
+ * @internal
+ * @brief Helper for elektraKsLookupConst
  *
- * Cascading is done if the first character is a /. This leads to ignoring
- * the prefix like system/ and user/.
- * @code
-if (kdbGet(handle, "user/myapp", myConfig, 0 ) == -1)
-	errorHandler ("Could not get Keys");
+ * Like elektraLookupByCascading(), but works on a copy of the key.
+ */
+static const Key *elektraLookupConstByCascading(const KeySet *ks,
+		const Key *key, option_t options)
+{
+	const size_t usize = key->keyUSize;
+	char newname[ELEKTRA_MAX_NAMESPACE_SIZE + usize];
+	memcpy(newname + ELEKTRA_MAX_NAMESPACE_SIZE, key->key + key->keySize + 1,
+			usize - 1);
+	struct _Key probe = *key;
+	const Key *found = 0;
 
-if (kdbGet(handle, "system/myapp", myConfig, 0 ) == -1)
-	errorHandler ("Could not get Keys");
+	if (!(options & KDB_O_NOSPEC))
+	{
+		elektraLookupSetNamespace(&probe, newname, usize, "spec");
+		const Key *specKey = elektraLookupConstSearch(ks, &probe, options);
+		if (specKey) return elektraLookupConstBySpec(ks, specKey, options);
+	}
 
-if ((myKey = ksLookup(myConfig, key, 0)) == NULL)
-	errorHandler ("Could not Lookup Key");
- * @endcode
- *
- * This is the way multi user Programs should get there configuration and
- * search after the values. It is guaranteed that more namespaces can be
- * added easily and that all values can be set by admin and user.
- *
- * @subsection KDB_O_NOALL
- *
- * When KDB_O_NOALL is set the keyset will be only searched from ksCurrent()
- * to ksTail(). You need to ksRewind() the keyset yourself. ksCurrent() is
- * always set properly after searching a key, so you can go on searching
- * another key after the found key.
- *
- * When KDB_O_NOALL is not set the cursor will stay untouched and all keys
- * are considered. A much more efficient binary search will be used then.
- *
- * @subsection KDB_O_POP
- *
- * When KDB_O_POP is set the key which was found will be ksPop()ed. ksCurrent()
- * will not be changed, only iff ksCurrent() is the searched key, then the keyset
- * will be ksRewind()ed.
- *
- * @note Like in ksPop() the popped key always needs to be keyDel() afterwards, even
- * if it is appended to another keyset.
- *
- * @warning All cursors on the keyset will be invalid
- * iff you use KDB_O_POP, so don't use this if you rely on a cursor, see ksGetCursor().
- *
- * You can solve this problem by using KDB_O_NOALL, risking you have to iterate n^2 instead of n.
- *
- * The more elegant way is to separate the keyset you use for ksLookup() and ksAppendKey():
- * @code
-int f(KeySet *iterator, KeySet *lookup)
-{
-	KeySet *append = ksNew (ksGetSize(lookup), KS_END);
-	Key *key;
-	Key *current;
+	static const char * const namespaces[] = {"proc", "dir", "user", "system"};
+	for (size_t i=0; !found && i<sizeof(namespaces)/sizeof(namespaces[0]); ++i)
+	{
+		elektraLookupSetNamespace(&probe, newname, usize, namespaces[i]);
+		found = elektraLookupConstSearch(ks, &probe, options);
+	}
 
-	ksRewind(iterator);
-	while (current=ksNext(iterator))
+	if (!found && !(options & KDB_O_NODEFAULT))
 	{
-		key = ksLookup (lookup, current, KDB_O_POP);
-		// do something...
-		ksAppendKey(append, key); // now append it to append, not lookup!
-		keyDel (key); // make sure to ALWAYS delete poped keys.
+		// search / key itself
+		found = elektraLookupConstSearch(ks, key, options);
 	}
-	ksAppend(lookup, append);
-	// now lookup needs to be sorted only once, append never
-	ksDel (append);
+
+	return found;
 }
- * @endcode
+
+/**
+ * Look for a Key contained in @p ks that matches the name of the @p key,
+ * without changing anything.
+ *
+ * Unlike ksLookup() neither @p ks, nor its keys, nor @p key are modified.
+ * The internal cursor stays where it is and lookup indices are only used
+ * if they are already built. So many threads can look up keys in the same
+ * KeySet at the same time, as long as no thread modifies it.
+ *
+ * Cascading lookups and lookups by specification (@p KDB_O_SPEC) work
+ * like in ksLookup(). Defaults of the specification are only found if a
+ * ksLookup() already added them to the KeySet.
  *
  * @param ks where to look for
  * @param key the key object you are looking for
  * @param options some @p KDB_O_* option bits:
  * 	- @p KDB_O_NOCASE @n
- * 		Lookup ignoring case (needs KDB_O_NOALL).
- * 	- @p KDB_O_WITHOWNER @n
- * 		Also consider correct owner.
- * 	- @p KDB_O_NOALL @n
- * 		Only search from ksCurrent() to end of keyset, see above text.
- * 	- @p KDB_O_POP @n
- * 		Pop the key which was found.
- *	- @p KDB_O_DEL @n
- *		Delete the passed key.
+ * 		Lookup ignoring case.
+ * 	- @p KDB_O_NOCASCADING, @p KDB_O_SPEC, @p KDB_O_NODEFAULT @n
+ * 		Like for ksLookup().
+ *
+ * 	Options which would change the KeySet (@p KDB_O_POP, @p KDB_O_DEL,
+ * 	@p KDB_O_CREATE), use its cursor (@p KDB_O_NOALL) or the meta
+ * 	data of the keys (@p KDB_O_WITHOWNER) are not supported.
  * @return pointer to the Key found, 0 otherwise
- * @return 0 on NULL pointers
- * @see ksLookupByName() to search by a name given by a string
- * @see ksCurrent(), ksRewind(), ksNext() for iterating over a keyset
+ * @retval 0 on NULL pointers or unsupported options
+ * @see ksLookup()
+ * @ingroup proposal
  */
-Key *ksLookup(KeySet *ks, Key * key, option_t options)
+const Key *elektraKsLookupConst(const KeySet *ks, const Key *key, option_t options)
 {
 	if (!ks) return 0;
 	if (!key) return 0;
@@ -1933,137 +4717,73 @@ Key *ksLookup(KeySet *ks, Key * key, option_t options)
 	const char * name = key->key;
 	if (!name) return 0;
 
-	Key *ret = 0;
-	const int mask = ~KDB_O_DEL & ~KDB_O_CREATE;
+	if (options & (KDB_O_POP|KDB_O_DEL|KDB_O_CREATE|KDB_O_NOALL|KDB_O_WITHOWNER))
+	{
+		return 0;
+	}
 
 	if (options & KDB_O_SPEC)
 	{
-		Key *lookupKey = key;
-		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) lookupKey = keyDup(key);
-		ret = elektraLookupBySpec(ks, lookupKey, options & mask);
-		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) keyDel(lookupKey);
+		return elektraLookupConstBySpec(ks, key, options);
 	}
 	else if (!(options & KDB_O_NOCASCADING) && strcmp(name, "") && name[0] == '/')
 	{
-		Key *lookupKey = key;
-		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) lookupKey = keyDup(key);
-		ret = elektraLookupByCascading(ks, lookupKey, options & mask);
-		if (test_bit(key->flags, KEY_FLAG_RO_NAME)) keyDel(lookupKey);
-	}
-	else if ((options & KDB_O_NOALL)
-		// || (options & KDB_O_NOCASE)
-		// || (options & KDB_O_WITHOWNER)
-		) // TODO binary search with nocase won't work
-	{
-		ret = elektraLookupLinearSearch(ks, key, options & mask);
-	}
-	else
-	{
-		ret = elektraLookupBinarySearch(ks, key, options & mask);
+		return elektraLookupConstByCascading(ks, key, options);
 	}
 
-	if (!ret && options & KDB_O_CREATE) ret = elektraLookupCreateKey(ks, key, options & mask);
-
-	if (options & KDB_O_DEL) keyDel (key);
-
-	return ret;
+	return elektraLookupConstSearch(ks, key, options);
 }
 
 /**
- * Convenience method to look for a Key contained in @p ks that matches @p name.
- *
- * @p ksLookupByName() is designed to let you work with
- * entirely pre-loaded KeySets, so instead of kdbGetKey(), key by key, the
- * idea is to fully kdbGetByName() for your application root key and
- * process it all at once with @p ksLookupByName().
- *
- * This function is very efficient by using binary search. Together with
- * kdbGetByName() which can you load the whole configuration with only
- * some communication to backends you can write very effective but short
- * code for configuration.
- *
- * If found, @p ks internal cursor will be positioned in the matched key
- * (also accessible by ksCurrent()), and a pointer to the Key is returned.
- * If not found, @p ks internal cursor will not move, and a NULL pointer is
- * returned.
- * If requested to pop the key, the cursor will be rewinded.
- *
- * @section cascading Cascading
- *
- * Cascading is done if the first character is a /. This leads to ignoring
- * the prefix like system/ and user/.
- * @code
-if (kdbGet(handle, "user/sw/myapp/current", myConfig, parentKey ) == -1)
-	errorHandler ("Could not get Keys", parentKey);
-
-if (kdbGet(handle, "system/sw/myapp/current", myConfig, parentKey ) == -1)
-	errorHandler ("Could not get Keys", parentKey);
-
-if ((myKey = ksLookupByName (myConfig, "/myapp/current/key", 0)) == NULL)
-	errorHandler ("Could not Lookup Key");
- * @endcode
- *
- * This is the way multi user Programs should get there configuration and
- * search after the values. It is guaranteed that more namespaces can be
- * added easily and that all values can be set by admin and user.
- *
- * It is up to the application to implement a sophisticated cascading
- * algorithm, for e.g. a list of profiles (specific, group and fallback):
- * @code
-if ((myKey = ksLookupByName (myConfig, "/myapp/current/specific/key", 0)) == NULL)
-	if ((myKey = ksLookupByName (myConfig, "/myapp/current/group/key", 0)) == NULL)
-		if ((myKey = ksLookupByName (myConfig, "/myapp/current/fallback/key", 0)) == NULL)
-			errorHandler ("All fallbacks failed to lookup key");
- * @endcode
- *
- * Note that for every profile both the user and the system key are
- * searched. The first key found will be used.
- *
- * @section fullsearch Full Search
+ * Look for a Key contained in @p ks that matches @p name,
+ * without changing anything.
  *
- * When KDB_O_NOALL is set the keyset will be only searched from ksCurrent()
- * to ksTail(). You need to ksRewind() the keyset yourself. ksCurrent() is
- * always set properly after searching a key, so you can go on searching
- * another key after the found key.
+ * The owner of a user key name, e.g. in @p user:owner/key,
+ * is ignored.
  *
- * When KDB_O_NOALL is not set the cursor will stay untouched and all keys
- * are considered. A much more efficient binary search will be used then.
- * 
  * @param ks where to look for
  * @param name key name you are looking for
- * @param options some @p KDB_O_* option bits:
- * 	- @p KDB_O_NOCASE @n
- * 		Lookup ignoring case.
- * 	- @p KDB_O_WITHOWNER @n
- * 		Also consider correct owner.
- * 	- @p KDB_O_NOALL @n
- * 		Only search from ksCurrent() to end of keyset, see above text.
- * 	- @p KDB_O_POP @n
- * 		Pop the key which was found.
- *
- * 	Currently no options supported.
+ * @param options see elektraKsLookupConst()
  * @return pointer to the Key found, 0 otherwise
- * @return 0 on NULL pointers
- * @see keyCompare() for very powerful Key lookups in KeySets
- * @see ksCurrent(), ksRewind(), ksNext()
+ * @retval 0 on NULL pointers or unsupported options
+ * @see elektraKsLookupConst(), ksLookupByName()
+ * @ingroup proposal
  */
-Key *ksLookupByName(KeySet *ks, const char *name, option_t options)
+const Key *elektraKsLookupByNameConst(const KeySet *ks, const char *name,
+		option_t options)
 {
-	Key * found=0;
-
 	if (!ks) return 0;
 	if (!name) return 0;
 
 	if (!ks->size) return 0;
 
+	// setting the owner would add meta data, so skip it
+	if (!strncmp(name, "user:", sizeof("user:")-1))
+	{
+		const char *rest = strchr(name, '/');
+		const size_t restSize = rest ? strlen(rest) : 0;
+		char *withoutOwner = elektraMalloc(sizeof("user") + restSize);
+		if (!withoutOwner) return 0;
+		strcpy(withoutOwner, "user");
+		if (rest) strcpy(withoutOwner+sizeof("user")-1, rest);
+
+		const Key *found = elektraKsLookupByNameConst(ks, withoutOwner, options);
+		elektraFree(withoutOwner);
+		return found;
+	}
+
+	size_t buffer[KEY_STACK_ARENA_SIZE / sizeof(size_t)];
+	KeyArena arena;
 	struct _Key key;
 
 	keyInit(&key);
+	elektraArenaInitStack(&arena, buffer, sizeof(buffer));
+	key.arena = &arena;
 	elektraKeySetName(&key, name, KEY_META_NAME|KEY_CASCADING_NAME);
 
-	found = ksLookup(ks, &key, options);
-	free (key.key);
-	ksDel(key.meta); // sometimes owner is set
+	const Key *found = elektraKsLookupConst(ks, &key, options);
+	elektraKeyFreeBuffer(&key, key.key, KEY_FLAG_ARENA_NAME);
+	elektraArenaFreeStack(&arena, buffer);
 	return found;
 }
 
@@ -2082,7 +4802,7 @@ Key *ksLookupByName(KeySet *ks, const char *name, option_t options)
  * @par Example:
  * @code
 ksRewind(ks);
-while (key=ksLookupByString(ks,"my value",0))
+while (key=ksLookupByString(ks,"my value",KDB_O_NOALL))
 {
 	// show all keys which value="my value"
 	keyToStream(key,stdout,0);
@@ -2197,7 +4917,7 @@ Key *ksLookupByBinary(KeySet *ks, const void *value, size_t size,
 		ksSetCursor (ks, init);
 	}
 
-	return 0;
+	return current;
 }
 
 
@@ -2317,6 +5037,24 @@ int ksInit(KeySet *ks)
 	ks->alloc=0;
 	ks->flags=0;
 
+	ks->hashTable=0;
+	ks->hashAlloc=0;
+	ks->hashMisses=0;
+
+	ks->sortKeys=0;
+	ks->sortAlloc=0;
+	ks->sortOffset=0;
+
+	ks->caseIndex=0;
+	ks->caseScans=0;
+	ks->caseOffset=0;
+
+	ks->treeIndex=0;
+
+	ks->unsortedBegin=0;
+
+	ks->arena=0;
+
 	ksRewind(ks);
 
 	return 1;
@@ -2347,6 +5085,12 @@ int ksClose(KeySet *ks)
 	ks->alloc = 0;
 
 	ks->size = 0;
+	clear_bit(ks->flags, KS_FLAG_UNSORTED);
+
+	ksClearIndex(ks);
+	elektraFree (ks->sortKeys);
+	ks->sortKeys = 0;
+	ks->sortAlloc = 0;
 
 	return 0;
 }
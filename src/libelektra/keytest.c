@@ -213,6 +213,21 @@ int keyIsBelow(const Key *key, const Key *check)
 
 	if (!key || !check) return -1;
 
+	if (key->key && check->key && key->keyUSize > 1)
+	{
+		// check has all parts of key, and more
+		if (check->keyUSize <= key->keyUSize) return 0;
+
+		// so the prefixes share the part of key that fits in
+		const size_t length = key->keyUSize - 1;
+		if (length < sizeof(key->namePrefix))
+		{
+			const size_t shift = (sizeof(key->namePrefix) - length) * 8;
+			if ((key->namePrefix ^ check->namePrefix) >> shift) return 0;
+		}
+		else if (key->namePrefix != check->namePrefix) return 0;
+	}
+
 	keyname = keyName(key);
 	checkname = keyName(check);
 	keysize = keyGetNameSize(key);
@@ -238,6 +253,8 @@ int keyIsBelowOrSame (const Key *key, const Key *check)
 	const char *name2 = keyName(check);
 
 	if (keyIsBelow (key, check)) return 1;
+	// different unescaped names can not be the same escaped names
+	if (key->key && check->key && key->nameHash != check->nameHash) return 0;
 	else if (!strcmp (name1, name2)) return 1;
 	return 0;
 }
@@ -526,7 +526,7 @@ ssize_t keySetRaw(Key *key, const void *newBinary, size_t dataSize)
 	if (!dataSize || !newBinary)
 	{
 		if (key->data.v) {
-			free(key->data.v);
+			elektraKeyFreeBuffer(key, key->data.v, KEY_FLAG_ARENA_VALUE);
 			key->data.v=0;
 		}
 		key->dataSize = 0;
@@ -535,18 +535,9 @@ ssize_t keySetRaw(Key *key, const void *newBinary, size_t dataSize)
 		return 1;
 	}
 
+	if (elektraKeyReallocBuffer(key, &key->data.v, dataSize,
+			KEY_FLAG_ARENA_VALUE) == -1) return -1;
 	key->dataSize=dataSize;
-	if (key->data.v)
-	{
-		char *p=0;
-		p=realloc(key->data.v,key->dataSize);
-		if (0==p) return -1;
-		key->data.v=p;
-	} else {
-		char *p=elektraMalloc(key->dataSize);
-		if (0==p) return -1;
-		key->data.v=p;
-	}
 
 
 	memcpy(key->data.v,newBinary,key->dataSize);
@@ -91,9 +91,12 @@ int elektraMountOpen(KDB *kdb, KeySet *config, KeySet *modules, Key *errorKey)
 			{
 				ELEKTRA_ADD_WARNING(24, errorKey, "mounting of backend failed");
 				ret = -1;
-				/* elektraMountBackend modified the refcounter. */
-				backend->refcounter = 1;
-				elektraBackendClose(backend, errorKey);
+				/* The trie closes backends mounted for some namespaces. */
+				if (backend->refcounter == 0)
+				{
+					backend->refcounter = 1;
+					elektraBackendClose(backend, errorKey);
+				}
 				continue;
 			}
 		}
@@ -168,9 +171,14 @@ int elektraMountDefault (KDB *kdb, KeySet *modules, Key *errorKey)
 		if (backend != kdb->defaultBackend)
 		{
 			/* It is not reachable, mount it */
-			elektraMountBackend (kdb, kdb->defaultBackend, errorKey);
+			int mounted = elektraMountBackend (kdb, kdb->defaultBackend, errorKey);
 			/*elektraMountBackend will set refcounter*/
 			++ kdb->defaultBackend->refcounter;
+			if (mounted == -1)
+			{
+				ELEKTRA_ADD_WARNING(43, errorKey, "could not mount default backend");
+				break;
+			}
 			kdb->split->syncbits[kdb->split->size-1] = 2;
 		} else {
 			/* Lets add the reachable default backend to split.
@@ -231,7 +239,12 @@ int elektraMountModules (KDB *kdb, KeySet *modules, Key *errorKey)
 	while ((cur = ksNext (modules)) != 0)
 	{
 		Backend * backend = elektraBackendOpenModules(modules, errorKey);
-		elektraMountBackend(kdb, backend, errorKey);
+		if (elektraMountBackend(kdb, backend, errorKey) == -1)
+		{
+			ELEKTRA_ADD_WARNING(24, errorKey, "mounting of modules backend failed");
+			backend->refcounter = 1;
+			elektraBackendClose(backend, errorKey);
+		}
 	}
 
 	return 0;
@@ -247,11 +260,33 @@ int elektraMountModules (KDB *kdb, KeySet *modules, Key *errorKey)
 int elektraMountVersion (KDB *kdb, Key *errorKey)
 {
 	Backend * backend = elektraBackendOpenVersion(errorKey);
-	elektraMountBackend(kdb, backend, errorKey);
+	if (elektraMountBackend(kdb, backend, errorKey) == -1)
+	{
+		ELEKTRA_ADD_WARNING(24, errorKey, "mounting of version backend failed");
+		backend->refcounter = 1;
+		elektraBackendClose(backend, errorKey);
+	}
 
 	return 0;
 }
 
+/**
+ * @internal
+ *
+ * Inserts backend into the trie of kdb at mountpoint.
+ *
+ * @retval 0 on success
+ * @retval -1 on memory errors, the trie is unchanged then
+ */
+static int elektraMountInsert (KDB *kdb, const char *mountpoint, Backend *backend)
+{
+	Trie *trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+	if (!trie) return -1;
+
+	kdb->trie = trie;
+	return 0;
+}
+
 /**
  * Mounts a backend into the trie.
  *
@@ -264,12 +299,14 @@ int elektraMountVersion (KDB *kdb, Key *errorKey)
  * @param kdb the handle to work with
  * @param backend the backend to mount
  * @param errorKey the key used to report warnings
- * @return -1 on failure
+ * @return -1 on memory errors, the reference counter tells for how
+ *         many namespaces the backend was mounted nevertheless
  * @return 1 on success
  * @ingroup mount
  */
 int elektraMountBackend (KDB *kdb, Backend *backend, Key *errorKey ELEKTRA_UNUSED)
 {
+	int ret = 1;
 
 	char *mountpoint;
 	/* 20 is enough for any of the combinations below. */
@@ -282,9 +319,13 @@ int elektraMountBackend (KDB *kdb, Backend *backend, Key *errorKey ELEKTRA_UNUSE
 	{
 		/* Default backend */
 		sprintf(mountpoint, "system/elektra/");
-		kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
-		elektraSplitAppend(kdb->split, backend, keyNew("system/elektra/", KEY_VALUE, "default", KEY_END), 0);
-		backend->refcounter = 1;
+		backend->refcounter = 0;
+		if (elektraMountInsert(kdb, mountpoint, backend) == -1) ret = -1;
+		else
+		{
+			elektraSplitAppend(kdb->split, backend, keyNew("system/elektra/", KEY_VALUE, "default", KEY_END), 0);
+			backend->refcounter = 1;
+		}
 	}
 	else if (!strcmp (keyName(backend->mountpoint), "/"))
 	{
@@ -296,25 +337,41 @@ int elektraMountBackend (KDB *kdb, Backend *backend, Key *errorKey ELEKTRA_UNUSE
 		{
 		case KEY_NS_SPEC:
 			sprintf(mountpoint, "spec%s", keyName(backend->mountpoint));
-			kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+			if (elektraMountInsert(kdb, mountpoint, backend) == -1)
+			{
+				ret = -1;
+				break;
+			}
 			elektraSplitAppend(kdb->split, backend, keyNew("spec", KEY_VALUE, "root", KEY_END), 2);
 			++backend->refcounter;
 			break;
 		case KEY_NS_DIR:
 			sprintf(mountpoint, "dir%s", keyName(backend->mountpoint));
-			kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+			if (elektraMountInsert(kdb, mountpoint, backend) == -1)
+			{
+				ret = -1;
+				break;
+			}
 			elektraSplitAppend(kdb->split, backend, keyNew("dir", KEY_VALUE, "root", KEY_END), 2);
 			++backend->refcounter;
 			break;
 		case KEY_NS_USER:
 			sprintf(mountpoint, "user%s", keyName(backend->mountpoint));
-			kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+			if (elektraMountInsert(kdb, mountpoint, backend) == -1)
+			{
+				ret = -1;
+				break;
+			}
 			elektraSplitAppend(kdb->split, backend, keyNew("user", KEY_VALUE, "root", KEY_END), 2);
 			++backend->refcounter;
 			break;
 		case KEY_NS_SYSTEM:
 			sprintf(mountpoint, "system%s", keyName(backend->mountpoint));
-			kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+			if (elektraMountInsert(kdb, mountpoint, backend) == -1)
+			{
+				ret = -1;
+				break;
+			}
 			elektraSplitAppend(kdb->split, backend, keyNew("system", KEY_VALUE, "root", KEY_END), 2);
 			++backend->refcounter;
 			break;
@@ -337,21 +394,33 @@ int elektraMountBackend (KDB *kdb, Backend *backend, Key *errorKey ELEKTRA_UNUSE
 		{
 		case KEY_NS_DIR:
 			sprintf(mountpoint, "dir%s/", keyName(backend->mountpoint));
-			kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+			if (elektraMountInsert(kdb, mountpoint, backend) == -1)
+			{
+				ret = -1;
+				break;
+			}
 			elektraSplitAppend(kdb->split, backend,
 				keyNew(mountpoint, KEY_VALUE, keyString(backend->mountpoint), KEY_END), 2);
 			++backend->refcounter;
 			break;
 		case KEY_NS_USER:
 			sprintf(mountpoint, "user%s/", keyName(backend->mountpoint));
-			kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+			if (elektraMountInsert(kdb, mountpoint, backend) == -1)
+			{
+				ret = -1;
+				break;
+			}
 			elektraSplitAppend(kdb->split, backend,
 				keyNew(mountpoint, KEY_VALUE, keyString(backend->mountpoint), KEY_END), 2);
 			++backend->refcounter;
 			break;
 		case KEY_NS_SYSTEM:
 			sprintf(mountpoint, "system%s/", keyName(backend->mountpoint));
-			kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
+			if (elektraMountInsert(kdb, mountpoint, backend) == -1)
+			{
+				ret = -1;
+				break;
+			}
 			elektraSplitAppend(kdb->split, backend,
 				keyNew(mountpoint, KEY_VALUE, keyString(backend->mountpoint), KEY_END), 2);
 			++backend->refcounter;
@@ -370,14 +439,18 @@ int elektraMountBackend (KDB *kdb, Backend *backend, Key *errorKey ELEKTRA_UNUSE
 	} else {
 		/* Common single mounted backend */
 		sprintf(mountpoint, "%s/", keyName(backend->mountpoint));
-		kdb->trie = elektraTrieInsert(kdb->trie, mountpoint, backend);
-		elektraSplitAppend(kdb->split, backend, keyDup (backend->mountpoint), 0);
-		backend->refcounter = 1;
+		backend->refcounter = 0;
+		if (elektraMountInsert(kdb, mountpoint, backend) == -1) ret = -1;
+		else
+		{
+			elektraSplitAppend(kdb->split, backend, keyDup (backend->mountpoint), 0);
+			backend->refcounter = 1;
+		}
 	}
 
 	elektraFree(mountpoint);
 
-	return 1;
+	return ret;
 }
 
 
@@ -0,0 +1,108 @@
+/**
+ * \file
+ *
+ * \brief A small pool of worker threads running independent backends.
+ *
+ * \copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ *
+ */
+
+#ifdef HAVE_KDBCONFIG_H
+#include "kdbconfig.h"
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <kdbprivate.h>
+
+#ifdef HAVE_PTHREAD_H
+
+/**
+ * @internal
+ *
+ * The jobs shared by all workers of one elektraParallelRun().
+ */
+typedef struct
+{
+	void (*run)(void *data, size_t job);
+	void *data;
+	size_t jobs;
+	size_t next;		/**< The next job nobody took yet */
+	pthread_mutex_t mutex;	/**< Protects next */
+} ElektraParallel;
+
+static void *elektraParallelWorker(void *arg)
+{
+	ElektraParallel *parallel = arg;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&parallel->mutex);
+		size_t job = parallel->next;
+		if (job < parallel->jobs) ++ parallel->next;
+		pthread_mutex_unlock(&parallel->mutex);
+
+		if (job >= parallel->jobs) return 0;
+		parallel->run(parallel->data, job);
+	}
+}
+
+#endif
+
+/**
+ * @internal
+ *
+ * @brief Runs @p jobs independent jobs in up to @p workers threads.
+ *
+ * The calling thread is one of the workers. Jobs are handed out in
+ * ascending order, one at a time, so that a slow backend does not
+ * hold back the others. All jobs are finished when the function
+ * returns.
+ *
+ * If threads are not available or cannot be started, the remaining
+ * jobs simply run in the calling thread.
+ *
+ * The jobs must not share keys or meta keys with each other.
+ *
+ * @param workers the maximum number of threads, including the caller
+ * @param jobs the number of jobs
+ * @param run is called once for every job number below @p jobs
+ * @param data passed to @p run
+ */
+void elektraParallelRun(size_t workers, size_t jobs,
+	void (*run)(void *data, size_t job), void *data)
+{
+#ifdef HAVE_PTHREAD_H
+	if (workers > jobs) workers = jobs;
+
+	pthread_t *threads = 0;
+	if (workers > 1) threads = elektraMalloc((workers-1) * sizeof(pthread_t));
+
+	if (threads)
+	{
+		ElektraParallel parallel = {run, data, jobs, 0,
+			PTHREAD_MUTEX_INITIALIZER};
+		size_t started = 0;
+
+		while (started < workers-1 && !pthread_create(&threads[started],
+				0, elektraParallelWorker, &parallel))
+		{
+			++ started;
+		}
+
+		elektraParallelWorker(&parallel);
+
+		for (size_t i=0; i<started; ++i) pthread_join(threads[i], 0);
+
+		pthread_mutex_destroy(&parallel.mutex);
+		elektraFree(threads);
+		return;
+	}
+#else
+	(void) workers;
+#endif
+
+	for (size_t job=0; job<jobs; ++job) run(data, job);
+}
@@ -103,13 +103,26 @@ ssize_t keySetStringF(Key *key, const char *format, ...)
 		return -1;
 	}
 
+	const size_t size = elektraStrLen(p);
+	if (size > KEY_MAX_BUFFER_SIZE)
+	{
+		elektraFree(p);
+		return -1;
+	}
+
 	if (key->data.c)
 	{
-		elektraFree(key->data.c);
+		elektraKeyFreeBuffer(key, key->data.c, KEY_FLAG_ARENA_VALUE);
 	}
 
 	key->data.c = p;
-	key->dataSize = elektraStrLen(key->data.c);
+	key->dataSize = size;
+	if (key->dataSize <= KEY_INLINE_VALUE_SIZE)
+	{
+		key->data.c = elektraKeyMallocBuffer(key, key->dataSize, KEY_FLAG_ARENA_VALUE);
+		memcpy(key->data.c, p, key->dataSize);
+		elektraFree(p);
+	}
 	set_bit(key->flags, KEY_FLAG_SYNC);
 
 	return key->dataSize;
@@ -389,26 +402,105 @@ int keyLock(Key *key, /*option_t*/ enum elektraLockOptions what)
 /**
  * @internal
  *
- * Returns true (1) for all keys that are part of the array
- * identified by the supplied array parent. Only the array
- * eleements themself, but no subkeys of them will be filtered
+ * Compares the rest of the unescaped name of key after the unescaped
+ * name of arrayParent with the first size bytes of rest.
  *
- * @pre The supplied argument has to be of type (const Key *)
- * and is the parent of the array to be extracted. For example
- * if the keys of the array comment/# are to be extracted, a key
- * with the name "comment" has to be supplied
+ * @pre key is below or the same as arrayParent
+ */
+static int elektraArrayCompareRest(const Key *arrayParent, const Key *key,
+		const char *rest, size_t size)
+{
+	const char *name = key->key + key->keySize + arrayParent->keyUSize;
+	const size_t nameSize = key->keyUSize - arrayParent->keyUSize;
+	const int ret = memcmp(name, rest, nameSize < size ? nameSize : size);
+
+	if (ret) return ret;
+	return nameSize < size ? -1 : 0;
+}
+
+/**
+ * @internal
  *
- * @param key the key to be checked against the array
- * @param argument the array parent
- * @return 1 if the key is part of the array identified by the
- * array parent, 0 otherwise
+ * Binary search for the first position from left to (excluding)
+ * right, where the rest of the name after arrayParent is not less
+ * than rest.
+ */
+static size_t elektraArrayBound(const KeySet *ks, const Key *arrayParent,
+		size_t left, size_t right, const char *rest)
+{
+	const size_t size = strlen(rest);
+
+	while (left < right)
+	{
+		const size_t middle = left + (right-left)/2;
+		if (elektraArrayCompareRest(arrayParent, ks->array[middle],
+				rest, size) < 0) left = middle+1;
+		else right = middle;
+	}
+
+	return left;
+}
+
+/**
+ * @internal
  *
+ * @pre key is within the range of elektraArrayGetRange()
+ * @retval 1 if key is an element of the array identified by the
+ * supplied array parent, not a subkey of one
+ * @retval 0 otherwise
+ */
+static int elektraArrayIsElement(const Key *arrayParent, const Key *key)
+{
+	const char *rest = key->key + key->keySize + arrayParent->keyUSize;
+	const size_t size = key->keyUSize - arrayParent->keyUSize;
+
+	if (memchr(rest, 0, size) != rest + size - 1) return 0;
+	return elektraArrayValidateName(key) == 1;
+}
+
+/**
+ * Finds the elements of an array without copying them.
+ *
+ * For example, if user/config/# is an array, user/config is the
+ * array parent. The elements user/config/\#0 to the last one are
+ * next to each other in the sorted keyset, together with their
+ * subkeys like user/config/\#0/key. They are the keys from position
+ * @p begin to (excluding) @p end, which can be accessed with
+ * ksAtCursor(). They are found with binary searches, so the keyset
+ * is never iterated as a whole.
+ *
+ * Names like user/config/\#_5, which are no valid array names, are
+ * sorted within the range too, so elektraArrayValidateName() should
+ * be checked for keys which are used as elements.
+ *
+ * Like for elektraKsBelow() the positions are only valid until
+ * @p keys is changed the next time.
+ *
+ * @param keys the keyset containing the array keys, it will be sorted
+ *        if necessary
+ * @param arrayParent the parent of the array
+ * @param begin will be set to the position of the first element
+ * @param end will be set to the position after the last element
+ *        or its last subkey
+ * @return the number of keys found, @p end - @p begin
+ * @retval -1 on NULL pointers or if @p arrayParent has no name, or
+ *         its name is "/"
+ * @see elektraArrayGet() to get a keyset of the elements
  */
-static int arrayFilter(const Key *key, void *argument)
+ssize_t elektraArrayGetRange(KeySet *keys, const Key *arrayParent,
+		cursor_t *begin, cursor_t *end)
 {
-	const Key *arrayParent = (const Key *) argument;
+	if (!begin || !end) return -1;
+
+	cursor_t first = 0;
+	cursor_t last = 0;
+	if (elektraKsBelow(keys, arrayParent, &first, &last) == -1) return -1;
+
+	/* # is followed by digits or underscores, _ is sorted before ` */
+	*begin = elektraArrayBound(keys, arrayParent, first, last, "#0");
+	*end = elektraArrayBound(keys, arrayParent, *begin, last, "#`");
 
-	return keyIsDirectBelow(arrayParent, key) && elektraArrayValidateName(key);
+	return *end - *begin;
 }
 
 
@@ -429,6 +521,7 @@ static int arrayFilter(const Key *key, void *argument)
  *
  * @return a keyset containing the arraykeys (if any)
  * @retval NULL on NULL pointers
+ * @see elektraArrayGetRange() to access the keys without a new keyset
  */
 KeySet *elektraArrayGet(const Key *arrayParent, KeySet *keys)
 {
@@ -436,11 +529,127 @@ KeySet *elektraArrayGet(const Key *arrayParent, KeySet *keys)
 
 	if (!keys) return 0;
 
-	KeySet *arrayKeys = ksNew(ksGetSize(keys), KS_END);
-	elektraKsFilter(arrayKeys, keys, &arrayFilter, (void *)arrayParent);
+	cursor_t begin = 0;
+	cursor_t end = 0;
+	ssize_t size = elektraArrayGetRange(keys, arrayParent, &begin, &end);
+
+	KeySet *arrayKeys = ksNew(size > 0 ? size : 0, KS_END);
+	for (cursor_t it = begin; it < end; ++it)
+	{
+		Key *current = keys->array[it];
+		if (elektraArrayIsElement(arrayParent, current))
+		{
+			ksAppendKey(arrayKeys, current);
+		}
+	}
 	return arrayKeys;
 }
 
+/**
+ * @return the largest array index whose name fits into
+ * ELEKTRA_MAX_ARRAY_SIZE: a #, one underscore less than
+ * there are digits, the digits and the null byte.
+ */
+static kdb_long_long_t elektraArrayMaxIndex(void)
+{
+	kdb_long_long_t limit = 1;
+	for (int i = 0; i < (ELEKTRA_MAX_ARRAY_SIZE - 1) / 2; ++i)
+	{
+		limit *= 10;
+	}
+	return limit - 1;
+}
+
+/**
+ * Append a new element to an array.
+ *
+ * The index of the new element is remembered in @p nextIndex, so
+ * appending many elements does not need to look at the keyset
+ * or parse names again. When @p nextIndex is negative, the index
+ * is found once after the last element of the array in @p keys,
+ * or it is 0 for an empty array.
+ *
+ * @code
+ssize_t next = -1;
+Key *element;
+while (...)
+{
+	element = elektraArrayAppend(ks, arrayParent, &next);
+	keySetString(element, "value");
+}
+ * @endcode
+ *
+ * The new key has no value and is owned by @p keys.
+ *
+ * @param keys the keyset the element will be appended to
+ * @param arrayParent the parent of the array, only its name is used
+ * @param nextIndex the index of the new element or -1, will be
+ *        incremented
+ *
+ * @return the new array key on success
+ * @retval NULL on NULL pointers or if an error occurs (e.g. too
+ *         large array, invalid array parent)
+ * @see elektraArrayIncName() to increment the name of a key
+ */
+Key *elektraArrayAppend(KeySet *keys, const Key *arrayParent,
+		ssize_t *nextIndex)
+{
+	if (!keys || !arrayParent || !nextIndex) return 0;
+
+	if (*nextIndex < 0)
+	{
+		cursor_t begin = 0;
+		cursor_t end = 0;
+		if (elektraArrayGetRange(keys, arrayParent, &begin, &end) == -1)
+		{
+			return 0;
+		}
+
+		/* skip subkeys and invalid names after the last element */
+		kdb_long_long_t lastIndex = -1;
+		while (end-- > begin)
+		{
+			const Key *last = keys->array[end];
+			if (!elektraArrayIsElement(arrayParent, last)) continue;
+
+			const char *baseName = keyBaseName(last) + 1; // jump over #
+			while (*baseName == '_') ++baseName;
+			if (elektraReadArrayNumber(baseName, &lastIndex) == 0) break;
+			lastIndex = -1;
+		}
+		*nextIndex = lastIndex + 1;
+	}
+
+	if ((kdb_long_long_t)*nextIndex > elektraArrayMaxIndex()) return 0;
+
+	char newName[ELEKTRA_MAX_ARRAY_SIZE];
+	if (elektraWriteArrayNumber(newName, *nextIndex) == -1) return 0;
+
+	Key *element = elektraKsNewKey(keys, 0);
+	if (!element) return 0;
+	if (elektraKeySetName(element, keyName(arrayParent),
+			KEY_META_NAME | KEY_CASCADING_NAME) == -1 ||
+		keyAddBaseName(element, newName) == -1)
+	{
+		keyDel(element);
+		return 0;
+	}
+
+	/* hold a reference so that element survives a failed append
+	 * and is deleted here exactly once */
+	keyIncRef(element);
+	if (ksAppendKey(keys, element) == -1)
+	{
+		keyDecRef(element);
+		keyDel(element);
+		return 0;
+	}
+	keyDecRef(element);
+	++*nextIndex;
+
+	return element;
+}
+
 /**
  *
  * Return the next key in the given array.
@@ -547,12 +756,22 @@ Key *ksPopAtCursor(KeySet *ks, cursor_t pos)
 	if (!ks) return 0;
 	if (pos<0) return 0;
 	if (pos>SSIZE_MAX) return 0;
+	if (test_bit(ks->flags, KS_FLAG_FROZEN)) return 0;
 
 	size_t c = pos;
 	if (c>=ks->size) return 0;
 
 	if (c != ks->size-1)
 	{
+		// ksPop() keeps the namespace ranges up to date
+		ksClearHashIndex(ks);
+		clear_bit(ks->flags, KS_FLAG_SORTKEYS);
+		if (test_bit(ks->flags, KS_FLAG_UNSORTED) &&
+			c < ks->unsortedBegin)
+		{
+			-- ks->unsortedBegin;
+		}
+
 		Key ** found = ks->array+c;
 		Key * k = *found;
 		/* Move the array over the place where key was found
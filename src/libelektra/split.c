@@ -371,6 +371,61 @@ int elektraSplitBuildup (Split *split, KDB *kdb, Key *parentKey)
 
 
 
+/**
+ * @internal
+ *
+ * Marks the positions in ks where the backend of the keys might
+ * change: where the keys below a mountpoint or a namespace begin
+ * or end.
+ *
+ * Every backend in the trie is also appended to handle->split with
+ * its mountpoint as parent, see elektraMountBackend(). So all keys
+ * between two marks belong to the same backend and only the first
+ * of them needs to be looked up. The marks are found with binary
+ * searches, so this is independent of the number of keys below
+ * the mountpoints.
+ *
+ * @param handle to get the mountpoints from
+ * @param ks the keyset to mark, it will be sorted if necessary
+ *
+ * @return the marks, one for every position in ks and its end
+ * @retval 0 on memory errors
+ */
+static char *elektraSplitMarkRanges (KDB *handle, KeySet *ks)
+{
+	static const char *namespaces[] = {"spec", "proc", "dir", "user", "system", 0};
+	cursor_t begin = 0;
+	cursor_t end = 0;
+
+	if (test_bit(ks->flags, KS_FLAG_UNSORTED)) elektraKsSort(ks);
+
+	char *marks = elektraCalloc (ks->size+1);
+	if (!marks) return 0;
+
+	for (size_t i=0; handle->split && i<handle->split->size; ++i)
+	{
+		if (elektraKsBelow(ks, handle->split->parents[i], &begin, &end) <= 0)
+		{
+			continue;
+		}
+		marks[begin] = 1;
+		marks[end] = 1;
+	}
+
+	Key *key = keyNew (0, KEY_END);
+	for (const char **ns = namespaces; *ns; ++ns)
+	{
+		keySetName(key, *ns);
+		if (elektraKsBelow(ks, key, &begin, &end) <= 0) continue;
+		marks[begin] = 1;
+		marks[end] = 1;
+	}
+	keyDel (key);
+
+	return marks;
+}
+
+
 /**
  * Splits up the keysets and search for a sync bit in every key.
  *
@@ -397,26 +452,43 @@ int elektraSplitDivide (Split *split, KDB *handle, KeySet *ks)
 	int needsSync = 0;
 	Key *curKey = 0;
 	Backend *curHandle = 0;
+	size_t end = 0;
 
 	ksRewind (ks);
-	while ((curKey = ksNext (ks)) != 0)
+	char *marks = elektraSplitMarkRanges (handle, ks);
+	if (!marks) return -1;
+
+	for (size_t begin=0; begin<ks->size; begin=end)
 	{
+		for (end=begin+1; end<ks->size && !marks[end]; ++end);
+
+		/* All keys from begin to end belong to the same backend */
+		curKey = ks->array[begin];
 		// TODO: handle keys in wrong namespaces
 		curHandle = elektraMountGetBackend(handle, curKey);
-		if (!curHandle) return -1;
+		if (!curHandle)
+		{
+			elektraFree (marks);
+			return -1;
+		}
 
 		curFound = elektraSplitSearchBackend(split, curHandle, curKey);
 
-		if (curFound == -1) continue; // key not relevant in this kdbSet
+		if (curFound == -1) continue; // keys not relevant in this kdbSet
 
-		ksAppendKey (split->keysets[curFound], curKey);
-		if (keyNeedSync(curKey) == 1)
+		elektraKsAppendRange (split->keysets[curFound], ks, begin, end);
+		for (size_t i=begin; i<end; ++i)
 		{
-			split->syncbits[curFound] |= 1;
-			needsSync = 1;
+			if (keyNeedSync(ks->array[i]) == 1)
+			{
+				split->syncbits[curFound] |= 1;
+				needsSync = 1;
+				break;
+			}
 		}
 	}
 
+	elektraFree (marks);
 	return needsSync;
 }
 
@@ -461,12 +533,24 @@ int elektraSplitAppoint (Split *split, KDB *handle, KeySet *ks)
 	Key *curKey = 0;
 	Backend *curHandle = 0;
 	ssize_t defFound = elektraSplitAppend (split, 0, 0, 0);
+	size_t end = 0;
 
 	ksRewind (ks);
-	while ((curKey = ksNext (ks)) != 0)
+	char *marks = elektraSplitMarkRanges (handle, ks);
+	if (!marks) return -1;
+
+	for (size_t begin=0; begin<ks->size; begin=end)
 	{
+		for (end=begin+1; end<ks->size && !marks[end]; ++end);
+
+		/* All keys from begin to end belong to the same backend */
+		curKey = ks->array[begin];
 		curHandle = elektraMountGetBackend(handle, curKey);
-		if (!curHandle) return -1;
+		if (!curHandle)
+		{
+			elektraFree (marks);
+			return -1;
+		}
 
 		curFound = elektraSplitSearchBackend(split, curHandle, curKey);
 
@@ -477,9 +561,10 @@ int elektraSplitAppoint (Split *split, KDB *handle, KeySet *ks)
 			continue;
 		}
 
-		ksAppendKey (split->keysets[curFound], curKey);
+		elektraKsAppendRange (split->keysets[curFound], ks, begin, end);
 	}
 
+	elektraFree (marks);
 	return 1;
 }
 
@@ -712,6 +797,7 @@ int elektraSplitUpdateSize (Split *split)
  * @param split the split object to work with
  * @param dest the destination keyset where all keysets are appended.
  * @return 1 on success
+ * @retval -1 if a keyset could not be appended (e.g. dest is frozen)
  * @ingroup split
  */
 int elektraSplitMerge (Split *split, KeySet *dest)
@@ -719,7 +805,71 @@ int elektraSplitMerge (Split *split, KeySet *dest)
 	/* Iterate everything */
 	for (size_t i=0; i<split->size; ++i)
 	{
-		ksAppend (dest, split->keysets[i]);
+		if (ksAppend (dest, split->keysets[i]) == -1) return -1;
+	}
+	return 1;
+}
+
+/**
+ * Merges the keysets of the updated backends into dest.
+ *
+ * Unlike ksClear() followed by elektraSplitMerge(), only the keys
+ * of the backends marked with SPLIT_FLAG_SYNC are replaced. The keys
+ * of all other backends stay where they are in dest instead of being
+ * removed and merged in again. dest is still walked, so the work
+ * is linear in the size of dest.
+ *
+ * The keys of the updated backends are found by the same ranges
+ * elektraSplitAppoint() uses.
+ *
+ * @pre elektraSplitAppoint() was executed with dest, which was not
+ *      changed since then.
+ *
+ * @param split the split object to work with
+ * @param handle to get information where the individual keys belong
+ * @param dest the keyset to update
+ * @return 1 on success
+ * @retval -1 if no backend was found for any key, if dest is frozen
+ *         or on memory errors, the keys of the updated backends might
+ *         be missing then
+ * @ingroup split
+ */
+int elektraSplitMergeUpdated (Split *split, KDB *handle, KeySet *dest)
+{
+	size_t end = 0;
+
+	char *marks = elektraSplitMarkRanges (handle, dest);
+	if (!marks) return -1;
+
+	for (size_t begin=0; begin<dest->size; begin=end)
+	{
+		for (end=begin+1; end<dest->size && !marks[end]; ++end);
+
+		/* All keys from begin to end belong to the same backend */
+		Key *curKey = dest->array[begin];
+		Backend *curHandle = elektraMountGetBackend(handle, curKey);
+		if (!curHandle)
+		{
+			elektraFree (marks);
+			return -1;
+		}
+
+		ssize_t curFound = elektraSplitSearchBackend(split, curHandle, curKey);
+		const char remove = curFound != -1 &&
+			test_bit(split->syncbits[curFound], SPLIT_FLAG_SYNC);
+
+		/* From now on marks tells which keys to remove */
+		memset (marks+begin, remove, end-begin);
+	}
+
+	ssize_t removed = elektraKsRemoveMarked (dest, marks);
+	elektraFree (marks);
+	if (removed == -1) return -1;
+
+	for (size_t i=0; i<split->size; ++i)
+	{
+		if (!test_bit(split->syncbits[i], SPLIT_FLAG_SYNC)) continue;
+		if (ksAppend (dest, split->keysets[i]) == -1) return -1;
 	}
 	return 1;
 }
@@ -39,8 +39,9 @@
 
 #include "kdbinternal.h"
 
-static char* elektraTrieStartsWith(const char *str, const char *substr);
-static Backend* elektraTriePrefixLookup(Trie *trie, const char *name);
+static Trie* elektraTrieNew(const char *text, size_t textlen);
+static int elektraTrieFindChild(const Trie *trie, unsigned char first, size_t *pos);
+static int elektraTrieAddChild(Trie *trie, size_t pos, Trie *child);
 
 /**
  * @brief Internal Datastructure for mountpoints
@@ -51,6 +52,9 @@ static Backend* elektraTriePrefixLookup(Trie *trie, const char *name);
 /**
  * Lookups a backend inside the trie.
  *
+ * The name of the key is looked up as if a / was appended,
+ * directly on keyName() without copying it.
+ *
  * @return the backend if found
  * @return 0 otherwise
  * @param trie the trie object to work with
@@ -59,21 +63,37 @@ static Backend* elektraTriePrefixLookup(Trie *trie, const char *name);
  */
 Backend* elektraTrieLookup(Trie *trie, const Key *key)
 {
-	char *where=0;
-	Backend *ret=0;
-	size_t len=0;
-
 	if (!key) return 0;
 	if (!trie) return 0;
 
-	len = keyGetNameSize(key) + 1;
-	if (len == 1) return 0; // would crash otherwise
-	where = elektraMalloc(len);
-	strncpy(where, keyName(key), len);
-	where[len-2] = '/';
+	const char *name = keyName(key);
+	/* size of the name with the appended / instead of the null */
+	const size_t len = keyGetNameSize(key);
+	if (len == 0) return 0;
+
+	Backend *ret = trie->value;
+	size_t pos = 0;
+
+	while (pos < len)
+	{
+		const unsigned char first = pos < len-1 ? name[pos] : '/';
+		const unsigned char *found = memchr(trie->firsts, first, trie->size);
+		if (!found) break;
+
+		trie = trie->children[found - trie->firsts];
+		const size_t textlen = trie->textlen;
+		if (pos + textlen > len) break;
+		if (pos + textlen == len)
+		{
+			/* the text ends with the appended / */
+			if (memcmp(name+pos, trie->text, textlen-1)) break;
+			if (trie->text[textlen-1] != '/') break;
+		}
+		else if (memcmp(name+pos, trie->text, textlen)) break;
 
-	ret = elektraTriePrefixLookup(trie,where);
-	elektraFree(where);
+		pos += textlen;
+		if (trie->value) ret = trie->value;
+	}
 
 	return ret;
 }
@@ -90,184 +110,201 @@ int elektraTrieClose (Trie *trie, Key *errorKey)
 {
 	size_t i;
 	if (trie==NULL) return 0;
-	for (i=0; i<KDB_MAX_UCHAR; ++i)
+	for (i=0; i<trie->size; ++i)
 	{
-		if (trie->text[i]!=NULL)
-		{
-			elektraTrieClose(trie->children[i], errorKey);
-			if (trie->value[i])
-				elektraBackendClose(trie->value[i], errorKey);
-			free(trie->text[i]);
-		}
+		elektraTrieClose(trie->children[i], errorKey);
 	}
-	if (trie->empty_value)
+	for (i=0; i<trie->nrShadowed; ++i)
 	{
-		elektraBackendClose(trie->empty_value, errorKey);
+		elektraBackendClose(trie->shadowed[i], errorKey);
 	}
-	free(trie);
+	if (trie->value)
+	{
+		elektraBackendClose(trie->value, errorKey);
+	}
+	elektraFree(trie->shadowed);
+	elektraFree(trie->children);
+	elektraFree(trie);
 	return 0;
 }
+
+/**
+ * Inserts a backend into the trie.
+ *
+ * If a backend was already inserted with the same name, the new one
+ * will be found by elektraTrieLookup(), but both will be closed by
+ * elektraTrieClose().
+ *
+ * On memory errors the backend is not inserted and the trie passed
+ * stays valid and still belongs to the caller.
+ *
+ * @param trie the trie to insert into, or 0 for a new trie
+ * @param name the mountpoint, usually with a / at the end
+ * @param value the backend to insert
+ * @return the trie
+ * @retval 0 on memory errors
+ * @ingroup trie
+ */
 Trie* elektraTrieInsert(Trie *trie, const char *name, Backend *value)
 {
-	char* p;
-	unsigned char idx;
+	size_t pos;
 
 	if (name==0) name="";
-	idx=(unsigned char)name[0];
 
 	if (trie==NULL)
 	{
-		trie=elektraCalloc(sizeof(Trie));
-
-		if (!strcmp("",name))
+		Trie *created = elektraTrieNew("", 0);
+		if (!created) return 0;
+		if (!elektraTrieInsert(created, name, value))
 		{
-			trie->empty_value=value;
-			return trie;
+			elektraTrieClose(created, 0);
+			return 0;
 		}
-
-		trie->textlen[idx]=strlen(name);
-
-		trie->text[idx]=elektraStrDup(name);
-
-		trie->value[idx]=value;
-		return trie;
+		return created;
 	}
 
 	if (!strcmp("",name))
 	{
-		trie->empty_value=value;
+		if (trie->value)
+		{
+			/* keep the shadowed backend to close it later */
+			if (elektraRealloc((void**)&trie->shadowed,
+				(trie->nrShadowed+1) * sizeof(Backend*)) == -1)
+			{
+				return 0;
+			}
+			trie->shadowed[trie->nrShadowed++] = trie->value;
+		}
+		trie->value=value;
 		return trie;
 	}
 
-	if (trie->text[idx]) {
-		/* there exists an entry with the same first character */
-		if ((p=elektraTrieStartsWith(name, trie->text[idx]))==0)
+	if (!elektraTrieFindChild(trie, (unsigned char)name[0], &pos))
+	{
+		/* there doesn't exist an entry with the same first character */
+		Trie *child = elektraTrieNew(name, strlen(name));
+		if (!child) return 0;
+		if (elektraTrieAddChild(trie, pos, child) == -1)
 		{
-			/* the name in the trie is part of the searched name --> continue search */
-			trie->children[idx]=elektraTrieInsert(trie->children[idx],name+trie->textlen[idx],value);
-		} else {
-			/* name in trie doesn't match name --> split trie */
-			char *newname;
-			Trie *child;
-			unsigned char idx2;
-
-			newname=elektraStrDup(p);
-			*p=0; /* shorten the old name in the trie */
-			trie->textlen[idx]=strlen(trie->text[idx]);
-
-			child=trie->children[idx];
+			elektraTrieClose(child, 0);
+			return 0;
+		}
+		child->value = value;
+		return trie;
+	}
 
-			/* insert the name given as a parameter into the new trie entry */
-			trie->children[idx]=elektraTrieInsert(NULL, name+(p-trie->text[idx]), value);
+	/* there exists an entry with the same first character */
+	Trie *child = trie->children[pos];
+	size_t common = 1;
+	while (common < child->textlen && name[common] == child->text[common])
+	{
+		++common;
+	}
 
-			/* insert the split try into the new trie entry */
+	if (common < child->textlen)
+	{
+		/* name in trie doesn't match name --> split trie */
+		Trie *split = elektraTrieNew(child->text, common);
+		if (!split) return 0;
 
-			idx2 = (unsigned char) newname[0];
-			trie->children[idx]->text[idx2]=newname;
-			trie->children[idx]->textlen[idx2]=strlen(newname);
-			trie->children[idx]->value[idx2]=trie->value[idx];
-			trie->children[idx]->children[idx2]=child;
+		if (elektraTrieAddChild(split, 0, child) == -1)
+		{
+			elektraTrieClose(split, 0);
+			return 0;
+		}
 
-			trie->value[idx]=0;
+		/* nothing can fail anymore, shorten the old name in the trie */
+		child->textlen -= common;
+		memmove(child->text, child->text+common, child->textlen+1);
+		split->firsts[0] = (unsigned char)child->text[0];
 
-		}
-	} else {
-		/* there doesn't exist an entry with the same first character */
-		trie->text[idx]=elektraStrDup(name);
-		trie->value[idx]=(void*)value;
-		trie->textlen[idx]=strlen(name);
+		trie->children[pos] = split;
+		trie->firsts[pos] = (unsigned char)split->text[0];
+		child = split;
 	}
 
+	/* the name in the trie is part of the searched name --> continue */
+	if (!elektraTrieInsert(child, name+common, value)) return 0;
+
 	return trie;
 }
 
+/**
+ * @}
+ */
+
 
 
 /******************
  * Private static declarations
  ******************/
 
-
-#if 0
-
-static Trie *delete_trie(Trie *trie, char *name, CloseMapper closemapper)
+/**
+ * Allocates a node with a copy of the first textlen characters of text,
+ * which is stored right after the node.
+ */
+static Trie* elektraTrieNew(const char *text, size_t textlen)
 {
-	Trie *tr;
-	unsigned char idx;
-	if (trie==NULL) {
-		return NULL;
-	}
-
-	idx=(unsigned char) name[0];
-
-	if (trie->text[idx]==NULL) {
-		return NULL;
-	}
-
-	if (elektraTrieStartsWith(name,trie->text[idx])==0) {
-
-		tr=delete_trie(trie->children[idx],name+trie->textlen[idx],closemapper);
+	Trie *trie = elektraCalloc(sizeof(Trie) + textlen + 1);
+	if (!trie) return 0;
 
-		if (tr==NULL) {
-			/* child trie has been deleted */
-			trie->children[idx]=NULL;
-			free(trie->text[idx]);
-			closemapper(trie->value[idx]);
-			trie->text[idx]=NULL;
-		}
+	trie->text = (char*)(trie+1);
+	memcpy(trie->text, text, textlen);
+	trie->text[textlen] = 0;
+	trie->textlen = textlen;
 
-		return trie;
-	}
-	return NULL;
+	return trie;
 }
 
-#endif
-
 /**
- * return NULL if string starts with substring, except for the terminating '\0',
- * otherwise return a pointer to the first mismatch in substr.
+ * Inserts child at pos into the children of trie.
  *
- * Takes const char* arguments but return char* pointer to it.
- * (like e.g. strchr)
+ * @retval 0 on success
+ * @retval -1 on memory errors
  */
-static char* elektraTrieStartsWith(const char *str, const char *substr)
+static int elektraTrieAddChild(Trie *trie, size_t pos, Trie *child)
 {
-	size_t i = 0;
-	size_t sublen = strlen(substr);
+	const size_t size = trie->size+1;
+	Trie **children = elektraMalloc(size * (sizeof(Trie*) + 1));
+	if (!children) return -1;
+	unsigned char *firsts = (unsigned char*)(children + size);
 
-	for (i=0;i<sublen;i++)
-	{
-		if (substr[i]!=str[i])
-			return (char*)substr+i;
-	}
-	return 0;
-}
+	memcpy(children, trie->children, pos * sizeof(Trie*));
+	memcpy(children+pos+1, trie->children+pos, (trie->size-pos) * sizeof(Trie*));
+	children[pos] = child;
 
-static Backend* elektraTriePrefixLookup(Trie *trie, const char *name)
-{
-	unsigned char idx;
-	void * ret=NULL;
-	if (trie==NULL) return NULL;
+	memcpy(firsts, trie->firsts, pos);
+	memcpy(firsts+pos+1, trie->firsts+pos, trie->size-pos);
+	firsts[pos] = (unsigned char)child->text[0];
 
-	idx=(unsigned char) name[0];
+	elektraFree(trie->children);
+	trie->children = children;
+	trie->firsts = firsts;
+	trie->size = size;
 
-	if (trie->text[idx]==NULL)
-	{
-		return trie->empty_value;
-	}
+	return 0;
+}
 
-	if (elektraTrieStartsWith((char*)name, (char*)trie->text[idx])==0)
-	{
-		ret=elektraTriePrefixLookup(trie->children[idx],name+trie->textlen[idx]);
-	} else {
-		return trie->empty_value;
-	}
+/**
+ * Binary search for the child whose text starts with first.
+ *
+ * @param pos will be set to the position of the child, or where it
+ *        would need to be inserted
+ * @retval 1 if the child was found
+ * @retval 0 otherwise
+ */
+static int elektraTrieFindChild(const Trie *trie, unsigned char first, size_t *pos)
+{
+	size_t left = 0;
+	size_t right = trie->size;
 
-	if (ret==NULL && trie->value[idx]==NULL)
+	while (left < right)
 	{
-		return trie->empty_value;
+		const size_t middle = left + (right-left)/2;
+		if (trie->firsts[middle] < first) left = middle+1;
+		else right = middle;
 	}
-	if (ret==NULL) return trie->value[idx];
 
-	return ret;
+	*pos = left;
+	return left < trie->size && trie->firsts[left] == first;
 }
@@ -103,10 +103,10 @@ if (WHICH > length) \
 	return -1; \
 }
 
-int unserialise(std::istream &is, ckdb::Key *errorKey, ckdb::KeySet *ks)
+/* Appends unsorted, cur is the key read but not yet appended */
+static int unserialiseKeys(std::istream &is, ckdb::Key *errorKey,
+		ckdb::KeySet *ks, ckdb::Key *&cur)
 {
-	ckdb::Key *cur = 0;
-
 	is.seekg(0, std::ios::end);
 	size_t length = is.tellg();
 	is.seekg(0, std::ios::beg);
@@ -142,7 +142,7 @@ int unserialise(std::istream &is, ckdb::Key *errorKey, ckdb::KeySet *ks)
 		}
 		else if (command == "keyNew")
 		{
-			cur = ckdb::keyNew(0);
+			cur = ckdb::elektraKsNewKey(ks, 0);
 
 			ss >> namesize;
 			ss >> valuesize;
@@ -190,7 +190,7 @@ int unserialise(std::istream &is, ckdb::Key *errorKey, ckdb::KeySet *ks)
 		}
 		else if (command == "keyEnd")
 		{
-			ckdb::ksAppendKey(ks, cur);
+			ckdb::elektraKsAppendUnsorted(ks, cur);
 			cur = 0;
 		}
 		else if (command == "ksEnd")
@@ -204,6 +204,16 @@ int unserialise(std::istream &is, ckdb::Key *errorKey, ckdb::KeySet *ks)
 	return 1;
 }
 
+int unserialise(std::istream &is, ckdb::Key *errorKey, ckdb::KeySet *ks)
+{
+	ckdb::Key *cur = 0;
+
+	int ret = unserialiseKeys(is, errorKey, ks, cur);
+	ckdb::keyDel(cur);
+	ckdb::elektraKsSort(ks);
+	return ret;
+}
+
 } // namespace dump
 
 
@@ -27,6 +27,7 @@
 
 
 #include <kdbplugin.h>
+#include <kdbproposal.h>
 
 #include <iostream>
 #include <fstream>
@@ -159,14 +159,15 @@ static char *parseCanonicalName(Key *result, char *line)
 	return tokenPointer;
 }
 
-static char *parseAlias(KeySet *append, const Key *hostParent, char *tokenPointer)
+static char *parseAlias(KeySet *returned, KeySet *append, const Key *hostParent, char *tokenPointer)
 {
 	char *fieldBuffer;
 	int sret = 0;
 	sret = elektraParseToken (&fieldBuffer, tokenPointer);
 	if (sret == 0) return 0;
 
-	Key *alias = keyDup (hostParent);
+	Key *alias = elektraKsNewKey (returned, 0);
+	keyCopy (alias, hostParent);
 	keyAddBaseName (alias, fieldBuffer);
 	elektraFree(fieldBuffer);
 
@@ -177,7 +178,7 @@ static char *parseAlias(KeySet *append, const Key *hostParent, char *tokenPointe
 	}
 	else
 	{
-		ksAppendKey(append, alias);
+		elektraKsAppendUnsorted(append, alias);
 	}
 
 	return tokenPointer + sret;
@@ -227,7 +228,8 @@ int elektraHostsGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parent
 	ksClear (returned);
 	KeySet *append = ksNew(ksGetSize(returned)*2, KS_END);
 
-	Key *key = keyDup (parentKey);
+	Key *key = elektraKsNewKey (returned, 0);
+	keyCopy (key, parentKey);
 	ksAppendKey(append, key);
 
 	Key *currentKey = 0;
@@ -243,7 +245,8 @@ int elektraHostsGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parent
 
 		if (!currentKey)
 		{
-			currentKey = keyDup(parentKey);
+			currentKey = elektraKsNewKey (returned, 0);
+			keyCopy (currentKey, parentKey);
 		}
 
 		if (parseComment(comments, readBuffer, "#", &elektraAddLineComment)) continue;
@@ -267,7 +270,7 @@ int elektraHostsGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parent
 		setOrderMeta(currentKey, order);
 		++ order;
 
-		ksAppendKey(append, currentKey);
+		elektraKsAppendUnsorted(append, currentKey);
 
 		/* Read in aliases */
 		while (1)
@@ -276,7 +279,7 @@ int elektraHostsGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parent
 			if (parseComment(comments, tokenPointer, "#", &elektraAddInlineComment)) break;
 
 			/* if we reach the end of the line, there cannot be any more aliases */
-			tokenPointer = parseAlias (append, currentKey, tokenPointer);
+			tokenPointer = parseAlias (returned, append, currentKey, tokenPointer);
 			if (tokenPointer == 0) break;
 		}
 
@@ -300,6 +303,7 @@ int elektraHostsGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parent
 	if (!ferror (fp))
 	{
 		ksClear (returned);
+		elektraKsSort (append);
 		ksAppend (returned, append);
 		ksDel (append);
 		ret = 1;
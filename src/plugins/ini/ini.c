@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <kdberrors.h>
+#include <kdbproposal.h>
 #include <inih.h>
 #include "ini.h"
 
@@ -26,6 +27,7 @@ int elektraIniClose(Plugin *handle, Key *parentKey);
 typedef struct {
 	const Key *parentKey;	/* the parent key of the result KeySet */
 	KeySet *result;			/* the result KeySet */
+	KeySet *returned;		/* the KeySet whose arena new keys are allocated from */
 	char *collectedComment;	/* buffer for collecting comments until a non comment key is reached */
 } CallbackHandle;
 
@@ -72,7 +74,8 @@ static int iniKeyToElektraKey (void *vhandle, const char *section, const char *n
 
 	CallbackHandle *handle = (CallbackHandle *)vhandle;
 
-	Key *appendKey = keyDup (handle->parentKey);
+	Key *appendKey = elektraKsNewKey (handle->returned, 0);
+	keyCopy (appendKey, handle->parentKey);
 
 	if (section)
 	{
@@ -88,7 +91,7 @@ static int iniKeyToElektraKey (void *vhandle, const char *section, const char *n
 	{
 		flushCollectedComment (handle, appendKey);
 		keySetString (appendKey, value);
-		ksAppendKey (handle->result, appendKey);
+		elektraKsAppendUnsorted (handle->result, appendKey);
 	}
 	else
 	{
@@ -109,11 +112,12 @@ static int iniSectionToElektraKey (void *vhandle, const char *section)
 {
 	CallbackHandle *handle = (CallbackHandle *)vhandle;
 
-	Key *appendKey = keyDup (handle->parentKey);
+	Key *appendKey = elektraKsNewKey (handle->returned, 0);
+	keyCopy (appendKey, handle->parentKey);
 	keySetBinary(appendKey, 0, 0);
 	keyAddBaseName(appendKey, section);
 	flushCollectedComment (handle, appendKey);
-	ksAppendKey(handle->result, appendKey);
+	elektraKsAppendUnsorted(handle->result, appendKey);
 
 	return 1;
 }
@@ -198,8 +202,11 @@ int elektraIniGet(Plugin *handle, KeySet *returned, Key *parentKey)
 	CallbackHandle cbHandle;
 	cbHandle.parentKey = parentKey;
 	cbHandle.result = append;
+	cbHandle.returned = returned;
 	cbHandle.collectedComment = 0;
-	ksAppendKey (cbHandle.result, keyDup(parentKey));
+	Key *parentCopy = elektraKsNewKey (returned, 0);
+	keyCopy (parentCopy, parentKey);
+	ksAppendKey (cbHandle.result, parentCopy);
 
 
 
@@ -219,6 +226,7 @@ int elektraIniGet(Plugin *handle, KeySet *returned, Key *parentKey)
 	if (ret == 0)
 	{
 		ksClear(returned);
+		elektraKsSort(cbHandle.result);
 		ksAppend(returned, cbHandle.result);
 		ret = 1;
 	}
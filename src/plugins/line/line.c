@@ -37,11 +37,12 @@ static inline KeySet *elektraLineContract()
 	KS_END);
 }
 
-int elektraLineRead(FILE * fp, KeySet * returned)
+int elektraLineRead(FILE * fp, KeySet * returned, Key * parentKey)
 {
 	char *value = NULL;
 	size_t len = 0;
 	ssize_t n = 0;
+	ssize_t next = 0; // start with #0
 	Key *read = NULL;
 
 	//Read in each line
@@ -52,16 +53,13 @@ int elektraLineRead(FILE * fp, KeySet * returned)
 		{
 			value[n - 1] = '\0';
 		}
-		read = keyDup(ksTail(returned));
-		if (elektraArrayIncName(read) == -1)
+		read = elektraArrayAppend(returned, parentKey, &next);
+		if (!read)
 		{
 			free (value);
-			keyDel (read);
 			return -1;
 		}
 		keySetString(read, value);
-
-		ksAppendKey (returned, read);
 	}
 	free(value);
 
@@ -91,15 +89,10 @@ int elektraLineGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parentK
 		return -1;
 	}
 
-	Key *b= keyNew(keyName(parentKey), KEY_END);
-	ksAppendKey (returned, keyDup(b)); // start with parentKey
-	keyAddName(b, "#"); // start point for our array
-	ksAppendKey (returned, b);
-
-	int ret = elektraLineRead(fp, returned);
+	// start with parentKey
+	ksAppendKey (returned, keyNew(keyName(parentKey), KEY_END));
 
-	// get rid of startpoint, if it was an empty file
-	keyDel(ksLookup(returned, b, KDB_O_POP));
+	int ret = elektraLineRead(fp, returned, parentKey);
 
 	if (ret == -1)
 	{
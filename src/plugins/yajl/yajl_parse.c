@@ -23,7 +23,7 @@ static int elektraYajlIncrementArrayEntry(KeySet * ks)
 
 	if (baseName && *baseName == '#')
 	{
-		current = keyNew(keyName(current), KEY_END);
+		current = elektraKsNewKey(ks, keyName(current), KEY_END);
 		if (!strcmp(baseName, "###empty_array"))
 		{
 			// get rid of previous key
@@ -143,7 +143,7 @@ static int elektraYajlParseMapKey(void *ctx, const unsigned char * stringVal,
 	KeySet *ks = (KeySet*) ctx;
 	elektraYajlIncrementArrayEntry(ks);
 
-	Key *currentKey = keyNew(keyName(ksCurrent(ks)), KEY_END);
+	Key *currentKey = elektraKsNewKey(ks, keyName(ksCurrent(ks)), KEY_END);
 	keySetString(currentKey, 0);
 
 	unsigned char delim = stringVal[stringLen];
@@ -181,7 +181,7 @@ static int elektraYajlParseStartMap(void *ctx)
 
 	Key *currentKey = ksCurrent(ks);
 
-	Key * newKey = keyNew (keyName(currentKey), KEY_END);
+	Key * newKey = elektraKsNewKey (ks, keyName(currentKey), KEY_END);
 	// add a pseudo element for empty map
 	keyAddBaseName(newKey, "___empty_map");
 	ksAppendKey(ks, newKey);
@@ -229,7 +229,7 @@ static int elektraYajlParseStartArray(void *ctx)
 
 	Key *currentKey = ksCurrent(ks);
 
-	Key * newKey = keyNew (keyName(currentKey), KEY_END);
+	Key * newKey = elektraKsNewKey (ks, keyName(currentKey), KEY_END);
 	// add a pseudo element for empty array
 	keyAddName(newKey, "###empty_array");
 	ksAppendKey(ks, newKey);
@@ -333,7 +333,7 @@ int elektraYajlGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned,
 		elektraYajlParseEnd
 	};
 
-	ksAppendKey(returned, keyNew(keyName((parentKey)), KEY_END));
+	ksAppendKey(returned, elektraKsNewKey(returned, keyName((parentKey)), KEY_END));
 
 #if YAJL_MAJOR == 1
 	yajl_parser_config cfg = { 1, 1 };
@@ -296,25 +296,28 @@ void output_backend(Backend *backend)
 
 void output_trie(Trie *trie)
 {
-	int i;
-	for (i=0; i < KDB_MAX_UCHAR; ++i)
+	size_t i;
+	for (i=0; i < trie->size; ++i)
 	{
-		if (trie->value[i])
-		{
-			printf ("output_trie: %p, mp: %s %s [%d]\n",
-					(void*) trie->value[i],
-					keyName(trie->value[i]->mountpoint),
-					keyString(trie->value[i]->mountpoint),
-					i);
-		}
-		if (trie->children[i]) output_trie(trie->children[i]);
+		printf ("output_trie: %p, text: %s\n",
+				(void*) trie->children[i],
+				trie->children[i]->text);
+		output_trie(trie->children[i]);
+	}
+	for (i=0; i < trie->nrShadowed; ++i)
+	{
+		printf ("shadowed: %p, mp: %s %s\n",
+				(void*) trie->shadowed[i],
+				keyName(trie->shadowed[i]->mountpoint),
+				keyString(trie->shadowed[i]->mountpoint)
+				);
 	}
-	if (trie->empty_value)
+	if (trie->value)
 	{
-		printf ("empty_value: %p, mp: %s %s\n",
-				(void*) trie->empty_value,
-				keyName(trie->empty_value->mountpoint),
-				keyString(trie->empty_value->mountpoint)
+		printf ("value: %p, mp: %s %s\n",
+				(void*) trie->value,
+				keyName(trie->value->mountpoint),
+				keyString(trie->value->mountpoint)
 				);
 	}
 }
@@ -161,6 +161,143 @@ static void test_getArrayNext()
 	ksDel(array);
 }
 
+static void test_getArrayRange()
+{
+	printf ("Test get array range\n");
+
+	KeySet *keys = ksNew(10,
+			keyNew("user/test/array", KEY_END),
+			keyNew("user/test/array/#", KEY_END),
+			keyNew("user/test/array/#0", KEY_END),
+			keyNew("user/test/array/#0/below", KEY_END),
+			keyNew("user/test/array/#1", KEY_END),
+			keyNew("user/test/array/#_10", KEY_END),
+			keyNew("user/test/array/#__1", KEY_END),
+			keyNew("user/test/array/key", KEY_END),
+			keyNew("user/test/arrayafter/#0", KEY_END),
+			keyNew("user/test/yetanotherkey", KEY_END),
+			KS_END);
+
+	Key *arrayParent = keyNew("user/test/array", KEY_END);
+	cursor_t begin = -1;
+	cursor_t end = -1;
+	succeed_if (elektraArrayGetRange(keys, arrayParent, &begin, &end) == 5,
+			"wrong number of keys in the range");
+	succeed_if_same_string (keyName(ksAtCursor(keys, begin)), "user/test/array/#0");
+	succeed_if_same_string (keyName(ksAtCursor(keys, end-1)), "user/test/array/#__1");
+	succeed_if_same_string (keyName(ksAtCursor(keys, end)), "user/test/array/key");
+
+	KeySet *array = elektraArrayGet(arrayParent, keys);
+	succeed_if (ksGetSize(array) == 3, "the array contains a wrong number of elements");
+	succeed_if (ksLookupByName(array, "user/test/array/#0", KDB_O_NONE), "the array does not contain #0");
+	succeed_if (ksLookupByName(array, "user/test/array/#1", KDB_O_NONE), "the array does not contain #1");
+	succeed_if (ksLookupByName(array, "user/test/array/#_10", KDB_O_NONE), "the array does not contain #_10");
+	ksDel(array);
+
+	keySetName(arrayParent, "user/test/key");
+	succeed_if (elektraArrayGetRange(keys, arrayParent, &begin, &end) == 0,
+			"found elements of a missing array");
+	array = elektraArrayGet(arrayParent, keys);
+	succeed_if (ksGetSize(array) == 0, "elements of a missing array");
+	ksDel(array);
+
+	succeed_if (elektraArrayGetRange(0, arrayParent, &begin, &end) == -1, "null pointer");
+	succeed_if (elektraArrayGetRange(keys, 0, &begin, &end) == -1, "null pointer");
+	succeed_if (elektraArrayGetRange(keys, arrayParent, 0, &end) == -1, "null pointer");
+
+	keyDel(arrayParent);
+	ksDel(keys);
+}
+
+static void test_getArrayMeta()
+{
+	printf ("Test get array of meta keys\n");
+
+	Key *key = keyNew("user/key", KEY_END);
+	keySetMeta(key, "comment", "");
+	keySetMeta(key, "comment/#0", "inline");
+	keySetMeta(key, "comment/#0/space", "1");
+	keySetMeta(key, "comment/#1", "first");
+	keySetMeta(key, "comment/#1/start", "#");
+	keySetMeta(key, "comment/#2", "second");
+	keySetMeta(key, "commentary", "");
+
+	KeySet *metaKeys = elektraKeyGetMetaKeySet(key);
+	Key *commentParent = keyNew("comment", KEY_META_NAME, KEY_END);
+	KeySet *comments = elektraArrayGet(commentParent, metaKeys);
+
+	succeed_if (ksGetSize(comments) == 3, "the array contains a wrong number of elements");
+	succeed_if_same_string (keyName(ksAtCursor(comments, 0)), "comment/#0");
+	succeed_if_same_string (keyName(ksAtCursor(comments, 2)), "comment/#2");
+
+	ssize_t next = -1;
+	Key *element = elektraArrayAppend(metaKeys, commentParent, &next);
+	exit_if_fail (element, "could not append to the array");
+	succeed_if_same_string (keyName(element), "comment/#3");
+	succeed_if (next == 4, "the next index was not remembered");
+
+	keyDel(commentParent);
+	ksDel(comments);
+	ksDel(metaKeys);
+	keyDel(key);
+}
+
+static void test_arrayAppend()
+{
+	printf ("Test array append\n");
+
+	KeySet *keys = ksNew(10,
+			keyNew("user/test/array", KEY_END),
+			keyNew("user/test/array/#0", KEY_END),
+			keyNew("user/test/array/#_10", KEY_END),
+			keyNew("user/test/array/#_10/below", KEY_END),
+			keyNew("user/test/array/#__1", KEY_END),
+			keyNew("user/test/other", KEY_END),
+			KS_END);
+
+	Key *arrayParent = keyNew("user/test/array", KEY_END);
+	ssize_t next = -1;
+	Key *element = elektraArrayAppend(keys, arrayParent, &next);
+	exit_if_fail (element, "could not append to the array");
+	succeed_if_same_string (keyName(element), "user/test/array/#_11");
+	succeed_if_same_string (keyString(element), "");
+	succeed_if (ksLookupByName(keys, "user/test/array/#_11", KDB_O_NONE) == element,
+			"the element was not appended to the keyset");
+	succeed_if (next == 12, "the next index was not remembered");
+
+	for (int i = 12; i<100; ++i)
+	{
+		succeed_if (elektraArrayAppend(keys, arrayParent, &next), "could not append in loop");
+	}
+	element = elektraArrayAppend(keys, arrayParent, &next);
+	succeed_if_same_string (keyName(element), "user/test/array/#__100");
+	succeed_if (ksGetSize(keys) == 96, "wrong number of keys after appending");
+
+	if (sizeof(ssize_t) >= 8)
+	{
+		next = (ssize_t)9999999999LL;
+		element = elektraArrayAppend(keys, arrayParent, &next);
+		succeed_if_same_string (keyName(element), "user/test/array/#_________9999999999");
+		succeed_if (!elektraArrayAppend(keys, arrayParent, &next), "appended a too large index");
+	}
+
+	keySetName(arrayParent, "user/test/empty");
+	next = -1;
+	element = elektraArrayAppend(keys, arrayParent, &next);
+	succeed_if_same_string (keyName(element), "user/test/empty/#0");
+
+	elektraKsFreeze(keys);
+	succeed_if (!elektraArrayAppend(keys, arrayParent, &next), "appended to a frozen keyset");
+	succeed_if (next == 1, "index incremented on error");
+
+	succeed_if (!elektraArrayAppend(0, arrayParent, &next), "null pointer");
+	succeed_if (!elektraArrayAppend(keys, 0, &next), "null pointer");
+	succeed_if (!elektraArrayAppend(keys, arrayParent, 0), "null pointer");
+
+	keyDel(arrayParent);
+	ksDel(keys);
+}
+
 int main(int argc, char** argv)
 {
 	printf(" ARRAY   TESTS\n");
@@ -173,6 +310,9 @@ int main(int argc, char** argv)
 	test_startArray();
 	test_getArray();
 	test_getArrayNext();
+	test_getArrayRange();
+	test_getArrayMeta();
+	test_arrayAppend();
 
 	printf("\ntest_array RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
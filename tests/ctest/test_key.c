@@ -1,5 +1,7 @@
 #include <tests_internal.h>
 
+#include <stddef.h>
+
 #ifdef HAVE_TIME_H
 #include <time.h>
 #endif
@@ -1643,6 +1645,208 @@ static void test_keyCanonify()
 	keyDel(k);
 }
 
+static void test_keyCopyOnWrite()
+{
+	printf ("test copy on write\n");
+
+	Key *k = keyNew("user/cow/key", KEY_VALUE, "a value too long to be inline", KEY_END);
+	Key *d = keyDup(k);
+	succeed_if(d->key == k->key, "name should be shared");
+	succeed_if(d->data.v == k->data.v, "value should be shared");
+	succeed_if(k->sharedName && k->sharedName->references == 2, "wrong references");
+
+	Key *d2 = keyDup(d);
+	succeed_if(d2->key == k->key, "name should be shared");
+	succeed_if(k->sharedName->references == 3, "wrong references");
+
+	// changing the value of the source does not change duplicates
+	keySetString(k, "another value too long to be inline");
+	succeed_if(k->data.v != d->data.v, "value not copied on write");
+	succeed_if(k->value.shared == 0, "value still shared");
+	succeed_if_same_string(keyString(k), "another value too long to be inline");
+	succeed_if_same_string(keyString(d), "a value too long to be inline");
+	succeed_if_same_string(keyString(d2), "a value too long to be inline");
+
+	// changing names in every way
+	keyAddBaseName(d, "base");
+	succeed_if_same_string(keyName(d), "user/cow/key/base");
+	succeed_if_same_string(keyName(k), "user/cow/key");
+	keySetBaseName(d2, "other");
+	succeed_if_same_string(keyName(d2), "user/cow/other");
+	succeed_if_same_string(keyName(k), "user/cow/key");
+	succeed_if_same_string(keyBaseName(k), "key");
+	keyDel(d2);
+
+	d2 = keyDup(k);
+	keySetBaseName(d2, 0);
+	succeed_if_same_string(keyName(d2), "user/cow");
+	succeed_if_same_string(keyName(k), "user/cow/key");
+	succeed_if_same_string(keyBaseName(k), "key");
+	keyAddName(d2, "more/levels");
+	succeed_if_same_string(keyName(d2), "user/cow/more/levels");
+	keyDel(d2);
+
+	d2 = keyDup(k);
+	keySetName(d2, "user/renamed");
+	succeed_if_same_string(keyName(d2), "user/renamed");
+	succeed_if_same_string(keyName(k), "user/cow/key");
+	keyDel(d2);
+
+	// deleting the source keeps the shared buffers of duplicates
+	d2 = keyDup(d);
+	keyDel(d);
+	succeed_if_same_string(keyName(d2), "user/cow/key/base");
+	succeed_if_same_string(keyString(d2), "a value too long to be inline");
+
+	// keyCopy shares, too
+	keyCopy(d2, k);
+	succeed_if(d2->key == k->key, "name should be shared");
+	succeed_if_same_string(keyString(d2), "another value too long to be inline");
+	keyCopy(d2, d2);
+	succeed_if_same_string(keyName(d2), "user/cow/key");
+	keyCopy(d2, 0);
+	succeed_if_same_string(keyName(d2), "");
+	succeed_if_same_string(keyName(k), "user/cow/key");
+
+	keyDel(d2);
+	keyDel(k);
+
+	// deep duplication of keysets shares all names and values
+	KeySet *ks = ksNew(3,
+		keyNew("user/cow/a", KEY_VALUE, "a", KEY_END),
+		keyNew("user/cow/b", KEY_VALUE, "b", KEY_END),
+		KS_END);
+	KeySet *deep = ksDeepDup(ks);
+	Key *a = ksLookupByName(ks, "user/cow/a", 0);
+	Key *deepA = ksLookupByName(deep, "user/cow/a", 0);
+	succeed_if(a != deepA, "keys should be duplicated");
+	succeed_if(a->key == deepA->key, "name should be shared");
+	keySetString(deepA, "changed");
+	succeed_if_same_string(keyString(a), "a");
+	ksDel(ks);
+	succeed_if_same_string(keyString(ksLookupByName(deep, "user/cow/b", 0)), "b");
+	ksDel(deep);
+}
+
+static void test_keyInlineValue()
+{
+	printf ("test inline values\n");
+
+	Key *k = keyNew("user/inline", KEY_VALUE, "true", KEY_END);
+	succeed_if(k->data.v == k->value.inlined, "short value should be inline");
+	succeed_if_same_string(keyString(k), "true");
+
+	// duplicates get their own inline copy
+	Key *d = keyDup(k);
+	succeed_if(d->data.v == d->value.inlined, "short value of duplicate should be inline");
+	succeed_if(test_bit(k->flags, KEY_FLAG_INLINE_VALUE) && test_bit(d->flags, KEY_FLAG_INLINE_VALUE),
+		"inline value should not be shared");
+	succeed_if_same_string(keyString(d), "true");
+
+	// growing moves the value out, shrinking back in
+	keySetString(k, "a value too long to be inline");
+	succeed_if(k->data.v != k->value.inlined, "long value should not be inline");
+	succeed_if_same_string(keyString(k), "a value too long to be inline");
+	succeed_if_same_string(keyString(d), "true");
+
+	Key *d2 = keyDup(k);
+	keySetString(d2, "8080");
+	succeed_if(d2->data.v == d2->value.inlined, "shrunk value should be inline");
+	succeed_if(k->value.shared && k->value.shared->references == 1, "shared value not released");
+	succeed_if_same_string(keyString(d2), "8080");
+
+	keySetString(d2, "12345678");
+	succeed_if(d2->data.v != d2->value.inlined, "value larger than inline size should not be inline");
+	succeed_if_same_string(keyString(d2), "12345678");
+	succeed_if_same_string(keyString(k), "a value too long to be inline");
+
+	keyCopy(d2, d);
+	succeed_if(d2->data.v == d2->value.inlined, "copied short value should be inline");
+	succeed_if_same_string(keyString(d2), "true");
+	keyDel(d);
+	succeed_if_same_string(keyString(d2), "true");
+
+	char binary[KEY_INLINE_VALUE_SIZE] = {1, 0, 2};
+	keySetBinary(d2, binary, sizeof(binary));
+	succeed_if(d2->data.v == d2->value.inlined, "binary value of inline size should be inline");
+	succeed_if(!memcmp(keyValue(d2), binary, sizeof(binary)), "binary value is wrong");
+	keySetBinary(d2, 0, 0);
+	succeed_if(keyValue(d2) == 0, "value should be removed");
+
+	keyDel(d2);
+	keyDel(k);
+
+	// the inline value must not make keys larger
+	if (sizeof(void*) == 8)
+	{
+		succeed_if(sizeof(struct _Key) == 88, "key got larger");
+		succeed_if(offsetof(struct _Key, arena) == 64, "fields for lookups not in first cache line");
+	}
+}
+
+static void checkNameCache(Key *k, const char *msg)
+{
+	struct _Key probe = *k;
+	elektraKeyNameCache(&probe);
+	succeed_if(probe.nameHash == k->nameHash, msg);
+	succeed_if(probe.namePrefix == k->namePrefix, msg);
+}
+
+static void test_keyNameCache()
+{
+	printf ("test name cache\n");
+
+	Key *k = keyNew("user/cache/name", KEY_END);
+	checkNameCache(k, "cache wrong after keyNew");
+	keyAddBaseName(k, "base");
+	checkNameCache(k, "cache wrong after keyAddBaseName");
+	keySetBaseName(k, "other");
+	checkNameCache(k, "cache wrong after keySetBaseName");
+	keyAddName(k, "../more/levels");
+	checkNameCache(k, "cache wrong after keyAddName");
+	keySetName(k, "/cascading");
+	checkNameCache(k, "cache wrong after cascading name");
+	keySetName(k, "");
+	checkNameCache(k, "cache wrong after empty name");
+	keySetName(k, "invalid");
+	checkNameCache(k, "cache wrong after invalid name");
+	keySetName(k, "user:owner/x");
+	checkNameCache(k, "cache wrong after name with owner");
+
+	Key *d = keyDup(k);
+	checkNameCache(d, "cache wrong after keyDup");
+	keyCopy(d, 0);
+	checkNameCache(d, "cache wrong after clearing");
+	keyCopy(d, k);
+	checkNameCache(d, "cache wrong after keyCopy");
+	keyDel(d);
+	keyDel(k);
+
+	// the prefix orders names like keyCmp() does
+	const char *names[] = {"/", "/a", "dir/a", "system", "system/a", "system/a/b",
+		"system/a/b/c/d/e", "system/a/b/c/d/f", "system/ab", "system/a\\/b",
+		"user", "user/a", "user/%", "user/a/very/long/name", "user/b", 0};
+	for (size_t i=0; names[i]; ++i)
+	{
+		for (size_t j=0; names[j]; ++j)
+		{
+			Key *k1 = keyNew(names[i], KEY_CASCADING_NAME, KEY_END);
+			Key *k2 = keyNew(names[j], KEY_CASCADING_NAME, KEY_END);
+			int cmp = keyCmp(k1, k2);
+			if (k1->namePrefix < k2->namePrefix) succeed_if(cmp < 0, "prefix order differs");
+			if (k1->namePrefix > k2->namePrefix) succeed_if(cmp > 0, "prefix order differs");
+			succeed_if((cmp == 0) == (i == j), "names should only equal themselves");
+			if (i == j) succeed_if(k1->nameHash == k2->nameHash, "hash differs");
+			int below = !strncmp(names[j], names[i], strlen(names[i])) &&
+				names[j][strlen(names[i])] == '/' && strcmp(names[i], "/");
+			succeed_if(keyIsBelow(k1, k2) == below, "keyIsBelow wrong");
+			succeed_if(keyIsBelowOrSame(k1, k2) == (below || i == j), "keyIsBelowOrSame wrong");
+			keyDel(k2);
+			keyDel(k1);
+		}
+	}
+}
+
 int main(int argc, char** argv)
 {
 	printf("KEY      TESTS\n");
@@ -1672,6 +1876,9 @@ int main(int argc, char** argv)
 	test_keyFixedNew();
 	test_keyFlags();
 	test_keyCanonify();
+	test_keyCopyOnWrite();
+	test_keyInlineValue();
+	test_keyNameCache();
 
 	printf("\ntest_key RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
@@ -87,6 +87,197 @@ static void test_cascadingLookup()
 	ksDel(ks);
 }
 
+static void test_cascadingNamespaces()
+{
+	printf ("test cascading lookup in all namespaces\n");
+
+	Key *sys, *usr, *dir, *proc, *def, *esc, *root;
+	KeySet *ks = ksNew (10,
+		sys = keyNew("system/cascading/key", KEY_END),
+		usr = keyNew("user/cascading/key", KEY_END),
+		dir = keyNew("dir/cascading/dir", KEY_END),
+		proc = keyNew("proc/cascading/proc", KEY_END),
+		def = keyNew("/cascading/default", KEY_END),
+		esc = keyNew("system/cascading/with\\/slash", KEY_END),
+		root = keyNew("user", KEY_END),
+		KS_END);
+
+	succeed_if(ksLookupByName(ks, "/cascading/key", 0) == usr, "user should be preferred to system");
+	succeed_if(ksLookupByName(ks, "/cascading/dir", 0) == dir, "dir not found");
+	succeed_if(ksLookupByName(ks, "/cascading/proc", 0) == proc, "proc not found");
+	succeed_if(ksLookupByName(ks, "/cascading/default", 0) == def, "cascading key itself not found");
+	succeed_if(ksLookupByName(ks, "/cascading/default", KDB_O_NODEFAULT) == 0, "cascading key should not be found");
+	succeed_if(ksLookupByName(ks, "/cascading/with\\/slash", 0) == esc, "escaped name not found");
+	succeed_if(ksLookupByName(ks, "/cascading/with/slash", 0) == 0, "unescaped name should not be found");
+	succeed_if(ksLookupByName(ks, "/cascading", 0) == 0, "parent should not be found");
+	succeed_if(ksLookupByName(ks, "/", 0) == root, "root not found");
+
+	Key *search = keyNew ("/cascading/key", KEY_CASCADING_NAME, KEY_END);
+	succeed_if(ksLookup(ks, search, KDB_O_POP) == usr, "could not pop user key");
+	succeed_if_same_string(keyName(search), "/cascading/key");
+	succeed_if(ksLookup(ks, search, 0) == sys, "system key should be found after pop");
+	ksRewind(ks);
+	succeed_if(ksLookup(ks, search, KDB_O_NOALL) == sys, "system key should be found by linear search");
+	keyDel(search);
+	keyDel(usr);
+
+	ksDel(ks);
+}
+
+static const char *firstPart(const Key *key)
+{
+	return key->key + key->keySize;
+}
+
+/* checks the namespace ranges against a linear scan */
+static void checkRanges(KeySet *ks)
+{
+	static const char *namespaces[KEYSET_NAMESPACES] =
+		{"", "dir", "proc", "spec", "system", "user"};
+
+	if (!(ks->flags & KS_FLAG_RANGES)) return;
+
+	for (int i=0; i<KEYSET_NAMESPACES; ++i)
+	{
+		size_t begin = 0;
+		while (begin < ks->size && strcmp(firstPart(ks->array[begin]), namespaces[i]) < 0) ++begin;
+		size_t end = begin;
+		while (end < ks->size && !strcmp(firstPart(ks->array[end]), namespaces[i])) ++end;
+		succeed_if(ks->nsRanges[i].begin == begin, "wrong begin of namespace range");
+		succeed_if(ks->nsRanges[i].end == end, "wrong end of namespace range");
+	}
+}
+
+static void test_namespaceRanges()
+{
+	printf ("test namespace ranges\n");
+
+	static const char *namespaces[] = {"spec", "proc", "dir", "user", "system", ""};
+	char name[64];
+	KeySet *ks = ksNew(0, KS_END);
+	for (int i=0; i<200; ++i)
+	{
+		// leave out proc, so that there is an empty range
+		if (i%6 == 1) continue;
+		snprintf(name, sizeof(name), "%s/ranges/%03d", namespaces[i%6], i);
+		ksAppendKey(ks, keyNew(name, KEY_CASCADING_NAME, KEY_END));
+	}
+
+	Key *found = ksLookupByName(ks, "user/ranges/003", KDB_O_NOCASCADING);
+	exit_if_fail(found, "user key not found");
+	succeed_if(ks->flags & KS_FLAG_RANGES, "ranges should be built for large keysets");
+	checkRanges(ks);
+	succeed_if(ksLookupByName(ks, "system/ranges/004", 0) != 0, "system key not found");
+	succeed_if(ksLookupByName(ks, "system/ranges/003", 0) == 0, "key of other namespace found");
+	succeed_if(ksLookupByName(ks, "proc/ranges/001", 0) == 0, "key in empty namespace found");
+	succeed_if(ksLookupByName(ks, "/ranges/005", KDB_O_NOCASCADING) != 0, "cascading key not found");
+	succeed_if(ksLookupByName(ks, "/ranges/003", 0) == found, "cascading lookup failed");
+
+	// inserting and popping single keys keeps the ranges
+	ksAppendKey(ks, keyNew("proc/ranges/new", KEY_END));
+	ksAppendKey(ks, keyNew("dir/ranges/new", KEY_END));
+	ksAppendKey(ks, keyNew("user/ranges/zzz", KEY_END));
+	ksAppendKey(ks, keyNew("system/ranges/new", KEY_END));
+	succeed_if(ks->flags & KS_FLAG_RANGES, "ranges should be kept on insert");
+	checkRanges(ks);
+	succeed_if(ksLookupByName(ks, "proc/ranges/new", 0) != 0, "inserted proc key not found");
+
+	keyDel(ksLookupByName(ks, "dir/ranges/002", KDB_O_POP));
+	keyDel(ksLookupByName(ks, "proc/ranges/new", KDB_O_POP));
+	keyDel(ksPop(ks));
+	succeed_if(ks->flags & KS_FLAG_RANGES, "ranges should be kept on pop");
+	checkRanges(ks);
+
+	// cutting one namespace keeps them, too
+	Key *cutpoint = keyNew("system/ranges", KEY_END);
+	KeySet *cut = ksCut(ks, cutpoint);
+	succeed_if(ksGetSize(cut) > 0, "nothing was cut");
+	succeed_if(ks->flags & KS_FLAG_RANGES, "ranges should be kept on cut");
+	checkRanges(ks);
+	succeed_if(ksLookupByName(ks, "system/ranges/004", 0) == 0, "cut key found");
+	ksDel(cut);
+	keyDel(cutpoint);
+
+	cutpoint = keyNew("/ranges", KEY_CASCADING_NAME, KEY_END);
+	cut = ksCut(ks, cutpoint);
+	checkRanges(ks);
+	succeed_if(ksLookupByName(ks, "user/ranges/003", 0) == 0, "cut key found");
+	succeed_if(ksLookupByName(ks, "/ranges/005", KDB_O_NOCASCADING) != 0, "cascading keys should not be cut");
+	ksDel(cut);
+	keyDel(cutpoint);
+
+	ksDel(ks);
+}
+
+static void test_constLookup()
+{
+	printf ("test const lookup\n");
+
+	Key *sys, *usr, *override, *spec, *spaces;
+	KeySet *ks = ksNew (20,
+		sys = keyNew("system/const/key", KEY_END),
+		usr = keyNew("user/const/key", KEY_END),
+		keyNew("system/const/other", KEY_END),
+		override = keyNew("user/const/override", KEY_END),
+		keyNew("spec/const/spec", KEY_META, "override/#0", "/const/missing",
+			KEY_META, "override/#1", "/const/override", KEY_END),
+		spec = keyNew("system/const/spec", KEY_END),
+		keyNew("spec/const/spaces", KEY_META, "namespace/#0", "system", KEY_END),
+		keyNew("user/const/spaces", KEY_END),
+		spaces = keyNew("system/const/spaces", KEY_END),
+		keyNew("spec/const/default", KEY_META, "default", "5", KEY_END),
+		KS_END);
+
+	ksRewind(ks);
+	ksNext(ks);
+	cursor_t cursor = ksGetCursor(ks);
+
+	succeed_if(elektraKsLookupByNameConst(ks, "system/const/key", 0) == sys, "system key not found");
+	succeed_if(elektraKsLookupByNameConst(ks, "SYSTEM/CONST/KEY", KDB_O_NOCASE) == sys, "key not found ignoring case");
+	succeed_if(elektraKsLookupByNameConst(ks, "user:owner/const/key", 0) == usr, "key with owner not found");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/key", 0) == usr, "cascading lookup failed");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/other", 0) != 0, "cascading lookup in system failed");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/key", KDB_O_NOCASCADING) == 0, "cascading key found");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/spec", 0) == override, "override of spec not used");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/spaces", 0) == spaces, "namespaces of spec not used");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/default", 0) == 0, "default should not be created");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/key", KDB_O_POP) == 0, "pop is not supported");
+	(void)spec;
+
+	succeed_if(ksGetCursor(ks) == cursor, "cursor was moved");
+	succeed_if(ksGetSize(ks) == 10, "keyset was changed");
+	succeed_if(ks->hashTable == 0 && ks->hashMisses == 0, "hash index was touched");
+
+	// defaults added by ksLookup() are found
+	Key *def = ksLookupByName(ks, "/const/default", 0);
+	exit_if_fail(def, "default was not created");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/default", 0) == def, "added default not found");
+
+	// indices built before are used
+	for (int i=0; i<200; ++i)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "user/const/many/%d", i);
+		ksAppendKey(ks, keyNew(name, KEY_END));
+	}
+	for (int i=0; i<100 && !ks->hashTable; ++i) ksLookupByName(ks, "user/const/key", 0);
+	succeed_if(ks->hashTable != 0, "hash index was not built");
+	succeed_if(elektraKsLookupByNameConst(ks, "user/const/many/42", 0) != 0, "key not found with hash index");
+	succeed_if(elektraKsLookupByNameConst(ks, "/const/key", 0) == usr, "cascading lookup with hash index failed");
+
+	ksDel(ks);
+
+	// unsorted keysets are searched without sorting them
+	ks = ksNew(0, KS_END);
+	elektraKsAppendUnsorted(ks, keyNew("user/b", KEY_VALUE, "first", KEY_END));
+	elektraKsAppendUnsorted(ks, keyNew("user/a", KEY_END));
+	elektraKsAppendUnsorted(ks, keyNew("user/b", KEY_VALUE, "last", KEY_END));
+	succeed_if_same_string(keyString(elektraKsLookupByNameConst(ks, "user/b", 0)), "last");
+	succeed_if(elektraKsLookupByNameConst(ks, "user/a", 0) != 0, "unsorted key not found");
+	succeed_if(ks->flags & KS_FLAG_UNSORTED, "keyset was sorted");
+	ksDel(ks);
+}
+
 static void test_creatingLookup()
 {
 	printf ("Test creating lookup\n");
@@ -179,6 +370,1085 @@ static void test_creatingLookup()
 	ksDel(ks);
 }
 
+static void test_hashLookup()
+{
+	printf ("test hash lookup\n");
+	char name[64];
+	const int size = 500;
+	KeySet *ks = ksNew(0, KS_END);
+
+	for (int i=size-1; i>=0; --i)
+	{
+		snprintf(name, sizeof(name), "user/hash/%d/key", i);
+		ksAppendKey(ks, keyNew(name, KEY_VALUE, name, KEY_END));
+	}
+
+	for (int j=0; j<2; ++j)
+	for (int i=0; i<size; ++i)
+	{
+		snprintf(name, sizeof(name), "user/hash/%d/key", i);
+		Key *found = ksLookupByName(ks, name, 0);
+		exit_if_fail(found, "did not find key");
+		succeed_if_same_string(keyName(found), name);
+		succeed_if(ksCurrent(ks) == found, "cursor not set");
+	}
+	succeed_if(ks->hashTable != 0, "hash index not built");
+	succeed_if(ksLookupByName(ks, "user/hash/1000/key", 0) == 0,
+		"found not existing key");
+	succeed_if(ksLookupByName(ks, "user/hash", 0) == 0,
+		"found not existing key");
+
+	// appending at the end keeps the index
+	ksAppendKey(ks, keyNew("user/zzz", KEY_END));
+	succeed_if(ks->hashTable != 0, "hash index dropped on append");
+	succeed_if(ksLookupByName(ks, "user/zzz", 0) == ksTail(ks),
+		"did not find appended key");
+
+	// popping keeps the index
+	Key *popped = ksPop(ks);
+	succeed_if(ks->hashTable != 0, "hash index dropped on pop");
+	succeed_if(ksLookupByName(ks, "user/zzz", 0) == 0, "found popped key");
+	keyDel(popped);
+
+	// cutting at the end keeps the index
+	Key *cutpoint = keyNew("user/hash/99", KEY_END);
+	KeySet *cut = ksCut(ks, cutpoint);
+	succeed_if(ksGetSize(cut) == 1, "wrong size of cut");
+	succeed_if(ks->hashTable != 0, "hash index dropped on cut at end");
+	succeed_if(ksLookupByName(ks, "user/hash/99/key", 0) == 0, "found cut key");
+	succeed_if(ksLookupByName(ks, "user/hash/98/key", 0) != 0, "did not find key");
+	ksDel(cut);
+	keyDel(cutpoint);
+
+	// inserting in the middle drops the index
+	ksAppendKey(ks, keyNew("user/hash/0/a", KEY_END));
+	succeed_if(ks->hashTable == 0, "hash index not dropped");
+	succeed_if(ksLookupByName(ks, "user/hash/0/a", 0) != 0,
+		"did not find inserted key");
+
+	// popping in the middle drops the index
+	for (int i=0; i<size; ++i)
+	{
+		ksLookupByName(ks, "user/hash/0/a", 0);
+	}
+	succeed_if(ks->hashTable != 0, "hash index not built again");
+	popped = ksLookupByName(ks, "user/hash/0/a", KDB_O_POP);
+	succeed_if(popped != 0, "could not pop");
+	succeed_if(ks->hashTable == 0, "hash index not dropped");
+	keyDel(popped);
+	for (int i=0; i<size; ++i)
+	{
+		snprintf(name, sizeof(name), "user/hash/%d/key", i);
+		Key *found = ksLookupByName(ks, name, 0);
+		succeed_if((found != 0) == (i != 99), "lookup after pop wrong");
+	}
+
+	ksDel(ks);
+}
+
+static void test_mergeAppend()
+{
+	printf ("test merge append\n");
+	Key *a, *b, *c, *d, *e, *bb, *dd;
+	KeySet *ks = ksNew(10,
+		a = keyNew("user/a", KEY_END),
+		b = keyNew("user/b", KEY_VALUE, "old", KEY_END),
+		d = keyNew("user/d", KEY_VALUE, "old", KEY_END),
+		KS_END);
+	KeySet *toAppend = ksNew(10,
+		bb = keyNew("user/b", KEY_VALUE, "new", KEY_END),
+		c = keyNew("user/c", KEY_END),
+		d,
+		e = keyNew("user/e", KEY_END),
+		KS_END);
+	keyIncRef(b);
+
+	succeed_if(keyGetRef(d) == 2, "wrong reference of d");
+	succeed_if(ksAppend(ks, toAppend) == 5, "wrong size after merge");
+	succeed_if(ksAtCursor(ks, 0) == a, "a not first");
+	succeed_if(ksAtCursor(ks, 1) == bb, "b not replaced");
+	succeed_if(ksAtCursor(ks, 2) == c, "c not merged");
+	succeed_if(ksAtCursor(ks, 3) == d, "d not kept");
+	succeed_if(ksAtCursor(ks, 4) == e, "e not appended");
+	succeed_if(ksCurrent(ks) == e, "cursor not at last appended key");
+	succeed_if(keyGetRef(b) == 1, "replaced key still referenced");
+	succeed_if(keyGetRef(bb) == 2, "new key not referenced twice");
+	succeed_if(keyGetRef(d) == 2, "same key referenced more often");
+	succeed_if(keyGetRef(e) == 2, "new key not referenced twice");
+	succeed_if(ksLookupByName(ks, "user/c", 0) == c, "could not lookup merged key");
+	keyDecRef(b);
+	keyDel(b);
+
+	// merge in front with replacement of the last key
+	KeySet *front = ksNew(10,
+		keyNew("user/0", KEY_END),
+		dd = keyNew("user/e", KEY_END),
+		KS_END);
+	succeed_if(ksAppend(ks, front) == 6, "wrong size after merge in front");
+	succeed_if(ksHead(ks) != a, "front key not first");
+	succeed_if(ksTail(ks) == dd, "last key not replaced");
+	succeed_if(keyGetRef(e) == 1, "replaced key still referenced");
+	ksDel(front);
+
+	// appending to itself does not change anything
+	succeed_if(ksAppend(ks, ks) == 6, "wrong size after self append");
+
+	ksDel(toAppend);
+	ksDel(ks);
+}
+
+static void test_appendUnsorted()
+{
+	printf ("test append unsorted\n");
+	char name[64];
+	const int size = 1000;
+	Key *first, *last, *shared;
+	KeySet *ks = ksNew(0, KS_END);
+
+	// keys in order stay sorted
+	elektraKsAppendUnsorted(ks, keyNew("user/a", KEY_END));
+	elektraKsAppendUnsorted(ks, keyNew("user/b", KEY_END));
+	succeed_if(!(ks->flags & KS_FLAG_UNSORTED), "keyset should be sorted");
+
+	for (int i=size-1; i>=0; --i)
+	{
+		snprintf(name, sizeof(name), "user/unsorted/%d", (i*7)%size);
+		Key *k = keyNew(name, KEY_VALUE, "first", KEY_END);
+		succeed_if(elektraKsAppendUnsorted(ks, k) == size-i+2,
+			"wrong size after append unsorted");
+		succeed_if(ksCurrent(ks) == k, "cursor not on appended key");
+	}
+	succeed_if(ks->flags & KS_FLAG_UNSORTED, "keyset should be unsorted");
+
+	// lookups do not need to sort
+	first = ksLookupByName(ks, "user/unsorted/7", 0);
+	succeed_if(first != 0, "did not find unsorted key");
+	succeed_if(ksCurrent(ks) == first, "cursor not on found key");
+	succeed_if(ks->flags & KS_FLAG_UNSORTED, "lookup sorted keyset");
+
+	// the last one wins
+	elektraKsAppendUnsorted(ks, last = keyNew("user/unsorted/7",
+		KEY_VALUE, "last", KEY_END));
+	succeed_if(ksLookupByName(ks, "user/unsorted/7", 0) == last,
+		"did not find last key");
+	shared = keyNew("user/shared", KEY_END);
+	elektraKsAppendUnsorted(ks, shared);
+	elektraKsAppendUnsorted(ks, keyNew("user/0", KEY_END));
+	elektraKsAppendUnsorted(ks, shared);
+	succeed_if(keyGetRef(shared) == 2, "reference not incremented");
+	succeed_if(ksGetSize(ks) == size+6, "wrong size before sort");
+
+	keyIncRef(first);
+	ksLookup(ks, last, 0);
+	succeed_if(elektraKsSort(ks) == size+4, "wrong size after sort");
+	succeed_if(!(ks->flags & KS_FLAG_UNSORTED), "keyset should be sorted");
+	succeed_if(keyGetRef(first) == 1, "replaced key still referenced");
+	succeed_if(keyGetRef(shared) == 1, "same key referenced twice");
+	succeed_if(ksCurrent(ks) == last, "cursor not on same key");
+	keyDecRef(first);
+	keyDel(first);
+
+	Key *cur;
+	Key *prev = 0;
+	ksRewind(ks);
+	while ((cur = ksNext(ks)) != 0)
+	{
+		if (prev) succeed_if(keyCmp(prev, cur) < 0, "not sorted");
+		prev = cur;
+	}
+	succeed_if_same_string(keyName(ksHead(ks)), "user/0");
+	succeed_if(ksLookupByName(ks, "user/unsorted/7", 0) == last,
+		"did not find last key after sort");
+	for (int i=0; i<size; ++i)
+	{
+		snprintf(name, sizeof(name), "user/unsorted/%d", i);
+		succeed_if(ksLookupByName(ks, name, KDB_O_NOCASE) != 0,
+			"did not find key after sort");
+	}
+
+	// popping removes all keys with the same name
+	elektraKsAppendUnsorted(ks, keyNew("user/dup", KEY_VALUE, "old", KEY_END));
+	elektraKsAppendUnsorted(ks, keyNew("user/dup", KEY_VALUE, "new", KEY_END));
+	succeed_if(ks->flags & KS_FLAG_UNSORTED, "keyset should be unsorted");
+	cur = ksLookupByName(ks, "user/dup", KDB_O_POP);
+	exit_if_fail(cur, "could not pop unsorted key");
+	succeed_if_same_string(keyString(cur), "new");
+	keyDel(cur);
+	succeed_if(ksLookupByName(ks, "user/dup", 0) == 0, "overwritten key still in keyset");
+	succeed_if(ksGetSize(ks) == size+4, "wrong size after pop");
+
+	// other operations sort implicitly
+	elektraKsAppendUnsorted(ks, keyNew("user/1", KEY_END));
+	ksAppendKey(ks, keyNew("user/zzz", KEY_END));
+	succeed_if(!(ks->flags & KS_FLAG_UNSORTED), "keyset should be sorted");
+	succeed_if_same_string(keyName(ksAtCursor(ks, 1)), "user/1");
+	succeed_if_same_string(keyName(ksTail(ks)), "user/zzz");
+
+	ksDel(ks);
+}
+
+static void test_arena()
+{
+	printf ("Test arena\n");
+
+	KeySet *heap = ksNew(0, KS_END);
+	Key *k = elektraKsNewKey(heap, "user/heap", KEY_VALUE, "value", KEY_END);
+	succeed_if(k->arena == 0, "key should be allocated on the heap");
+	succeed_if_same_string(keyString(k), "value");
+	ksAppendKey(heap, k);
+	ksDel(heap);
+
+	KeySet *ks = ksNew(0, KS_END);
+	succeed_if(elektraKsEnableArena(ks) == 0, "could not enable arena");
+	succeed_if(ks->arena == 0, "arena should only be created on demand");
+
+	char name[64];
+	char value[64];
+	const int size = 2000;
+	for (int i=0; i<size; ++i)
+	{
+		snprintf(name, sizeof(name), "user/arena/%d", i);
+		snprintf(value, sizeof(value), "value of arena key %d", i);
+		k = elektraKsNewKey(ks, name, KEY_VALUE, value, KEY_META, "m", "x", KEY_END);
+		exit_if_fail(k, "could not create key");
+		succeed_if(k->arena == ks->arena, "key should be in the arena");
+		succeed_if(k->flags & KEY_FLAG_ARENA_NAME, "name should be in the arena");
+		succeed_if(k->flags & KEY_FLAG_ARENA_VALUE, "value should be in the arena");
+		elektraKsAppendUnsorted(ks, k);
+	}
+	elektraKsSort(ks);
+	succeed_if(ksGetSize(ks) == size, "wrong size");
+	succeed_if(ks->arena->references == size+1, "wrong number of references");
+
+	// keys can be modified and deleted
+	k = elektraKsNewKey(ks, 0);
+	keySetName(k, "user/arena");
+	keyAddBaseName(k, "modified");
+	keyAddName(k, "more/levels");
+	keySetString(k, "a longer value than before");
+	succeed_if_same_string(keyName(k), "user/arena/modified/more/levels");
+	succeed_if_same_string(keyString(k), "a longer value than before");
+	keySetString(k, 0);
+	keyDel(k);
+
+	// array elements are allocated from the arena, too
+	ssize_t next = -1;
+	Key *arrayParent = keyNew("user/arena/array", KEY_END);
+	k = elektraArrayAppend(ks, arrayParent, &next);
+	exit_if_fail(k, "could not append array element");
+	succeed_if_same_string(keyName(k), "user/arena/array/#0");
+	succeed_if(k->arena == ks->arena, "array element should be in the arena");
+	succeed_if(k->flags & KEY_FLAG_ARENA_NAME, "name should be in the arena");
+	keyDel(ksLookup(ks, k, KDB_O_POP));
+	keyDel(arrayParent);
+
+	Key *dup = keyDup(ksLookupByName(ks, "user/arena/7", 0));
+	succeed_if(dup->arena == 0, "duplicate should be allocated on the heap");
+	succeed_if(!(dup->flags & (KEY_FLAG_ARENA_NAME|KEY_FLAG_ARENA_VALUE)),
+		"duplicate should not use the arena");
+	succeed_if_same_string(keyString(dup), "value of arena key 7");
+
+	// keys escaping the keyset keep the arena alive
+	KeySet *other = ksNew(0, KS_END);
+	ksAppendKey(other, ksLookupByName(ks, "user/arena/42", 0));
+	Key *kept = ksLookupByName(ks, "user/arena/43", 0);
+	keyIncRef(kept);
+	ksDel(ks);
+
+	succeed_if_same_string(keyName(kept), "user/arena/43");
+	succeed_if_same_string(keyString(kept), "value of arena key 43");
+	succeed_if_same_string(keyValue(keyGetMeta(kept, "m")), "x");
+	keySetString(kept, "a longer value which is copied to the heap");
+	succeed_if(!(kept->flags & KEY_FLAG_ARENA_VALUE), "value should be on the heap");
+	succeed_if_same_string(keyString(kept), "a longer value which is copied to the heap");
+	keyDecRef(kept);
+	keyDel(kept);
+
+	k = ksLookupByName(other, "user/arena/42", 0);
+	exit_if_fail(k, "escaped key not found");
+	succeed_if_same_string(keyString(k), "value of arena key 42");
+	ksDel(other);
+
+	keyDel(dup);
+}
+
+static void freezeDupJob(void *data, size_t job)
+{
+	KeySet *ks = data;
+	Key *dup = keyDup(ks->array[job]);
+	succeed_if(dup && keySetString(dup, "changed") > 0, "duplicate can not be changed");
+	keyDel(dup);
+}
+
+#define FREEZE_META_JOBS 8
+static int freezeMetaFound[FREEZE_META_JOBS];
+
+static void freezeMetaJob(void *data, size_t job)
+{
+	const Key *k = data;
+	for (int i=0; i<1000; ++i)
+	{
+		const Key *m = keyGetMeta(k, "m");
+		if (m && !strcmp(keyString(m), "x")) ++ freezeMetaFound[job];
+	}
+}
+
+static void test_freeze()
+{
+	printf ("test freeze\n");
+
+	const size_t size = 100;
+	KeySet *ks = ksNew(0, KS_END);
+	Key *old = keyNew("user/freeze/old", KEY_VALUE, "a value which is stored outside", KEY_END);
+	keyIncRef(old);
+	ksAppendKey(ks, old);
+	ksAppendKey(ks, keyNew("system/freeze/meta", KEY_META, "m", "x", KEY_END));
+	for (size_t i=0; i<size; ++i)
+	{
+		char name[64];
+		char value[64];
+		snprintf(name, sizeof(name), "user/freeze/%zu", i);
+		snprintf(value, sizeof(value), "value of frozen key %zu", i);
+		ksAppendKey(ks, keyNew(name, KEY_VALUE, value, KEY_END));
+	}
+	ksAppendKey(ks, keyNew("user/freeze/binary", KEY_BINARY, KEY_SIZE, 3, KEY_VALUE, "ab", KEY_END));
+	ksRewind(ks);
+	ksNext(ks);
+	ksNext(ks);
+	Key *cur = ksCurrent(ks);
+
+	succeed_if(elektraKsFreeze(0) == -1, "NULL not rejected");
+	succeed_if(elektraKsFreeze(ks) == 1, "could not freeze");
+	succeed_if(ksCurrent(ks) != cur, "cursor still points to the old key");
+	succeed_if(ksGetCursor(ks) == 1, "cursor moved");
+	succeed_if(elektraKsFreeze(ks) == 0, "second freeze should do nothing");
+	succeed_if(ksGetSize(ks) == size+3, "wrong size");
+	succeed_if(ks->hashTable != 0, "hash index should be built");
+	succeed_if(ks->flags & KS_FLAG_RANGES, "ranges should be built");
+
+	// keys are copies, laid out one after the other
+	succeed_if(ksLookupByName(ks, "user/freeze/old", 0) != old, "key was not replaced");
+	succeed_if(old->ksReference == 1, "old key still referenced by keyset");
+	succeed_if_same_string(keyString(old), "a value which is stored outside");
+	keyDecRef(old);
+	keyDel(old);
+	for (ssize_t i=1; i<ksGetSize(ks); ++i)
+	{
+		succeed_if((char*)ks->array[i-1] < (char*)ks->array[i], "keys not contiguous");
+	}
+
+	Key *k = ksLookupByName(ks, "user/freeze/42", 0);
+	exit_if_fail(k, "key not found");
+	succeed_if_same_string(keyString(k), "value of frozen key 42");
+	succeed_if(k->flags & KEY_FLAG_ARENA_NAME, "name not in the block");
+	succeed_if(k->flags & KEY_FLAG_ARENA_VALUE, "value not in the block");
+	succeed_if(elektraKsLookupByNameConst(ks, "/freeze/42", 0) == k, "const lookup failed");
+	succeed_if_same_string(keyString(keyGetMeta(ksLookupByName(ks, "system/freeze/meta", 0), "m")), "x");
+
+	// meta keys are copied into the block and read without changes
+	k = ksLookupByName(ks, "system/freeze/meta", 0);
+	const Key *m = keyGetMeta(k, "m");
+	succeed_if(m && m->arena == k->arena && (m->flags & KEY_FLAG_ARENA_NAME), "meta key not in the block");
+	succeed_if(m && keyGetRef(m) == 1, "meta key shared with the old key");
+	keyRewindMeta(k);
+	succeed_if(keyGetMeta(k, "m") == m && keyCurrentMeta(k) == 0, "keyGetMeta moved the meta cursor");
+	elektraParallelRun(4, FREEZE_META_JOBS, freezeMetaJob, k);
+	for (size_t i=0; i<FREEZE_META_JOBS; ++i)
+	{
+		succeed_if(freezeMetaFound[i] == 1000, "meta key not found by thread");
+	}
+	k = ksLookupByName(ks, "user/freeze/binary", 0);
+	succeed_if(keyIsBinary(k) && keyGetValueSize(k) == 3, "binary value lost");
+	succeed_if(keyNeedSync(k) == 1, "sync flag lost");
+
+	size_t count = 0;
+	ksRewind(ks);
+	while ((k = ksNext(ks)) != 0) ++count;
+	succeed_if(count == size+3, "iteration failed");
+
+	// nothing can be changed
+	k = ksLookupByName(ks, "user/freeze/42", 0);
+	succeed_if(keySetString(k, "changed") == -1, "value could be changed");
+	succeed_if(keySetName(k, "user/changed") == -1, "name could be changed");
+	succeed_if(keySetMeta(k, "m", "y") == -1, "meta could be changed");
+	succeed_if(ksAppendKey(ks, keyNew("user/freeze/new", KEY_END)) == -1, "key appended");
+	succeed_if(elektraKsAppendUnsorted(ks, keyNew("user/freeze/new", KEY_END)) == -1, "key appended unsorted");
+	KeySet *other = ksNew(1, keyNew("user/freeze/other", KEY_END), KS_END);
+	succeed_if(ksAppend(ks, other) == -1, "keyset appended");
+	succeed_if(ksCopy(ks, other) == -1, "keyset copied");
+	succeed_if(ksClear(ks) == -1, "keyset cleared");
+	ksDel(other);
+	succeed_if(ksPop(ks) == 0, "key popped");
+	succeed_if(ksPopAtCursor(ks, 0) == 0, "key popped at cursor");
+	succeed_if(ksLookupByName(ks, "user/freeze/42", KDB_O_POP) == 0, "key popped by lookup");
+	Key *cutpoint = keyNew("user/freeze", KEY_END);
+	succeed_if(ksCut(ks, cutpoint) == 0, "keyset cut");
+	keyDel(cutpoint);
+	succeed_if(ksLookupByName(ks, "user/freeze/new", KDB_O_CREATE) == 0, "key created");
+	succeed_if(ksGetSize(ks) == size+3, "size changed");
+
+	// duplicates can be changed again and keys outlive the keyset
+	Key *dup = keyDup(ksLookupByName(ks, "user/freeze/42", 0));
+	succeed_if(keySetString(dup, "changed") > 0, "duplicate can not be changed");
+	keyDel(dup);
+
+	// copying frozen keys does not write to them, so threads can do it
+	k = ksLookupByName(ks, "system/freeze/meta", 0);
+	const keyflag_t flags = k->flags;
+	const Key *metaKey = keyGetMeta(k, "m");
+	const ssize_t metaRef = keyGetRef(metaKey);
+	dup = keyDup(k);
+	succeed_if(k->flags == flags, "flags of frozen key changed");
+	succeed_if(!k->sharedName && !k->value.shared, "frozen key prepared for sharing");
+	succeed_if(keyGetRef(metaKey) == metaRef, "meta key of frozen key referenced");
+	succeed_if_same_string(keyName(dup), "system/freeze/meta");
+	succeed_if_same_string(keyString(keyGetMeta(dup, "m")), "x");
+	succeed_if(keySetMeta(dup, "m", "y") > 0, "meta of duplicate can not be changed");
+	succeed_if_same_string(keyString(metaKey), "x");
+	keyDel(dup);
+	elektraParallelRun(4, ksGetSize(ks), freezeDupJob, ks);
+	KeySet *copy = ksDup(ks);
+	succeed_if(ksAppendKey(copy, keyNew("user/freeze/new", KEY_END)) > 0, "duplicated keyset is frozen");
+	ksDel(copy);
+	k = ksLookupByName(ks, "user/freeze/7", 0);
+	keyIncRef(k);
+	ksDel(ks);
+	succeed_if_same_string(keyString(k), "value of frozen key 7");
+	keyDecRef(k);
+	keyDel(k);
+}
+
+static void checkSortKeys(KeySet *ks)
+{
+	exit_if_fail(ks->flags & KS_FLAG_SORTKEYS, "sort keys not built");
+
+	const Key *first = ks->array[0];
+	for (size_t i=0; i<ks->size; ++i)
+	{
+		const Key *k = ks->array[i];
+		const unsigned char *name = (const unsigned char *)k->key + k->keySize;
+		kdb_unsigned_long_long_t expected = 0;
+		for (size_t j=ks->sortOffset; j<ks->sortOffset+8; ++j)
+		{
+			expected <<= 8;
+			if (j < k->keyUSize) expected |= name[j];
+		}
+		succeed_if(ks->sortKeys[i] == expected, "wrong sort key");
+		succeed_if(!memcmp(name, first->key + first->keySize, ks->sortOffset),
+			"name does not start with the shared prefix");
+	}
+}
+
+static void test_sortKeys()
+{
+	printf ("test sort keys\n");
+
+	char name[64];
+	KeySet *ks = ksNew(0, KS_END);
+	for (int i=0; i<100; i+=2)
+	{
+		snprintf(name, sizeof(name), "user/sort/key%03d", i);
+		ksAppendKey(ks, keyNew(name, KEY_END));
+	}
+	succeed_if(!(ks->flags & KS_FLAG_SORTKEYS), "sort keys built for small keyset");
+	for (int i=99; i>0; i-=2)
+	{
+		snprintf(name, sizeof(name), "user/sort/key%03d", i);
+		ksAppendKey(ks, keyNew(name, KEY_END));
+	}
+	checkSortKeys(ks);
+	succeed_if(ks->sortOffset == sizeof("user/sort/key0")-1, "wrong shared prefix");
+
+	// keys with the shared prefix keep them up to date
+	ksAppendKey(ks, keyNew("user/sort/key050/below", KEY_END));
+	ksAppendKey(ks, keyNew("user/sort/key0", KEY_END));
+	ksAppendKey(ks, keyNew("user/sort/key099/end", KEY_END));
+	ksAppendKey(ks, keyNew("user/sort/key042", KEY_VALUE, "replaced", KEY_END));
+	checkSortKeys(ks);
+	for (int i=0; i<100; ++i)
+	{
+		snprintf(name, sizeof(name), "user/sort/key%03d", i);
+		Key *k = ksLookupByName(ks, name, 0);
+		succeed_if(k && !strcmp(keyName(k), name), "key not found");
+	}
+	succeed_if(ksLookupByName(ks, "user/sort/key050/below", 0) != 0, "inserted key not found");
+	succeed_if(ksLookupByName(ks, "user/sort/key0", 0) != 0, "shortest key not found");
+	succeed_if(ksLookupByName(ks, "user/sort/key0500", 0) == 0, "missing key found");
+	succeed_if(ksLookupByName(ks, "user/sort", 0) == 0, "missing key without prefix found");
+	succeed_if(ksLookupByName(ks, "system/sort/key001", 0) == 0, "key of other namespace found");
+	succeed_if_same_string(keyString(ksLookupByName(ks, "/sort/key042", 0)), "replaced");
+
+	// other keys drop them, lookups build them again
+	ksAppendKey(ks, keyNew("system/sort", KEY_END));
+	succeed_if(!(ks->flags & KS_FLAG_SORTKEYS), "sort keys not dropped");
+	ksAppendKey(ks, keyNew("user/sort/key077/x", KEY_END));
+	checkSortKeys(ks);
+	succeed_if(ks->sortOffset == 0, "prefix should be empty");
+	succeed_if(ksLookupByName(ks, "user/sort/key077/x", 0) != 0, "key not found");
+	succeed_if(ksLookupByName(ks, "system/sort", 0) != 0, "key not found");
+
+	// popping keeps them
+	Key *k = ksPop(ks);
+	succeed_if_same_string(keyName(k), "user/sort/key099/end");
+	keyDel(k);
+	checkSortKeys(ks);
+	k = ksLookupByName(ks, "user/sort/key010", KDB_O_POP);
+	keyDel(k);
+	succeed_if(ksLookupByName(ks, "user/sort/key010", 0) == 0, "popped key found");
+	succeed_if(ksLookupByName(ks, "user/sort/key011", 0) != 0, "key not found");
+
+	// cutting keeps them
+	checkSortKeys(ks);
+	Key *cutpoint = keyNew("user/sort/key050", KEY_END);
+	KeySet *cut = ksCut(ks, cutpoint);
+	succeed_if(ksGetSize(cut) == 2, "wrong number of keys cut");
+	checkSortKeys(ks);
+	succeed_if(ksLookupByName(ks, "user/sort/key051", 0) != 0, "key not found");
+	ksDel(cut);
+	keyDel(cutpoint);
+
+	ksDel(ks);
+}
+
+static void test_below()
+{
+	printf ("test below\n");
+
+	const char *names[] = {"/below", "/below/x", "dir/below", "system/below", "system/below/a",
+		"user", "user/below", "user/below/a", "user/below/a/b", "user/below/a\\/b",
+		"user/below/a\\\\", "user/below/a\\\\/c", "user/below/ab", "user/below/a%",
+		"user/below/a/%", "user/below/b", "user/belowb", "user/below\\/a", 0};
+	const char *parents[] = {"user/below", "user/below/a", "user/below/a\\\\", "user/below/a/%",
+		"user", "system/below", "/below", "dir", "spec/below", "user/below/c", "user/belo",
+		"user/below/a/b/c", 0};
+
+	for (int large=0; large<2; ++large)
+	{
+		KeySet *ks = ksNew(0, KS_END);
+		for (size_t i=0; names[i]; ++i) ksAppendKey(ks, keyNew(names[i], KEY_CASCADING_NAME, KEY_END));
+		for (int i=0; large && i<100; ++i)
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "user/below/many/%d", i);
+			ksAppendKey(ks, keyNew(name, KEY_END));
+		}
+
+		for (size_t p=0; parents[p]; ++p)
+		{
+			Key *parent = keyNew(parents[p], KEY_CASCADING_NAME, KEY_END);
+			Key *k = 0;
+			KeySet *expected = ksNew(0, KS_END);
+			ksRewind(ks);
+			while ((k = ksNext(ks)) != 0)
+			{
+				if (keyIsBelowOrSame(parent, k)) ksAppendKey(expected, k);
+			}
+
+			cursor_t begin = 0, end = 0;
+			succeed_if(elektraKsBelow(ks, parent, &begin, &end) == ksGetSize(expected), "wrong number of keys");
+			succeed_if(end - begin == ksGetSize(expected), "wrong range");
+			ksRewind(expected);
+			for (cursor_t it=begin; it<end; ++it)
+			{
+				succeed_if(ksAtCursor(ks, it) == ksNext(expected), "wrong key in view");
+				succeed_if(ksAtCursor(ks, it)->ksReference == 2, "reference counter changed");
+			}
+
+			if (parents[p][0] != '/')
+			{
+				// ksCut() cuts the same keys
+				KeySet *dup = ksDup(ks);
+				KeySet *cut = ksCut(dup, parent);
+				if (ksGetSize(expected) > 0) compare_keyset(cut, expected);
+				succeed_if(ksGetSize(cut) == ksGetSize(expected), "wrong number of keys cut");
+				succeed_if(ksGetSize(dup) + ksGetSize(cut) == ksGetSize(ks), "keys lost");
+				ksRewind(dup);
+				while ((k = ksNext(dup)) != 0)
+				{
+					succeed_if(!keyIsBelowOrSame(parent, k), "key not cut");
+				}
+				ksDel(cut);
+				ksDel(dup);
+			}
+
+			ksDel(expected);
+			keyDel(parent);
+		}
+
+		cursor_t begin, end;
+		Key *root = keyNew("/", KEY_CASCADING_NAME, KEY_END);
+		succeed_if(elektraKsBelow(ks, root, &begin, &end) == -1, "root should be rejected");
+		keyDel(root);
+		succeed_if(elektraKsBelow(ks, 0, &begin, &end) == -1, "NULL should be rejected");
+		ksDel(ks);
+	}
+}
+
+static void checkValueLookups(KeySet *ks, const char *value, int expected)
+{
+	Key *k = 0;
+	Key *first = 0;
+	Key *last = 0;
+	int found = 0;
+
+	ksRewind(ks);
+	while ((k = ksLookupByString(ks, value, KDB_O_NOALL)) != 0)
+	{
+		succeed_if_same_string(keyString(k), value);
+		succeed_if(ksCurrent(ks) == k, "cursor not set");
+		succeed_if(!last || keyCmp(last, k) < 0, "matches not in order");
+		if (!first) first = k;
+		last = k;
+		++found;
+	}
+	succeed_if(found == expected, "wrong number of matches");
+	succeed_if(ksCurrent(ks) == 0, "cursor not at end");
+
+	succeed_if(ksLookupByString(ks, value, 0) == first, "did not find first match");
+	succeed_if(ksGetCursor(ks) == -1, "cursor not restored");
+}
+
+static void test_valueLookup()
+{
+	printf ("test value lookup\n");
+	char name[64];
+	char value[64];
+	const int size = 200;
+	KeySet *ks = ksNew(0, KS_END);
+
+	for (int i=0; i<size; ++i)
+	{
+		snprintf(name, sizeof(name), "user/value/%d/%02d", i/100, i%100);
+		snprintf(value, sizeof(value), "host%d", i%10);
+		ksAppendKey(ks, keyNew(name, KEY_VALUE, value, KEY_END));
+	}
+	ksAppendKey(ks, keyNew("user/value/bin", KEY_BINARY, KEY_SIZE, 4,
+		KEY_VALUE, "ho\0t", KEY_END));
+	ksAppendKey(ks, keyNew("user/value/empty", KEY_END));
+	ksAppendKey(ks, keyNew("user/value/null", KEY_BINARY, KEY_END));
+
+	checkValueLookups(ks, "host3", size/10);
+	checkValueLookups(ks, "host", 0);
+	checkValueLookups(ks, "", 1);
+
+	Key *found = ksLookupByString(ks, "host3", 0);
+	succeed_if(ksGetCursor(ks) == -1, "cursor not restored");
+	succeed_if_same_string(keyName(found), "user/value/0/03");
+	found = ksLookupByString(ks, "HOST3", KDB_O_NOCASE);
+	succeed_if(found && !strcmp(keyName(found), "user/value/0/03"), "nocase lookup failed");
+
+	// binary keys are only found by binary lookups
+	succeed_if(ksLookupByString(ks, "ho", 0) == 0, "found binary key");
+	found = ksLookupByBinary(ks, "ho\0t", 4, 0);
+	succeed_if(found && !strcmp(keyName(found), "user/value/bin"), "binary lookup failed");
+	succeed_if(ksLookupByBinary(ks, "ho\0x", 4, 0) == 0, "found wrong binary value");
+	succeed_if(ksLookupByBinary(ks, "ho", 2, 0) == 0, "found prefix of binary value");
+	found = ksLookupByBinary(ks, 0, 0, 0);
+	succeed_if(found && !strcmp(keyName(found), "user/value/null"), "null lookup failed");
+
+	// changed values are found
+	keySetString(ksLookupByName(ks, "user/value/0/13", 0), "host4");
+	checkValueLookups(ks, "host3", size/10-1);
+	checkValueLookups(ks, "host4", size/10+1);
+	keySetString(ksLookupByName(ks, "user/value/0/13", 0), "other");
+	checkValueLookups(ks, "other", 1);
+	keySetString(ksLookupByName(ks, "user/value/0/13", 0), "");
+	checkValueLookups(ks, "other", 0);
+	checkValueLookups(ks, "", 2);
+
+	// added and removed keys are found
+	checkValueLookups(ks, "host5", size/10);
+	ksAppendKey(ks, keyNew("user/value/a", KEY_VALUE, "host5", KEY_END));
+	checkValueLookups(ks, "host5", size/10+1);
+	ksAppendKey(ks, keyNew("user/value/0/00", KEY_VALUE, "host6", KEY_END));
+	checkValueLookups(ks, "host5", size/10+1);
+	checkValueLookups(ks, "host0", size/10-1);
+	checkValueLookups(ks, "host6", size/10+1);
+	Key *cutpoint = keyNew("user/value/1", KEY_END);
+	KeySet *cut = ksCut(ks, cutpoint);
+	checkValueLookups(ks, "host5", size/10+1-10);
+	checkValueLookups(cut, "host5", 10);
+	ksDel(cut);
+	keyDel(cutpoint);
+
+	elektraKsFreeze(ks);
+	checkValueLookups(ks, "host5", size/10+1-10);
+
+	ksDel(ks);
+}
+
+static void test_batchLookup()
+{
+	printf ("test batch lookup\n");
+	char name[64];
+	const int size = 300;
+	KeySet *ks = ksNew(0, KS_END);
+
+	for (int i=0; i<size; ++i)
+	{
+		snprintf(name, sizeof(name), "user/batch/%d", i*2);
+		ksAppendKey(ks, keyNew(name, KEY_END));
+	}
+	for (int i=0; i<size*10; ++i)
+	{
+		snprintf(name, sizeof(name), "user/other/%d", i);
+		elektraKsAppendUnsorted(ks, keyNew(name, KEY_END));
+	}
+	ksAppendKey(ks, keyNew("system/batch/1", KEY_END));
+	ksAppendKey(ks, keyNew("system/batch/only", KEY_END));
+	ksAppendKey(ks, keyNew("user/batch/a\\/b", KEY_END));
+	ksAppendKey(ks, keyNew("dir/batch/only", KEY_END));
+
+	const char *names[] = {"user/batch/598", "user/batch/1", "user/batch/0",
+		"user/batch/598", "/batch/only", "/batch/1", "/batch/missing",
+		"user//batch///4", "user/batch/a\\/b", "user/batch/a/b", 0,
+		"system/batch/1", "user/batch/600", "spec/batch/0", "user/batch/17",
+		"user:owner/batch/2", "user", "invalid", "user/batch/298/.."};
+	const size_t count = sizeof(names)/sizeof(names[0]);
+	Key *found[sizeof(names)/sizeof(names[0])];
+
+	ssize_t expected = 0;
+	for (size_t i=0; i<count; ++i)
+	{
+		if (names[i] && ksLookupByName(ks, names[i], 0)) ++ expected;
+	}
+	Key *current = ksLookupByName(ks, "user/batch/10", 0);
+
+	ksClearHashIndex(ks);
+	succeed_if(elektraKsLookupNames(ks, names, count, found) == expected,
+		"wrong number of keys found");
+	succeed_if(ks->hashTable == 0, "small batch did not merge");
+	succeed_if(ksCurrent(ks) == current, "cursor moved");
+	for (size_t i=0; i<count; ++i)
+	{
+		Key *lookup = names[i] ? ksLookupByName(ks, names[i], 0) : 0;
+		succeed_if(found[i] == lookup, "batch lookup differs from ksLookupByName");
+	}
+	succeed_if(found[0] && !strcmp(keyName(found[0]), "user/batch/598"),
+		"did not find key");
+	succeed_if(found[4] && !strcmp(keyName(found[4]), "dir/batch/only"),
+		"did not find cascading key");
+
+	// every key of the keyset
+	KeySet *wanted = ksDup(ks);
+	ksAppendKey(wanted, keyNew("user/batch/3", KEY_END));
+	ksAppendKey(wanted, keyNew("/batch/1", KEY_CASCADING_NAME, KEY_END));
+	Key **foundKeys = elektraMalloc(sizeof(Key *) * ksGetSize(wanted));
+	succeed_if(elektraKsLookupKeys(ks, wanted, foundKeys) == ksGetSize(ks) + 1,
+		"wrong number of keys found");
+	succeed_if(ks->hashTable != 0, "large batch did not use the hash index");
+	Key *k = 0;
+	ksRewind(wanted);
+	for (size_t i=0; (k = ksNext(wanted)) != 0; ++i)
+	{
+		succeed_if(foundKeys[i] == ksLookup(ks, k, 0), "batch lookup differs from ksLookup");
+	}
+	elektraFree(foundKeys);
+	ksDel(wanted);
+
+	ksClearHashIndex(ks);
+	wanted = ksNew(3, keyNew("user/batch/4", KEY_END), keyNew("user/other/7", KEY_END),
+		keyNew("user/other/x", KEY_END), KS_END);
+	succeed_if(elektraKsLookupKeys(ks, wanted, found) == 2, "wrong number of keys found");
+	succeed_if(ks->hashTable == 0, "small batch did not merge");
+	succeed_if(found[0] == ksLookupByName(ks, "user/batch/4", 0), "did not find key");
+	succeed_if(found[1] == ksLookupByName(ks, "user/other/7", 0), "did not find key");
+	succeed_if(found[2] == 0, "found missing key");
+	ksDel(wanted);
+
+	// no keys at all
+	succeed_if(elektraKsLookupNames(ks, names, 0, found) == 0, "found keys");
+	KeySet *empty = ksNew(0, KS_END);
+	succeed_if(elektraKsLookupNames(empty, names, count, found) == 0, "found keys in empty keyset");
+	for (size_t i=0; i<count; ++i) succeed_if(found[i] == 0, "found key in empty keyset");
+	succeed_if(elektraKsLookupNames(0, names, count, found) == -1, "no error on null keyset");
+	succeed_if(elektraKsLookupKeys(ks, 0, found) == -1, "no error on null keyset");
+	ksDel(empty);
+
+	ksDel(ks);
+}
+
+static void test_stackLookup()
+{
+	printf ("test lookup by names built on the stack\n");
+
+	// longer than the stack buffer, it has to go to the heap
+	char longName[KEY_STACK_ARENA_SIZE * 3];
+	strcpy(longName, "user/stack");
+	for (size_t i=strlen(longName); i<sizeof(longName)-3; i+=2) strcpy(longName+i, "/x");
+
+	Key *key, *longKey, *esc;
+	KeySet *ks = ksNew (10,
+		key = keyNew("user/stack/key", KEY_END),
+		longKey = keyNew(longName, KEY_END),
+		esc = keyNew("system/stack/with\\/slash/\\.", KEY_END),
+		KS_END);
+
+	succeed_if(ksLookupByName(ks, "user/stack/key", 0) == key, "key not found");
+	succeed_if(ksLookupByName(ks, "user//stack/./other/../key/", 0) == key, "non-canonical name not found");
+	succeed_if(ksLookupByName(ks, "user:owner/stack/key", 0) == key, "name with owner not found");
+	succeed_if(ksLookupByName(ks, longName, 0) == longKey, "long name not found");
+	succeed_if(ksLookupByName(ks, longName+sizeof("user")-1, 0) == longKey, "long cascading name not found");
+	succeed_if(ksLookupByName(ks, "/stack/with\\/slash/\\.", 0) == esc, "escaped name not found");
+	succeed_if(ksLookupByName(ks, "user/stack/key\\", 0) == 0, "invalid name found");
+	succeed_if(elektraKsLookupByNameConst(ks, longName, 0) == longKey, "long name not found");
+	succeed_if(elektraKsLookupByNameConst(ks, "/stack/key", 0) == key, "cascading name not found");
+
+	// the created key must not use the name of the lookup key
+	Key *created = ksLookupByName(ks, "user/stack/created", KDB_O_CREATE);
+	succeed_if(created != 0, "key not created");
+	succeed_if_same_string(keyName(created), "user/stack/created");
+	succeed_if(ksLookupByName(ks, "user/stack/created", 0) == created, "created key not found");
+
+	// the lookup key is not deleted
+	succeed_if(ksLookupByName(ks, "user/stack/key", KDB_O_DEL) == key, "key not found");
+	succeed_if(ksLookupByName(ks, "user/stack/key", KDB_O_POP) == key, "key not popped");
+	succeed_if(ksLookupByName(ks, "user/stack/key", 0) == 0, "popped key found");
+	keyDel(key);
+
+	ksDel(ks);
+}
+
+static void test_caseLookup()
+{
+	printf ("test lookup ignoring case\n");
+
+	char name[64];
+	KeySet *ks = ksNew (0, KS_END);
+	// '_' is sorted between upper and lower case letters
+	const char *parts[] = {"B", "a", "_x", "C", "b_", "A_", "ab", "Ba"};
+	const size_t count = sizeof(parts)/sizeof(parts[0]);
+	for (size_t i=0; i<count; ++i)
+	{
+		for (int j=0; j<20; ++j)
+		{
+			snprintf(name, sizeof(name), "user/case/%s/%c%d", parts[i], 'a'+j%3, j);
+			ksAppendKey(ks, keyNew(name, KEY_END));
+		}
+	}
+	Key *upper = keyNew("user/case/DUP", KEY_END);
+	Key *lower = keyNew("user/case/dup", KEY_END);
+	ksAppendKey(ks, lower);
+	ksAppendKey(ks, upper);
+	succeed_if(ksGetSize(ks) >= KEYSET_CASE_MIN_SIZE, "keyset too small for the index");
+
+	for (int round=0; round<2; ++round)
+	{
+		for (size_t i=0; i<count; ++i)
+		{
+			for (int j=0; j<20; ++j)
+			{
+				snprintf(name, sizeof(name), "user/case/%s/%c%d", parts[i], 'a'+j%3, j);
+				Key *found = ksLookupByName(ks, name, 0);
+				for (char *c=name; *c; ++c) *c = *c >= 'a' && *c <= 'z' ? *c-'a'+'A' : *c;
+				succeed_if(ksLookupByName(ks, name, KDB_O_NOCASE) == found, "upper case name not found");
+				for (char *c=name; *c; ++c) *c = *c >= 'A' && *c <= 'Z' ? *c-'A'+'a' : *c;
+				succeed_if(ksLookupByName(ks, name, KDB_O_NOCASE) == found, "lower case name not found");
+				succeed_if(elektraKsLookupByNameConst(ks, name, KDB_O_NOCASE) == found, "const lookup failed");
+			}
+		}
+		// like a linear search, the first of both is found
+		succeed_if(ksLookupByName(ks, "user/case/Dup", KDB_O_NOCASE) == upper, "wrong key of same name found");
+		succeed_if(ksLookupByName(ks, "user/case/dup", KDB_O_NOCASE) == upper, "wrong key of same name found");
+		succeed_if(ksLookupByName(ks, "user/case/dup", 0) == lower, "case sensitive lookup failed");
+		succeed_if(ksLookupByName(ks, "user/case/dupe", KDB_O_NOCASE) == 0, "found missing key");
+		succeed_if(ksLookupByName(ks, "user/case", KDB_O_NOCASE) == 0, "found missing key");
+		succeed_if(ksLookupByName(ks, "user/case/b", KDB_O_NOCASE) == 0, "found missing key");
+		succeed_if(ks->caseIndex != 0, "case index not built");
+	}
+
+	// no prefix is shared by all keys anymore
+	Key *sys = keyNew("system/Case/X", KEY_END);
+	ksAppendKey(ks, sys);
+	succeed_if(ks->caseIndex == 0, "case index not dropped");
+	for (int round=0; round<2; ++round)
+	{
+		succeed_if(ksLookupByName(ks, "SYSTEM/case/x", KDB_O_NOCASE) == sys, "system key not found");
+		succeed_if(ksLookupByName(ks, "user/case/DUP", KDB_O_NOCASE) == upper, "user key not found");
+		succeed_if(ksLookupByName(ks, "dir/case/x", KDB_O_NOCASE) == 0, "found missing key");
+	}
+	succeed_if(ks->caseIndex != 0, "case index not built");
+	succeed_if(ks->caseOffset == 0, "prefix shared by user and system");
+
+	// owner is compared exactly
+	Key *owned = keyNew("user:hugo/case/owned", KEY_END);
+	ksAppendKey(ks, owned);
+	succeed_if(ks->caseIndex == 0, "case index not dropped");
+	succeed_if(ksLookupByName(ks, "user:hugo/case/OWNED", KDB_O_NOCASE|KDB_O_WITHOWNER) == owned, "owned key not found");
+	succeed_if(ksLookupByName(ks, "user:hugo/case/Owned", KDB_O_NOCASE|KDB_O_WITHOWNER) == owned, "owned key not found");
+	succeed_if(ks->caseIndex != 0, "case index not built");
+	succeed_if(ksLookupByName(ks, "user:otto/case/owned", KDB_O_NOCASE|KDB_O_WITHOWNER) == 0, "wrong owner found");
+	succeed_if(ksLookupByName(ks, "user:otto/case/owned", KDB_O_NOCASE) == owned, "owner not ignored");
+
+	// popping ignoring case
+	succeed_if(ksLookupByName(ks, "USER/CASE/DUP", KDB_O_NOCASE|KDB_O_POP) == upper, "could not pop key");
+	succeed_if(ks->caseIndex == 0, "case index not dropped");
+	succeed_if(ksLookupByName(ks, "USER/CASE/DUP", KDB_O_NOCASE) == lower, "other key not found");
+	succeed_if(ksLookupByName(ks, "USER/CASE/DUP", KDB_O_NOCASE) == lower, "other key not found");
+	keyDel(upper);
+
+	// small keysets are searched without index
+	KeySet *small = ksNew (3, keyNew("user/Small/b", KEY_END), keyNew("user/small/A", KEY_END), KS_END);
+	for (int round=0; round<2; ++round)
+	{
+		succeed_if(ksLookupByName(small, "user/small/b", KDB_O_NOCASE) == ksLookupByName(small, "user/Small/b", 0), "key not found");
+		succeed_if(ksLookupByName(small, "USER/SMALL/a", KDB_O_NOCASE) == ksLookupByName(small, "user/small/A", 0), "key not found");
+		succeed_if(ksLookupByName(small, "user/small/c", KDB_O_NOCASE) == 0, "found missing key");
+	}
+	succeed_if(small->caseIndex == 0, "case index built for small keyset");
+	ksDel(small);
+
+	ksDel(ks);
+}
+
+static void test_children()
+{
+	printf ("test children and tree iteration\n");
+
+	KeySet *ks = ksNew (20,
+		keyNew("user/tree", KEY_END),
+		keyNew("user/tree/a", KEY_END),
+		keyNew("user/tree/a/x", KEY_END),
+		keyNew("user/tree/a/y", KEY_END),
+		keyNew("user/tree/a/y/z", KEY_END),
+		keyNew("user/tree/b", KEY_END),
+		keyNew("user/tree/c/deep/1", KEY_END),
+		keyNew("user/tree/c/deep/2", KEY_END),
+		keyNew("user/tree/d", KEY_END),
+		keyNew("user/tree/d\\/e", KEY_END),
+		keyNew("user/tree\\/x", KEY_END),
+		keyNew("user/treex", KEY_END),
+		keyNew("system/tree/a", KEY_END),
+		KS_END);
+
+	// compare with keyIsDirectBelow() for every key as parent
+	for (cursor_t p=0; p<ksGetSize(ks); ++p)
+	{
+		Key *parent = ksAtCursor(ks, p);
+		cursor_t end;
+		cursor_t it = elektraKsFirstChild(ks, parent, &end);
+		for (cursor_t i=0; i<ksGetSize(ks); ++i)
+		{
+			Key *cur = ksAtCursor(ks, i);
+			if (keyIsDirectBelow(parent, cur) != 1) continue;
+			succeed_if(it == i, "wrong child");
+			if (it == -1) break;
+			it = elektraKsNextChild(ks, it, end);
+		}
+		succeed_if(it == -1, "too many children");
+
+		const cursor_t subtreeEnd = elektraKsSubtreeEnd(ks, p);
+		for (cursor_t i=0; i<ksGetSize(ks); ++i)
+		{
+			const int below = keyIsBelow(parent, ksAtCursor(ks, i)) == 1;
+			succeed_if(below == (i > p && i < subtreeEnd), "wrong subtree end");
+		}
+	}
+	succeed_if(ks->treeIndex != 0, "tree index not built");
+
+	// parents which are not in the keyset
+	Key *parent = keyNew("user/tree/c", KEY_END);
+	cursor_t end;
+	succeed_if(elektraKsFirstChild(ks, parent, &end) == -1, "keys below missing child found");
+	keySetName(parent, "user/tree/c/deep");
+	cursor_t it = elektraKsFirstChild(ks, parent, &end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/tree/c/deep/1");
+	it = elektraKsNextChild(ks, it, end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/tree/c/deep/2");
+	succeed_if(elektraKsNextChild(ks, it, end) == -1, "too many children");
+	keySetName(parent, "user");
+	it = elektraKsFirstChild(ks, parent, &end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/tree");
+	it = elektraKsNextChild(ks, it, end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/tree\\/x");
+	it = elektraKsNextChild(ks, it, end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/treex");
+	succeed_if(elektraKsNextChild(ks, it, end) == -1, "too many children");
+	keySetName(parent, "dir/tree");
+	succeed_if(elektraKsFirstChild(ks, parent, &end) == -1, "children in other namespace found");
+	keySetName(parent, "/");
+	succeed_if(elektraKsFirstChild(ks, parent, &end) == -1, "root is not supported");
+	succeed_if(elektraKsFirstChild(0, parent, &end) == -1, "no error on null keyset");
+	succeed_if(elektraKsFirstChild(ks, parent, 0) == -1, "no error on null pointer");
+	succeed_if(elektraKsNextChild(ks, ksGetSize(ks), end) == -1, "no error on invalid position");
+	succeed_if(elektraKsSubtreeEnd(ks, -1) == -1, "no error on invalid position");
+
+	// the levels tell how deep a key is
+	const char *names[] = {"user/tree", "user/tree/a", "user/tree/a/x", "user/tree/a/y",
+		"user/tree/a/y/z", "user/tree/b", "user/tree/c/deep/1", "user/tree/c/deep/2",
+		"user/tree/d", "user/tree/d\\/e"};
+	const size_t levels[] = {2, 3, 4, 4, 5, 3, 5, 5, 3, 3};
+	keySetName(parent, "user/tree");
+	cursor_t begin;
+	succeed_if(elektraKsBelow(ks, parent, &begin, &end) == 10, "wrong number of keys below");
+	size_t level = 0;
+	size_t i = 0;
+	Key *cur;
+	for (it=begin; (cur = elektraKsNextInTree(ks, &it, end, &level)) != 0; ++i)
+	{
+		succeed_if(i < 10, "too many keys");
+		if (i >= 10) break;
+		succeed_if_same_string(keyName(cur), names[i]);
+		succeed_if(level == levels[i], "wrong level");
+		if (i == 1) it = elektraKsSubtreeEnd(ks, it-1); // skip below user/tree/a
+		if (i == 1) i = 4;
+	}
+	succeed_if(i == 10, "not all keys iterated");
+
+	// changes drop the index
+	ksAppendKey(ks, keyNew("user/tree/a/w", KEY_END));
+	succeed_if(ks->treeIndex == 0, "tree index not dropped");
+	keySetName(parent, "user/tree/a");
+	it = elektraKsFirstChild(ks, parent, &end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/tree/a/w");
+	elektraKsAppendUnsorted(ks, keyNew("user/tree/a/v", KEY_END));
+	it = elektraKsFirstChild(ks, parent, &end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/tree/a/v");
+	keyDel(ksLookup(ks, parent, KDB_O_POP));
+	it = elektraKsFirstChild(ks, parent, &end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/tree/a/v");
+
+	keyDel(parent);
+	ksDel(ks);
+}
+
+static void test_childrenOwner()
+{
+	printf ("test children with owners\n");
+
+	KeySet *ks = ksNew (20,
+		keyNew("user/a", KEY_END),
+		keyNew("user/a", KEY_OWNER, "o", KEY_END),
+		keyNew("user/a/x", KEY_OWNER, "o", KEY_END),
+		keyNew("user/b", KEY_END),
+		keyNew("user/b", KEY_OWNER, "o", KEY_END),
+		KS_END);
+	succeed_if(ksGetSize(ks) == 5, "keys with other owners missing");
+
+	// every key with another owner is a child, too
+	Key *parent = keyNew("user", KEY_END);
+	cursor_t end;
+	size_t children = 0;
+	for (cursor_t it = elektraKsFirstChild(ks, parent, &end); it != -1;
+		it = elektraKsNextChild(ks, it, end))
+	{
+		succeed_if(keyIsDirectBelow(parent, ksAtCursor(ks, it)) == 1, "not a child");
+		++ children;
+	}
+	succeed_if(children == 4, "keys with other owners skipped");
+
+	// the keys below are below all keys with the same name
+	keySetName(parent, "user/a");
+	cursor_t it = elektraKsFirstChild(ks, parent, &end);
+	succeed_if_same_string(keyName(ksAtCursor(ks, it)), "user/a/x");
+	succeed_if(elektraKsNextChild(ks, it, end) == -1, "too many children");
+	succeed_if(elektraKsSubtreeEnd(ks, 0) == 3, "wrong subtree end");
+	succeed_if(elektraKsSubtreeEnd(ks, 1) == 3, "wrong subtree end");
+
+	keyDel(parent);
+	ksDel(ks);
+}
+
 int main(int argc, char**argv)
 {
 	printf("KS         TESTS\n");
@@ -189,7 +1459,23 @@ int main(int argc, char**argv)
 	test_elektraRenameKeys();
 	test_elektraEmptyKeys();
 	test_cascadingLookup();
+	test_cascadingNamespaces();
+	test_namespaceRanges();
+	test_constLookup();
 	test_creatingLookup();
+	test_hashLookup();
+	test_mergeAppend();
+	test_appendUnsorted();
+	test_arena();
+	test_freeze();
+	test_sortKeys();
+	test_below();
+	test_valueLookup();
+	test_batchLookup();
+	test_stackLookup();
+	test_caseLookup();
+	test_children();
+	test_childrenOwner();
 
 	printf("\ntest_ks RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
@@ -258,6 +258,69 @@ static void test_metaKeySet()
 
 }
 
+static void test_shareMeta()
+{
+	Key *key1 = keyNew("user/test1", KEY_META, "type", "long", KEY_END);
+	Key *key2 = keyNew("user/test2", KEY_META, "type", "long", KEY_END);
+	Key *key3 = keyNew("user/test3", KEY_META, "type", "short",
+			KEY_META, "comment", "long", KEY_END);
+	KeySet *ks = ksNew(5, key1, key2, key3, KS_END);
+
+	succeed_if (keyGetMeta(key1, "type") != keyGetMeta(key2, "type"), "keySetMeta must not share");
+
+	keyRewindMeta(key2);
+	keyNextMeta(key2);
+	succeed_if (elektraKsShareMeta(ks) == 1, "one meta key should be replaced");
+	succeed_if (keyGetMeta(key1, "type") == keyGetMeta(key2, "type"), "equal meta keys should be shared");
+	succeed_if (keyCurrentMeta(key2) == keyGetMeta(key2, "type"), "meta cursor should follow");
+	succeed_if (keyGetRef(keyGetMeta(key1, "type")) == 2, "shared meta key should be referenced by both keys");
+	succeed_if (keyGetMeta(key1, "type") != keyGetMeta(key3, "type"), "different values must not be shared");
+	succeed_if (keyGetMeta(key3, "comment") != keyGetMeta(key1, "type"), "different names must not be shared");
+	succeed_if_same_string (keyString(keyGetMeta(key2, "type")), "long");
+	succeed_if_same_string (keyString(keyGetMeta(key3, "type")), "short");
+
+	succeed_if (elektraKsShareMeta(ks) == 0, "nothing more to share");
+
+	keySetMeta(key2, "type", "short");
+	succeed_if_same_string (keyString(keyGetMeta(key1, "type")), "long");
+	succeed_if (keyGetRef(keyGetMeta(key1, "type")) == 1, "changed meta key should drop its reference");
+
+	succeed_if (elektraKsShareMeta(0) == -1, "null pointer");
+
+	ksDel(ks);
+}
+
+static void test_unshareMeta()
+{
+	Key *key1 = keyNew("user/test1", KEY_META, "type", "long",
+			KEY_META, "comment", "own", KEY_END);
+	Key *key2 = keyDup(key1);
+	KeySet *ks = ksNew(5, key1, KS_END);
+
+	succeed_if (keyGetMeta(key1, "type") == keyGetMeta(key2, "type"), "keyDup should share meta keys");
+
+	keyRewindMeta(key1);
+	keyNextMeta(key1);
+	const Key *comment = keyCurrentMeta(key1);
+	succeed_if (elektraKsUnshareMeta(ks) == 0, "could not unshare meta keys");
+	succeed_if (keyCurrentMeta(key1) != comment, "meta cursor should follow");
+	succeed_if_same_string (keyName(keyCurrentMeta(key1)), "comment");
+	succeed_if (keyGetMeta(key1, "type") != keyGetMeta(key2, "type"), "meta keys should not be shared anymore");
+	succeed_if (keyGetRef(keyGetMeta(key1, "type")) == 1, "unshared meta key should be referenced once");
+	succeed_if (keyGetRef(keyGetMeta(key2, "type")) == 1, "other meta key should be referenced once");
+	succeed_if_same_string (keyString(keyGetMeta(key1, "type")), "long");
+	succeed_if_same_string (keyString(keyGetMeta(key1, "comment")), "own");
+	succeed_if (keySetString((Key*)keyGetMeta(key1, "type"), "short") == -1, "meta keys must stay read only");
+
+	keySetMeta(key2, "type", "short");
+	succeed_if_same_string (keyString(keyGetMeta(key1, "type")), "long");
+
+	succeed_if (elektraKsUnshareMeta(0) == -1, "null pointer");
+
+	keyDel(key2);
+	ksDel(ks);
+}
+
 int main(int argc, char** argv)
 {
 	printf("KEY META     TESTS\n");
@@ -271,6 +334,8 @@ int main(int argc, char** argv)
 	test_owner();
 	test_mode();
 	test_metaKeySet();
+	test_shareMeta();
+	test_unshareMeta();
 
 	printf("\ntest_meta RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 
@@ -0,0 +1,501 @@
+/**
+ * \file
+ *
+ * \brief Tests for running backends in worker threads.
+ *
+ * \copyright BSD License (see doc/COPYING or http://www.libelektra.org)
+ *
+ */
+
+#include <tests_internal.h>
+
+#define NR_OF_BACKENDS 12
+#define NR_OF_KEYS 200
+
+/* what the commit and rollback plugins did, in order */
+static char commitLog[1024];
+
+static int resolverGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned ELEKTRA_UNUSED,
+		Key *parentKey)
+{
+	keySetString(parentKey, keyBaseName(parentKey));
+	return 1;
+}
+
+/* Fails for backends with "getfail" and warns for backends
+ * with "getwarn" in their name */
+static int storageGet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parentKey)
+{
+	char name[64];
+	const char *base = keyBaseName(parentKey);
+
+	ksClear(returned);
+	for (int i=0; i<NR_OF_KEYS; ++i)
+	{
+		snprintf (name, sizeof(name), "%s/key%d", keyName(parentKey), i);
+		ksAppendKey(returned, elektraKsNewKey(returned, name, KEY_VALUE, keyString(parentKey),
+				KEY_META, "order", base,
+				KEY_META, "type", "string", KEY_END));
+	}
+	elektraKsShareMeta(returned);
+
+	if (strstr(base, "getwarn"))
+	{
+		ELEKTRA_ADD_WARNING(12, parentKey, base);
+		ELEKTRA_ADD_WARNING(13, parentKey, base);
+	}
+	if (strstr(base, "getfail"))
+	{
+		ELEKTRA_SET_ERROR(62, parentKey, base);
+		return -1;
+	}
+	return 1;
+}
+
+static int resolverSet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned ELEKTRA_UNUSED,
+		Key *parentKey)
+{
+	char file[64];
+	snprintf (file, sizeof(file), "%s.tmp", keyBaseName(parentKey));
+	keySetString(parentKey, file);
+	return 1;
+}
+
+/* Fails for backends with "setfail" and warns for backends
+ * with "setwarn" in their name.
+ * Runs in worker threads, so problems are reported as errors. */
+static int storageSet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned, Key *parentKey)
+{
+	char file[64];
+	const char *base = keyBaseName(parentKey);
+
+	snprintf (file, sizeof(file), "%s.tmp", base);
+	if (strcmp(keyString(parentKey), file) || ksGetSize(returned) != NR_OF_KEYS)
+	{
+		ELEKTRA_SET_ERROR(62, parentKey, "wrong file or keys");
+		return -1;
+	}
+
+	/* change the metadata and which keys are in the KeySet */
+	Key *cur;
+	ksRewind (returned);
+	while ((cur = ksNext (returned)) != 0)
+	{
+		const Key *comment = keyGetMeta (cur, "comment");
+		if (comment && strcmp(keyString(comment), "shared"))
+		{
+			ELEKTRA_SET_ERROR(62, parentKey, "wrong comment");
+			return -1;
+		}
+		keySetMeta (cur, "comment", 0);
+		keySetMeta (cur, "order", "written");
+	}
+	cur = ksPop (returned);
+	ksAppendKey (returned, cur);
+
+	if (strstr(base, "setwarn"))
+	{
+		ELEKTRA_ADD_WARNING(12, parentKey, base);
+	}
+	if (strstr(base, "setfail"))
+	{
+		ELEKTRA_SET_ERROR(62, parentKey, base);
+		return -1;
+	}
+	return 1;
+}
+
+static int commitSet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned ELEKTRA_UNUSED,
+		Key *parentKey)
+{
+	strcat(commitLog, "commit ");
+	strcat(commitLog, keyBaseName(parentKey));
+	strcat(commitLog, "\n");
+	keySetString(parentKey, keyBaseName(parentKey));
+	return 1;
+}
+
+static int rollbackSet(Plugin *handle ELEKTRA_UNUSED, KeySet *returned ELEKTRA_UNUSED,
+		Key *parentKey)
+{
+	strcat(commitLog, "rollback ");
+	strcat(commitLog, keyBaseName(parentKey));
+	strcat(commitLog, "\n");
+	return 1;
+}
+
+static Plugin *pluginRef(Plugin *plugin)
+{
+	plugin->refcounter = 1;
+	return plugin;
+}
+
+static Backend *backendNew(const char *name)
+{
+	Backend *backend = elektraCalloc (sizeof (Backend));
+	backend->mountpoint = keyNew (name, KEY_VALUE, name, KEY_END);
+	keyIncRef (backend->mountpoint);
+
+	backend->getplugins[0] = pluginRef(elektraPluginExport("resolver", ELEKTRA_PLUGIN_GET, &resolverGet,
+		ELEKTRA_PLUGIN_END));
+	backend->getplugins[1] = pluginRef(elektraPluginExport("storage", ELEKTRA_PLUGIN_GET, &storageGet,
+		ELEKTRA_PLUGIN_END));
+	backend->setplugins[0] = pluginRef(elektraPluginExport("resolver", ELEKTRA_PLUGIN_SET, &resolverSet,
+		ELEKTRA_PLUGIN_END));
+	backend->setplugins[STORAGE_PLUGIN] = pluginRef(elektraPluginExport("storage", ELEKTRA_PLUGIN_SET, &storageSet,
+		ELEKTRA_PLUGIN_END));
+	backend->setplugins[COMMIT_PLUGIN] = pluginRef(elektraPluginExport("resolver", ELEKTRA_PLUGIN_SET, &commitSet,
+		ELEKTRA_PLUGIN_END));
+	backend->errorplugins[0] = pluginRef(elektraPluginExport("resolver", ELEKTRA_PLUGIN_ERROR, &rollbackSet,
+		ELEKTRA_PLUGIN_END));
+	return backend;
+}
+
+/* mounts the backends b0 to b<NR_OF_BACKENDS-1> below
+ * user/tests/parallel, with suffix appended to some of them */
+static KDB *kdbNew(size_t workers, const char *suffix)
+{
+	char name[64];
+	KDB *handle = elektraCalloc (sizeof (struct _KDB));
+	handle->split = elektraSplitNew ();
+	handle->modules = ksNew (0, KS_END);
+	handle->defaultBackend = elektraCalloc (sizeof (Backend));
+	handle->defaultBackend->mountpoint = keyNew ("", KEY_END);
+	keyIncRef (handle->defaultBackend->mountpoint);
+	elektraMountBackend (handle, handle->defaultBackend, 0);
+	++ handle->defaultBackend->refcounter;
+
+	for (int i=0; i<NR_OF_BACKENDS; ++i)
+	{
+		snprintf (name, sizeof(name), "user/tests/parallel/b%d%s", i,
+				i%4 == 1 ? suffix : "");
+		elektraMountBackend (handle, backendNew (name), 0);
+	}
+
+	succeed_if (elektraKdbSetWorkers(handle, workers) == 0, "could not set workers");
+	return handle;
+}
+
+/* the messages are the same, but with other source lines */
+static void compare_messages(Key *parentKey, Key *expectedKey)
+{
+	const Key *meta;
+	keyRewindMeta (expectedKey);
+	keyRewindMeta (parentKey);
+	while ((meta = keyNextMeta (expectedKey)) != 0)
+	{
+		const Key *other = keyNextMeta (parentKey);
+		exit_if_fail (other, "message missing");
+		succeed_if_same_string (keyName(other), keyName(meta));
+		if (!strstr(keyName(meta), "/line"))
+		{
+			succeed_if_same_string (keyString(other), keyString(meta));
+		}
+	}
+	succeed_if (keyNextMeta (parentKey) == 0, "too many messages");
+}
+
+static void test_getParallel()
+{
+	printf ("Test parallel kdbGet\n");
+
+	for (size_t workers=2; workers<=NR_OF_BACKENDS+2; workers+=3)
+	{
+		KDB *sequential = kdbNew (0, "");
+		KDB *parallel = kdbNew (workers, "");
+		Key *parentKey = keyNew ("user/tests/parallel", KEY_END);
+		KeySet *expected = ksNew (0, KS_END);
+		KeySet *ks = ksNew (0, KS_END);
+
+		succeed_if (kdbGet (sequential, expected, parentKey) == 1, "could not get keys");
+		succeed_if (ksGetSize (expected) == NR_OF_BACKENDS*NR_OF_KEYS, "wrong number of keys");
+		succeed_if (kdbGet (parallel, ks, parentKey) == 1, "could not get keys in parallel");
+		compare_keyset (ks, expected);
+
+		Key *found = ksLookupByName (ks, "user/tests/parallel/b7/key5", 0);
+		exit_if_fail (found, "key not found");
+		succeed_if_same_string (keyString(found), "b7");
+		succeed_if_same_string (keyString(keyGetMeta(found, "order")), "b7");
+		succeed_if (!keyGetMeta (parentKey, "warnings"), "there should be no warnings");
+		succeed_if (!keyGetMeta (parentKey, "error"), "there should be no error");
+		succeed_if_same_string (keyName(parentKey), "user/tests/parallel");
+
+		ksDel (ks);
+		ksDel (expected);
+		keyDel (parentKey);
+		kdbClose (parallel, 0);
+		kdbClose (sequential, 0);
+	}
+}
+
+static void test_getParallelSharedMeta()
+{
+	printf ("Test parallel kdbGet with shared meta keys\n");
+
+	KDB *parallel = kdbNew (4, "");
+	Key *parentKey = keyNew ("user/tests/parallel", KEY_END);
+	KeySet *ks = ksNew (0, KS_END);
+
+	succeed_if (kdbGet (parallel, ks, parentKey) == 1, "could not get keys");
+	/* kdbGet does not share meta keys on its own */
+	Key *found = ksLookupByName (ks, "user/tests/parallel/b7/key5", 0);
+	Key *other = ksLookupByName (ks, "user/tests/parallel/b2/key5", 0);
+	exit_if_fail (found && other, "keys not found");
+	succeed_if (keyGetMeta (found, "type") != keyGetMeta (other, "type"), "kdbGet should not share");
+
+	/* the keys of every backend share type and order */
+	succeed_if (elektraKsShareMeta (ks) == (NR_OF_BACKENDS-1)*NR_OF_KEYS,
+			"type should be shared across backends");
+	succeed_if (keyGetMeta (found, "type") == keyGetMeta (other, "type"), "meta key should be shared");
+
+	/* every backend is read again while the old keys share meta keys */
+	succeed_if (kdbGet (parallel, ks, parentKey) == 1, "could not get keys again");
+	succeed_if (ksGetSize (ks) == NR_OF_BACKENDS*NR_OF_KEYS, "wrong number of keys");
+	found = ksLookupByName (ks, "user/tests/parallel/b7/key5", 0);
+	exit_if_fail (found, "key not found");
+	succeed_if_same_string (keyString(keyGetMeta(found, "type")), "string");
+	succeed_if_same_string (keyString(keyGetMeta(found, "order")), "b7");
+	succeed_if (!keyGetMeta (parentKey, "error"), "there should be no error");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	kdbClose (parallel, 0);
+}
+
+static void test_getArena()
+{
+	printf ("Test kdbGet with arenas\n");
+
+	for (size_t workers=0; workers<=4; workers+=4)
+	{
+		KDB *handle = kdbNew (workers, "");
+		Key *parentKey = keyNew ("user/tests/parallel", KEY_END);
+		KeySet *ks = ksNew (0, KS_END);
+
+		succeed_if (kdbGet (handle, ks, parentKey) == 1, "could not get keys");
+		Key *found = ksLookupByName (ks, "user/tests/parallel/b7/key5", 0);
+		exit_if_fail (found, "key not found");
+		succeed_if (!found->arena, "arenas should only be used on request");
+
+		succeed_if (elektraKdbSetArena (0, 1) == -1, "null handle accepted");
+		succeed_if (elektraKdbSetArena (handle, 1) == 0, "could not enable arenas");
+		ksClear (ks);
+		succeed_if (kdbGet (handle, ks, parentKey) == 1, "could not get keys again");
+		found = ksLookupByName (ks, "user/tests/parallel/b7/key5", 0);
+		exit_if_fail (found, "key not found");
+		succeed_if (found->arena, "key should be in an arena");
+		succeed_if_same_string (keyString(found), "b7");
+
+		/* a kept key keeps its arena alive after the next kdbGet */
+		Key *kept = found;
+		keyIncRef (kept);
+		ksClear (ks);
+		succeed_if (kdbGet (handle, ks, parentKey) == 1, "could not get keys again");
+		succeed_if (ksLookupByName (ks, "user/tests/parallel/b7/key5", 0) != kept,
+				"key should be read again");
+		succeed_if (kept->arena, "key should still be in its arena");
+		succeed_if_same_string (keyName(kept), "user/tests/parallel/b7/key5");
+		succeed_if_same_string (keyString(kept), "b7");
+		succeed_if_same_string (keyString(keyGetMeta(kept, "order")), "b7");
+		keyDecRef (kept);
+		keyDel (kept);
+
+		ksDel (ks);
+		keyDel (parentKey);
+		kdbClose (handle, 0);
+	}
+}
+
+static void test_getParallelMessages(const char *suffix)
+{
+	printf ("Test parallel kdbGet with %s\n", suffix);
+
+	KDB *sequential = kdbNew (0, suffix);
+	KDB *parallel = kdbNew (4, suffix);
+	Key *expectedKey = keyNew ("user/tests/parallel", KEY_END);
+	Key *parentKey = keyNew ("user/tests/parallel", KEY_END);
+	ELEKTRA_ADD_WARNING(14, expectedKey, "before");
+	ELEKTRA_ADD_WARNING(14, parentKey, "before");
+	KeySet *expected = ksNew (0, KS_END);
+	KeySet *ks = ksNew (0, KS_END);
+
+	int ret = kdbGet (sequential, expected, expectedKey);
+	succeed_if (kdbGet (parallel, ks, parentKey) == ret, "parallel kdbGet returned something else");
+	if (ret == 1)
+	{
+		compare_keyset (ks, expected);
+	}
+	else
+	{
+		succeed_if (ksGetSize (ks) == 0, "keys should not be changed on error");
+	}
+
+	compare_messages (parentKey, expectedKey);
+
+	ksDel (ks);
+	ksDel (expected);
+	keyDel (parentKey);
+	keyDel (expectedKey);
+	kdbClose (parallel, 0);
+	kdbClose (sequential, 0);
+}
+
+static void test_getParallelWrap()
+{
+	printf ("Test parallel kdbGet with many warnings\n");
+
+	KDB *parallel = kdbNew (3, "getwarn");
+	Key *parentKey = keyNew ("user/tests/parallel", KEY_END);
+	for (int i=0; i<98; ++i) ELEKTRA_ADD_WARNING(14, parentKey, "before");
+	KeySet *ks = ksNew (0, KS_END);
+
+	succeed_if (kdbGet (parallel, ks, parentKey) == 1, "could not get keys");
+	/* 3 backends with 2 warnings each, numbered from 98 */
+	succeed_if_same_string (keyString(keyGetMeta(parentKey, "warnings")), "03");
+	succeed_if_same_string (keyString(keyGetMeta(parentKey, "warnings/#99/reason")), "b1getwarn");
+	succeed_if_same_string (keyString(keyGetMeta(parentKey, "warnings/#00/reason")), "b5getwarn");
+	succeed_if_same_string (keyString(keyGetMeta(parentKey, "warnings/#03/reason")), "b9getwarn");
+	succeed_if_same_string (keyString(keyGetMeta(parentKey, "warnings/#03/number")), "13");
+
+	ksDel (ks);
+	keyDel (parentKey);
+	kdbClose (parallel, 0);
+}
+
+/* changes a key in every backend but b3, so that b3 is not written */
+static int setParallel(KDB *handle, Key *parentKey, KeySet *ks)
+{
+	Key *cur;
+	succeed_if (kdbGet (handle, ks, parentKey) == 1, "could not get keys");
+	ksRewind (ks);
+	while ((cur = ksNext (ks)) != 0)
+	{
+		if (!strcmp(keyBaseName(cur), "key7") && !strstr(keyName(cur), "/b3/"))
+		{
+			keySetString (cur, "changed");
+		}
+	}
+
+	commitLog[0] = 0;
+	return kdbSet (handle, ks, parentKey);
+}
+
+static void test_setParallel(const char *suffix)
+{
+	printf ("Test parallel kdbSet with %s\n", suffix);
+
+	for (size_t workers=2; workers<=NR_OF_BACKENDS+2; workers+=4)
+	{
+		KDB *sequential = kdbNew (0, suffix);
+		KDB *parallel = kdbNew (workers, suffix);
+		Key *expectedKey = keyNew ("user/tests/parallel", KEY_END);
+		Key *parentKey = keyNew ("user/tests/parallel", KEY_END);
+		KeySet *expected = ksNew (0, KS_END);
+		KeySet *ks = ksNew (0, KS_END);
+		char expectedLog[sizeof(commitLog)];
+
+		int ret = setParallel (sequential, expectedKey, expected);
+		strcpy (expectedLog, commitLog);
+		succeed_if (ret == (strstr(suffix, "setfail") ? -1 : 1), "wrong return value");
+		succeed_if (setParallel (parallel, parentKey, ks) == ret,
+				"parallel kdbSet returned something else");
+
+		/* commit and rollback still happen one after the other */
+		succeed_if_same_string (commitLog, expectedLog);
+		succeed_if (!strstr(commitLog, "b3"), "b3 was not changed");
+		if (ret == 1)
+		{
+			succeed_if (!strncmp(commitLog, "commit b0\n", 10), "b0 not committed first");
+			succeed_if (strstr(commitLog, "commit b11\n"), "b11 not committed");
+		}
+		else
+		{
+			succeed_if (!strncmp(commitLog, "rollback b0\n", 12), "b0 not rolled back first");
+		}
+		compare_keyset (ks, expected);
+		compare_messages (parentKey, expectedKey);
+		succeed_if_same_string (keyName(parentKey), keyName(expectedKey));
+		succeed_if_same_string (keyString(parentKey), keyString(expectedKey));
+
+		ksDel (ks);
+		ksDel (expected);
+		keyDel (parentKey);
+		keyDel (expectedKey);
+		kdbClose (parallel, 0);
+		kdbClose (sequential, 0);
+	}
+}
+
+static void test_setParallelSharedMeta()
+{
+	printf ("Test parallel kdbSet with shared meta keys\n");
+
+	KDB *parallel = kdbNew (4, "");
+	Key *parentKey = keyNew ("user/tests/parallel", KEY_END);
+	Key *source = keyNew ("user/source", KEY_META, "comment", "shared", KEY_END);
+	KeySet *ks = ksNew (0, KS_END);
+	Key *cur;
+
+	succeed_if (kdbGet (parallel, ks, parentKey) == 1, "could not get keys");
+	ksRewind (ks);
+	while ((cur = ksNext (ks)) != 0)
+	{
+		keyCopyMeta (cur, source, "comment");
+		keySetString (cur, "changed");
+	}
+	const Key *shared = keyGetMeta (source, "comment");
+	succeed_if (keyGetRef (shared) == NR_OF_BACKENDS*NR_OF_KEYS+1, "all keys should share the comment");
+	cur = ksLookupByName (ks, "user/tests/parallel/b7/key5", 0);
+	exit_if_fail (cur, "key not found");
+	KeySet *meta = cur->meta;
+	const Key *order = keyGetMeta (cur, "order");
+	keyRewindMeta (cur);
+	succeed_if (keyNextMeta (cur) == shared, "comment should be the first meta key");
+
+	commitLog[0] = 0;
+	succeed_if (kdbSet (parallel, ks, parentKey) == 1, "could not set keys");
+	succeed_if (strstr(commitLog, "commit b3\n"), "b3 not committed");
+	succeed_if (!keyGetMeta (parentKey, "error"), "there should be no error");
+
+	/* the plugins changed the meta keys of their own keys only */
+	succeed_if (keyGetRef (shared) == NR_OF_BACKENDS*NR_OF_KEYS+1, "the comment should still be shared");
+	cur = ksLookupByName (ks, "user/tests/parallel/b7/key5", 0);
+	exit_if_fail (cur, "key not found");
+	succeed_if (cur->meta == meta, "meta keys should not be replaced");
+	succeed_if (keyCurrentMeta (cur) == shared, "meta cursor should not be moved");
+	succeed_if (keyGetMeta (cur, "comment") == shared, "comment should not be changed");
+	succeed_if (keyGetMeta (cur, "order") == order, "order should not be changed");
+	succeed_if_same_string (keyString(order), "b7");
+	succeed_if (shared->flags & KEY_FLAG_RO_VALUE, "comment should still be read only");
+
+	ksDel (ks);
+	keyDel (source);
+	keyDel (parentKey);
+	kdbClose (parallel, 0);
+}
+
+
+int main(int argc, char** argv)
+{
+	printf("PARALLEL     TESTS\n");
+	printf("==================\n\n");
+
+	init (argc, argv);
+
+	test_getParallel();
+	test_getParallelSharedMeta();
+	test_getArena();
+	test_getParallelMessages("getwarn");
+	test_getParallelMessages("getfail");
+	test_getParallelMessages("getwarngetfail");
+	test_getParallelWrap();
+	test_setParallel("");
+	test_setParallel("setwarn");
+	test_setParallel("setfail");
+	test_setParallel("setwarnsetfail");
+	test_setParallelSharedMeta();
+
+	printf("\ntest_parallel RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
+
+	return nbError;
+}
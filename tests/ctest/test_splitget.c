@@ -659,6 +659,97 @@ static void test_merge()
 }
 
 
+static void test_mergeupdated()
+{
+	printf ("Test merge of updated backends\n");
+
+	KDB *handle = elektraCalloc(sizeof(struct _KDB));
+	handle->split = elektraSplitNew();
+	KeySet *modules = modules_config();
+
+	elektraMountOpen(handle, set_realworld(), modules, 0);
+	succeed_if (elektraMountDefault (handle, modules, 0) == 0, "could not mount default backends");
+
+	KeySet *ks = ksNew(20,
+			keyNew("system/groups/g1", KEY_END),
+			keyNew("system/hosts/h1", KEY_END),
+			keyNew("system/other", KEY_END),
+			keyNew("user/sw/apps/app1/default/k1", KEY_END),
+			keyNew("user/sw/apps/app2/k1", KEY_END),
+			keyNew("user/sw/apps/app2/k2", KEY_END),
+			keyNew("user/sw/kde/default/k1", KEY_END),
+			keyNew("user/sw/kde/default/k2", KEY_END),
+			keyNew("user/sw/kde/k1", KEY_END),
+			KS_END);
+	Key *unchanged[] = {
+		ksLookupByName(ks, "system/groups/g1", 0),
+		ksLookupByName(ks, "system/hosts/h1", 0),
+		ksLookupByName(ks, "system/other", 0),
+		ksLookupByName(ks, "user/sw/apps/app1/default/k1", 0),
+		ksLookupByName(ks, "user/sw/kde/k1", 0),
+	};
+
+	Key *parentKey = keyNew("user/sw", KEY_END);
+	Split *split = elektraSplitNew();
+	succeed_if (elektraSplitBuildup (split, handle, parentKey) == 1, "could not buildup");
+
+	/* Simulate that app2 and kde need an update */
+	keySetName (parentKey, "user/sw/apps/app2");
+	ssize_t app2 = elektraSplitSearchBackend(split,
+			elektraMountGetBackend(handle, parentKey), parentKey);
+	keySetName (parentKey, "user/sw/kde/default");
+	ssize_t kde = elektraSplitSearchBackend(split,
+			elektraMountGetBackend(handle, parentKey), parentKey);
+	exit_if_fail (app2 != -1 && kde != -1, "backends not found");
+	set_bit(split->syncbits[app2], SPLIT_FLAG_SYNC);
+	set_bit(split->syncbits[kde], SPLIT_FLAG_SYNC);
+
+	succeed_if (elektraSplitAppoint (split, handle, ks) == 1, "could not appoint keys");
+	succeed_if (ksGetSize(split->keysets[app2]) == 0, "keys of updated backend appointed");
+	succeed_if (ksGetSize(split->keysets[kde]) == 0, "keys of updated backend appointed");
+
+	/* Simulate what the backends read */
+	ksAppendKey(split->keysets[app2], keyNew("user/sw/apps/app2/k2", KEY_END));
+	ksAppendKey(split->keysets[app2], keyNew("user/sw/apps/app2/k3", KEY_END));
+	Key *kdeKey = keyNew("user/sw/kde/default/k1", KEY_VALUE, "new", KEY_END);
+	ksAppendKey(split->keysets[kde], kdeKey);
+
+	succeed_if (elektraSplitMergeUpdated (split, handle, ks) == 1, "could not merge");
+
+	KeySet *expected = ksNew(20,
+			keyNew("system/groups/g1", KEY_END),
+			keyNew("system/hosts/h1", KEY_END),
+			keyNew("system/other", KEY_END),
+			keyNew("user/sw/apps/app1/default/k1", KEY_END),
+			keyNew("user/sw/apps/app2/k2", KEY_END),
+			keyNew("user/sw/apps/app2/k3", KEY_END),
+			keyNew("user/sw/kde/default/k1", KEY_VALUE, "new", KEY_END),
+			keyNew("user/sw/kde/k1", KEY_END),
+			KS_END);
+	compare_keyset(ks, expected);
+
+	for (size_t i=0; i<sizeof(unchanged)/sizeof(unchanged[0]); ++i)
+	{
+		succeed_if (ksLookup(ks, unchanged[i], 0) == unchanged[i],
+				"key of backend without update was replaced");
+	}
+	succeed_if (ksLookupByName(ks, "user/sw/kde/default/k1", 0) == kdeKey,
+			"key of updated backend not in keyset");
+
+	elektraKsFreeze(ks);
+	succeed_if (elektraSplitMergeUpdated (split, handle, ks) == -1, "merged into frozen keyset");
+	succeed_if (elektraSplitMerge (split, ks) == -1, "merged into frozen keyset");
+	compare_keyset(ks, expected);
+
+	ksDel (expected);
+	elektraSplitDel (split);
+	keyDel (parentKey);
+	ksDel (ks);
+	kdbClose (handle, 0);
+	ksDel (modules);
+}
+
+
 static void test_realworld()
 {
 	printf ("Test real world example\n");
@@ -805,6 +896,103 @@ static void test_realworld()
 }
 
 
+static void test_manymountpoints()
+{
+	printf ("Test many mountpoints\n");
+
+	char name[64];
+	Key *parent = 0;
+	KDB *handle = elektraCalloc(sizeof(struct _KDB));
+	handle->split = elektraSplitNew();
+	KeySet *modules = ksNew(0, KS_END);
+	elektraModulesInit(modules, 0);
+
+	KeySet *config = ksNew(0, KS_END);
+	ksAppendKey(config, keyNew("system/elektra/mountpoints", KEY_END));
+	ksAppendKey(config, keyNew("system/elektra/mountpoints/root", KEY_END));
+	ksAppendKey(config, keyNew("system/elektra/mountpoints/root/mountpoint", KEY_VALUE, "/", KEY_END));
+	for (int i=0; i<100; ++i)
+	{
+		snprintf (name, sizeof(name), "system/elektra/mountpoints/app%d", i);
+		ksAppendKey(config, keyNew(name, KEY_END));
+		keyAddBaseName(ksTail(config), "mountpoint");
+		ksAppendKey(config, keyNew(name, KEY_END));
+		snprintf (name, sizeof(name), "user/sw/app%d", i%10 ? i : i+1000);
+		keySetString(ksTail(config), name);
+		keyAddBaseName(ksTail(config), "mountpoint");
+	}
+	elektraMountOpen(handle, config, modules, 0);
+	succeed_if (elektraMountDefault (handle, modules, 0) == 0, "could not mount default backends");
+
+	KeySet *ks = ksNew(0, KS_END);
+	for (int i=0; i<1200; ++i)
+	{
+		snprintf (name, sizeof(name), "user/sw/app%d/key%d", i/10, i%10);
+		ksAppendKey(ks, keyNew(name, KEY_END));
+		snprintf (name, sizeof(name), "user/sw/app%d", i);
+		ksAppendKey(ks, keyNew(name, KEY_END));
+	}
+	ksAppendKey(ks, keyNew("system/elektra/mountpoints", KEY_END));
+	ksAppendKey(ks, keyNew("system/other", KEY_END));
+	ksAppendKey(ks, keyNew("user/sw", KEY_END));
+	ksAppendKey(ks, keyNew("user/sw/app1000/below", KEY_END));
+	ksAppendKey(ks, keyNew("user/sw/app5x", KEY_END));
+
+	Split *split = elektraSplitNew();
+	succeed_if (elektraSplitBuildup (split, handle, parent) == 1, "should need sync");
+	succeed_if (elektraSplitAppoint (split, handle, ks) == 1, "could not appoint keys");
+
+	ssize_t size = 0;
+	for (size_t i=0; i<split->size; ++i)
+	{
+		Key *cur;
+		ksRewind(split->keysets[i]);
+		while ((cur = ksNext(split->keysets[i])) != 0)
+		{
+			Backend *backend = elektraMountGetBackend(handle, cur);
+			if (split->handles[i])
+			{
+				succeed_if (backend == split->handles[i], "key appointed to wrong backend");
+				succeed_if (keyGetNamespace(cur) == keyGetNamespace(split->parents[i]),
+						"key appointed to wrong namespace");
+			}
+			else
+			{
+				succeed_if (elektraSplitSearchBackend(split, backend, cur) == -1,
+						"key appointed to default split");
+			}
+		}
+		size += ksGetSize(split->keysets[i]);
+	}
+	succeed_if (size == ksGetSize(ks), "not all keys were appointed");
+
+	elektraSplitDel (split);
+	split = elektraSplitNew();
+	succeed_if (elektraSplitBuildup (split, handle, parent) == 1, "should need sync");
+	succeed_if (elektraSplitDivide (split, handle, ks) == 1, "should need sync");
+
+	size = 0;
+	for (size_t i=0; i<split->size; ++i)
+	{
+		Key *cur;
+		ksRewind(split->keysets[i]);
+		while ((cur = ksNext(split->keysets[i])) != 0)
+		{
+			succeed_if (elektraMountGetBackend(handle, cur) == split->handles[i],
+					"key divided to wrong backend");
+		}
+		size += ksGetSize(split->keysets[i]);
+	}
+	succeed_if (size == ksGetSize(ks), "not all keys were divided");
+
+	elektraSplitDel (split);
+	ksDel (ks);
+
+	kdbClose (handle, parent);
+	elektraModulesClose(modules, 0);
+	ksDel (modules);
+}
+
 
 int main(int argc, char** argv)
 {
@@ -820,7 +1008,9 @@ int main(int argc, char** argv)
 	test_sizes();
 	test_triesizes();
 	test_merge();
+	test_mergeupdated();
 	test_realworld();
+	test_manymountpoints();
 
 
 	printf("\ntest_splitget RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
@@ -103,15 +103,18 @@ static void test_simple()
 
 static void collect_mountpoints(Trie *trie, KeySet *mountpoints)
 {
-	int i;
-	for (i=0; i<KDB_MAX_UCHAR; ++i)
+	size_t i;
+	for (i=0; i<trie->size; ++i)
 	{
-		if (trie->value[i]) ksAppendKey(mountpoints, ((Backend*) trie->value[i])->mountpoint);
-		if (trie->children[i]) collect_mountpoints(trie->children[i], mountpoints);
+		collect_mountpoints(trie->children[i], mountpoints);
 	}
-	if (trie->empty_value)
+	for (i=0; i<trie->nrShadowed; ++i)
 	{
-		ksAppendKey(mountpoints, ((Backend*) trie->empty_value)->mountpoint);
+		ksAppendKey(mountpoints, trie->shadowed[i]->mountpoint);
+	}
+	if (trie->value)
+	{
+		ksAppendKey(mountpoints, ((Backend*) trie->value)->mountpoint);
 	}
 }
 
@@ -775,19 +778,68 @@ static void test_double()
 
 	// output_trie (trie);
 
-	/* ... gets lost
-
 	Trie *t3 = test_insert (trie, "user/tests/simple", "t3");
 	succeed_if (t3, "could not insert into trie");
 	succeed_if (t3 == trie, "should be not the same");
 
 	// output_trie (trie);
 
-	*/
+	Key *searchKey = keyNew("user/tests/simple/below", KEY_END);
+	Backend *backend = elektraTrieLookup(trie, searchKey);
+	succeed_if (backend, "there should be a backend");
+	succeed_if_same_string (keyString(backend->mountpoint), "t3");
+	keyDel (searchKey);
 
 	elektraTrieClose(trie, 0);
 }
 
+static void test_many()
+{
+	printf ("Test many mountpoints in trie\n");
+
+	char name[64];
+	Trie *trie = test_insert (0, "", "root");
+	for (int i=0; i<1000; ++i)
+	{
+		snprintf (name, sizeof(name), "user/tests/app%d/", i);
+		trie = test_insert (trie, name, name);
+	}
+	exit_if_fail (trie, "trie was not build up successfully");
+
+	Key *searchKey = keyNew("user", KEY_END);
+	Backend *backend = 0;
+	for (int i=0; i<1000; ++i)
+	{
+		snprintf (name, sizeof(name), "user/tests/app%d/", i);
+		keySetName(searchKey, name);
+		backend = elektraTrieLookup(trie, searchKey);
+		succeed_if (backend, "there should be a backend");
+		succeed_if_same_string (keyString(backend->mountpoint), name);
+
+		keyAddBaseName(searchKey, "below");
+		succeed_if (elektraTrieLookup(trie, searchKey) == backend,
+				"should be same backend");
+	}
+
+	keySetName(searchKey, "user/tests/app1000");
+	backend = elektraTrieLookup(trie, searchKey);
+	succeed_if_same_string (keyString(backend->mountpoint), "root");
+
+	keySetName(searchKey, "user/tests/app12x/below");
+	backend = elektraTrieLookup(trie, searchKey);
+	succeed_if_same_string (keyString(backend->mountpoint), "root");
+
+	keySetName(searchKey, "user/tests");
+	backend = elektraTrieLookup(trie, searchKey);
+	succeed_if_same_string (keyString(backend->mountpoint), "root");
+
+	succeed_if (trie->size == 1, "root should have one child");
+	succeed_if_same_string (trie->children[0]->text, "user/tests/app");
+
+	elektraTrieClose(trie, 0);
+	keyDel (searchKey);
+}
+
 static void test_emptyvalues()
 {
 	printf ("Test empty values in trie\n");
@@ -825,6 +877,7 @@ int main(int argc, char** argv)
 	test_root();
 	test_double();
 	test_emptyvalues();
+	test_many();
 
 	printf("\ntest_trie RESULTS: %d test(s) done. %d error(s).\n", nbTest, nbError);
 